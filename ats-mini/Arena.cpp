@@ -0,0 +1,167 @@
+#include "Common.h"
+#include "Arena.h"
+#include "Bank.h"
+#include "Remote.h"
+#include "Draw.h"
+#include "Ble.h"
+#include "Heap.h"
+#include <atomic>
+
+//
+// PSRAM arena. A single PSRAM allocation is split into named regions,
+// so large buffers stay off the internal heap, which is left to WiFi
+// and Bluetooth. Each region has space for long-lived buffers, handed
+// out once by arenaAlloc() and never freed, and a pool of fixed size
+// blocks for short-lived buffers, taken by arenaGet() and returned by
+// arenaPut(). Requests that do not fit go to the heap and are counted,
+// so a region that is too small shows up in the stats.
+//
+
+#define ARENA_ROUND(n) (((n) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+typedef struct
+{
+  const char *name;   // Region name
+  uint32_t size;      // Space for long-lived buffers (bytes)
+  uint16_t blockSize; // Pool block size (bytes)
+  uint8_t  blocks;    // Number of pool blocks, up to 32
+} ArenaConfig;
+
+static const ArenaConfig config[ARENA_REGIONS] =
+{
+  { "display", 4096 + MIRROR_BUF_SIZE + DRAW_LOGS_SIZE, 0, 0 },
+  { "scan",    1024, 0, 0 },
+  { "index",   ARENA_ROUND(BANK_CHANNELS * sizeof(Channel)) + 2 * ARENA_ROUND(BANK_CHANNELS * sizeof(uint16_t)), 0, 0 },
+  { "net",     BLE_TX_SIZE, 512, 8 },
+  { "web",     0, WEB_PAGE_SIZE, WEB_PAGES },
+};
+
+typedef struct
+{
+  uint8_t *base;                 // Long-lived buffers
+  uint8_t *pool;                 // Pool blocks, right after long-lived buffers
+  std::atomic<uint32_t> free;    // Free pool blocks, one bit per block
+  ArenaStats stats;
+} ArenaRegion;
+
+static ArenaRegion regions[ARENA_REGIONS];
+
+//
+// Allocate the arena in PSRAM, call this from setup() before anything
+// else allocates from it. Returns FALSE if there is not enough PSRAM,
+// all requests then go to the heap.
+//
+bool arenaInit()
+{
+  size_t total = 0;
+
+  for(uint8_t i = 0 ; i < ARENA_REGIONS ; i++)
+  {
+    regions[i].stats.name      = config[i].name;
+    regions[i].stats.blockSize = config[i].blockSize;
+    total += ARENA_ROUND(config[i].size) + ARENA_ROUND(config[i].blockSize) * config[i].blocks;
+  }
+
+  uint8_t *mem = (uint8_t *)ps_malloc(total + ARENA_ALIGN);
+  if(!mem) return(false);
+
+  mem = (uint8_t *)ARENA_ROUND((uintptr_t)mem);
+  memset(mem, 0, total);
+
+  for(uint8_t i = 0 ; i < ARENA_REGIONS ; i++)
+  {
+    regions[i].base         = mem;
+    regions[i].pool         = mem + ARENA_ROUND(config[i].size);
+    regions[i].free         = config[i].blocks < 32? (1UL << config[i].blocks) - 1 : ~0UL;
+    regions[i].stats.size   = ARENA_ROUND(config[i].size);
+    regions[i].stats.blocks = config[i].blocks;
+    mem = regions[i].pool + ARENA_ROUND(config[i].blockSize) * config[i].blocks;
+  }
+
+  return(true);
+}
+
+//
+// Allocate a zeroed long-lived buffer from a region. These buffers are
+// never freed, only call this from setup() or the main loop.
+//
+void *arenaAlloc(uint8_t region, size_t size)
+{
+  if(region >= ARENA_REGIONS) return(NULL);
+
+  ArenaStats *stats = &regions[region].stats;
+  size = ARENA_ROUND(size);
+
+  if(stats->used + size > stats->size)
+  {
+    stats->fallbacks++;
+    heapCount(HEAP_ARENA, size);
+    return(calloc(1, size));
+  }
+
+  void *result = regions[region].base + stats->used;
+  stats->used += size;
+  return(result);
+}
+
+//
+// Take a pool block of at least size bytes from a region, may be called
+// from any task. Return it with arenaPut().
+//
+void *arenaGet(uint8_t region, size_t size)
+{
+  if(region >= ARENA_REGIONS) return(NULL);
+
+  ArenaRegion *r = &regions[region];
+  uint32_t bits = r->free.load();
+
+  // Take the lowest free block, retrying if another task took it first
+  while(size <= r->stats.blockSize && bits)
+  {
+    uint32_t bit = bits & -bits;
+
+    if(r->free.compare_exchange_weak(bits, bits & ~bit))
+    {
+      uint8_t inUse = r->stats.blocks - __builtin_popcount(bits & ~bit);
+      uint8_t peak = __atomic_load_n(&r->stats.peak, __ATOMIC_RELAXED);
+
+      // Raise the peak, unless another task has raised it past this
+      while(inUse > peak && !__atomic_compare_exchange_n(&r->stats.peak, &peak, inUse, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+      return(r->pool + __builtin_ctz(bit) * ARENA_ROUND(r->stats.blockSize));
+    }
+  }
+
+  __atomic_fetch_add(&r->stats.fallbacks, 1, __ATOMIC_RELAXED);
+  heapCount(HEAP_ARENA, size);
+  return(malloc(size));
+}
+
+//
+// Return a buffer taken by arenaGet()
+//
+void arenaPut(void *ptr)
+{
+  if(!ptr) return;
+
+  for(ArenaRegion &r : regions)
+  {
+    size_t blockSize = ARENA_ROUND(r.stats.blockSize);
+
+    if(r.pool && (uint8_t *)ptr >= r.pool && (uint8_t *)ptr < r.pool + blockSize * r.stats.blocks)
+    {
+      r.free.fetch_or(1UL << (((uint8_t *)ptr - r.pool) / blockSize));
+      return;
+    }
+  }
+
+  free(ptr);
+}
+
+const ArenaStats *arenaGetStats(uint8_t region)
+{
+  if(region >= ARENA_REGIONS) return(NULL);
+
+  ArenaStats *stats = &regions[region].stats;
+  stats->inUse = stats->blocks - __builtin_popcount(regions[region].free.load());
+  return(stats);
+}
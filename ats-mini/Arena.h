@@ -0,0 +1,35 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Arena regions
+#define ARENA_DISPLAY  0  // Display buffers (bitmaps, screen capture)
+#define ARENA_SCAN     1  // Band scan history
+#define ARENA_INDEX    2  // Memory bank channels and their indexes
+#define ARENA_NET      3  // Network and Bluetooth buffers
+#define ARENA_WEB      4  // Web pages being built and sent
+#define ARENA_REGIONS  5
+
+#define ARENA_ALIGN   16  // Allocation alignment (bytes)
+
+typedef struct
+{
+  const char *name;   // Region name
+  uint32_t size;      // Space for long-lived buffers (bytes)
+  uint32_t used;      // Space taken by long-lived buffers (bytes)
+  uint16_t blockSize; // Pool block size (bytes)
+  uint8_t  blocks;    // Number of pool blocks
+  uint8_t  inUse;     // Pool blocks currently in use
+  uint8_t  peak;      // Most pool blocks ever in use at once
+  uint32_t fallbacks; // Requests that did not fit and went to the heap
+} ArenaStats;
+
+bool arenaInit();
+void *arenaAlloc(uint8_t region, size_t size);
+void *arenaGet(uint8_t region, size_t size);
+void arenaPut(void *ptr);
+const ArenaStats *arenaGetStats(uint8_t region);
+
+#endif // ARENA_H
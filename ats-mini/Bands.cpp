@@ -0,0 +1,180 @@
+#include "Common.h"
+#include "Utils.h"
+#include "Menu.h"
+#include "Bands.h"
+#include "Disk.h"
+#include "esp_rom_crc.h"
+
+//
+// Band store. Current frequency (Hz, SSB BFO included), mode, step,
+// bandwidth and calibration of all bands are packed into an array of
+// BANDS_MAX records. Storage saves the array as a preferences section,
+// in the settings journal along with the other preferences, so a save
+// of bands, memories and settings is committed as a whole, and only the
+// chunks holding changed bands are written. BANDS_PATH is the store as
+// kept by earlier firmware, it is only read until bands get saved.
+//
+// Extra bands can be defined in BANDS_USER_PATH, one per line:
+//
+//   NAME,TYPE,MODE,MIN,MAX[,FREQ]
+//
+// TYPE is FM, MW, SW or LW, MODE is FM, LSB, USB or AM, and all
+// frequencies are in kHz. Lines starting with # are comments.
+//
+
+#define BANDS_MAGIC   0x53444E42  // "BNDS"
+
+typedef struct
+{
+  uint32_t magic;     // BANDS_MAGIC
+  uint16_t version;   // BANDS_VERSION
+  uint16_t count;     // Number of records that follow
+  uint32_t crc;       // CRC32 of the records
+} BandsHeader;
+
+static const char *bandTypes[] = { "FM", "MW", "SW", "LW" };
+
+static char userNames[BANDS_MAX][BANDS_NAME_LEN];
+
+static void bandToRecord(const Band *band, BandRecord *record)
+{
+  memset(record, 0, sizeof(*record));
+  record->freq      = freqToHz(band->currentFreq, band->bandMode) + band->currentBFO;
+  record->mode      = band->bandMode;
+  record->step      = band->currentStepIdx;
+  record->bandwidth = band->bandwidthIdx;
+  record->usbCal    = band->usbCal;
+  record->lsbCal    = band->lsbCal;
+}
+
+//
+// Apply a saved record to a band, unless band limits have changed
+// since it was saved
+//
+static bool recordToBand(const BandRecord *record, Band *band)
+{
+  uint16_t freq = freqFromHz(record->freq, record->mode);
+
+  if(record->mode > AM || (record->mode == FM) != (band->bandMode == FM)) return(false);
+  if(freq < band->minimumFreq || freq > band->maximumFreq) return(false);
+
+  band->currentFreq    = freq;
+  band->currentBFO     = record->mode == FM? 0 : bfoFromHz(record->freq);
+  band->bandMode       = record->mode;
+  band->currentStepIdx = record->step;
+  band->bandwidthIdx   = record->bandwidth;
+  band->usbCal         = record->usbCal;
+  band->lsbCal         = record->lsbCal;
+  return(true);
+}
+
+static int findName(const char **names, int count, const char *name)
+{
+  for(int i = 0 ; i < count ; i++)
+    if(!strcasecmp(names[i], name)) return(i);
+
+  return(-1);
+}
+
+//
+// Add user bands after the built-in ones, call this before loading
+// settings, so the saved band index can point to a user band. Returns
+// the number of bands added.
+//
+int bandsLoadUser()
+{
+  static char buf[BANDS_USER_SIZE + 1];
+  char *save;
+  int added = 0;
+
+  buf[diskRead(BANDS_USER_PATH, 0, buf, BANDS_USER_SIZE)] = '\0';
+
+  for(char *line = strtok_r(buf, "\r\n", &save) ; line ; line = strtok_r(NULL, "\r\n", &save))
+  {
+    char name[BANDS_NAME_LEN], type[4], mode[4];
+    unsigned int minFreq, maxFreq, freq = 0;
+
+    // Skip comments and malformed lines
+    if(*line == '#') continue;
+    if(sscanf(line, " %7[^, ] , %3[^, ] , %3[^, ] , %u , %u , %u", name, type, mode, &minFreq, &maxFreq, &freq) < 5)
+      continue;
+
+    int typeIdx = findName(bandTypes, ITEM_COUNT(bandTypes), type);
+    int modeIdx = findName(bandModeDesc, getTotalModes(), mode);
+    if(typeIdx < 0 || modeIdx < 0 || (typeIdx == FM_BAND_TYPE) != (modeIdx == FM)) continue;
+
+    // FM bands are kept in 10kHz units
+    if(modeIdx == FM)
+    {
+      minFreq /= 10;
+      maxFreq /= 10;
+      freq /= 10;
+    }
+
+    if(!minFreq || minFreq >= maxFreq || maxFreq > 0xFFFF) continue;
+    if(freq < minFreq || freq > maxFreq) freq = minFreq;
+
+    // Names have to stay around, keep them along with the bands
+    if(getTotalBands() >= BANDS_MAX) break;
+    char *bandName = userNames[getTotalBands()];
+    strcpy(bandName, name);
+    if(!addBand(bandName, typeIdx, modeIdx, minFreq, maxFreq, freq)) break;
+    added++;
+  }
+
+  return(added);
+}
+
+//
+// Pack all bands into BANDS_MAX records, past the last band they are
+// cleared, so records only change along with the bands
+//
+void bandsPack(BandRecord *records)
+{
+  memset(records, 0, BANDS_MAX * sizeof(BandRecord));
+
+  for(int i = 0 ; i < getTotalBands() ; i++)
+    bandToRecord(&bands[i], &records[i]);
+}
+
+//
+// Apply saved records to all bands, or only to the current one. Records
+// not matching their band, after user bands have changed, are skipped.
+//
+void bandsUnpack(const BandRecord *records, uint16_t count, bool all)
+{
+  for(int i = 0 ; i < min((int)count, getTotalBands()) ; i++)
+    if(all || i == bandIdx) recordToBand(&records[i], &bands[i]);
+}
+
+//
+// Load all bands, or only the current one, from the store left by
+// earlier firmware. Returns FALSE if there is no valid store.
+//
+bool bandsLoadFile(bool all)
+{
+  static uint8_t buf[sizeof(BandsHeader) + BANDS_MAX * sizeof(BandRecord)];
+  const BandsHeader *header = (const BandsHeader *)buf;
+  const BandRecord *records = (const BandRecord *)(buf + sizeof(BandsHeader));
+
+  // The whole store in one read
+  size_t size = diskRead(BANDS_PATH, 0, buf, sizeof(buf));
+
+  if(size < sizeof(BandsHeader) || header->magic != BANDS_MAGIC || header->version != BANDS_VERSION)
+    return(false);
+  if(header->count > BANDS_MAX || size != sizeof(BandsHeader) + header->count * sizeof(BandRecord))
+    return(false);
+  if(header->crc != esp_rom_crc32_le(0, (const uint8_t *)records, header->count * sizeof(BandRecord)))
+    return(false);
+
+  bandsUnpack(records, header->count, all);
+  return(true);
+}
+
+//
+// Remove the store left by earlier firmware
+//
+void bandsClear()
+{
+  diskRemove(BANDS_PATH);
+}
@@ -0,0 +1,29 @@
+#ifndef BANDS_H
+#define BANDS_H
+
+#include <stdint.h>
+
+#define BANDS_PATH       "/bands.bin"  // Band store of earlier firmware
+#define BANDS_USER_PATH  "/bands.txt"
+#define BANDS_MAX          40  // Maximal number of bands, built-in and user ones
+#define BANDS_USER_SIZE  2048  // Maximal user bands file size (bytes)
+#define BANDS_NAME_LEN      8  // User band name length, with terminator
+#define BANDS_VERSION       1  // Band record layout version
+
+typedef struct __attribute__((packed))
+{
+  uint32_t freq;      // Current frequency, BFO included (Hz)
+  uint8_t  mode;      // Band mode (FM, AM, LSB, or USB)
+  int8_t   step;      // Current frequency step
+  int8_t   bandwidth; // Index of the table bandwidthFM, bandwidthAM or bandwidthSSB
+  int16_t  usbCal;    // USB calibration value
+  int16_t  lsbCal;    // LSB calibration value
+} BandRecord;
+
+int bandsLoadUser();
+void bandsPack(BandRecord *records);
+void bandsUnpack(const BandRecord *records, uint16_t count, bool all);
+bool bandsLoadFile(bool all);
+void bandsClear();
+
+#endif // BANDS_H
@@ -0,0 +1,433 @@
+#include "Common.h"
+#include "Utils.h"
+#include "Menu.h"
+#include "Bank.h"
+#include "Scheduler.h"
+#include "Disk.h"
+#include "Arena.h"
+#include <algorithm>
+#include <atomic>
+#include "esp_rom_crc.h"
+
+//
+// Memory bank. Channels are kept in PSRAM, with two indexes sorted by
+// frequency and by name, so lookups, next/previous and range queries
+// are binary searches. The first MEMORY_COUNT channels mirror the
+// memory slots and form group 0, they are still saved with the other
+// preferences. All other channels are saved to BANK_PATH on LittleFS.
+//
+
+#define BANK_MAGIC    0x4B4E4142  // "BANK"
+#define BANK_VERSION  1
+
+typedef struct
+{
+  uint32_t magic;                             // BANK_MAGIC
+  uint16_t version;                           // BANK_VERSION
+  uint16_t count;                             // Number of channels that follow
+  char     groups[BANK_GROUPS][BANK_NAME_LEN];
+  char     tags[BANK_TAGS][BANK_NAME_LEN];
+  uint32_t crc;                               // CRC32 of the channels
+} BankHeader;
+
+static Channel *channels = NULL;      // All channels, memories first
+static uint16_t *byFreq = NULL;       // Non-empty channels by frequency
+static uint16_t *byName = NULL;       // Non-empty channels by name
+static uint16_t channelCount = 0;     // Channels in use
+static uint16_t indexCount = 0;       // Channels in the indexes
+
+// Set once the bank has been loaded by bankLoad()
+static std::atomic<bool> ready(false);
+
+static char groupNames[BANK_GROUPS][BANK_NAME_LEN] = { "Memory" };
+static char tagNames[BANK_TAGS][BANK_NAME_LEN];
+
+static uint8_t saveJob = SCHED_MAX_JOBS;
+
+static int compareFreq(const Channel *a, const Channel *b)
+{
+  if(a->freq != b->freq) return(a->freq < b->freq? -1 : 1);
+  return(strncasecmp(a->name, b->name, sizeof(a->name)));
+}
+
+static int compareName(const Channel *a, const Channel *b)
+{
+  int result = strncasecmp(a->name, b->name, sizeof(a->name));
+  if(result) return(result);
+  return(a->freq < b->freq? -1 : a->freq > b->freq? 1 : 0);
+}
+
+//
+// Rebuild both indexes from scratch
+//
+static void bankIndex()
+{
+  indexCount = 0;
+  for(uint16_t i = 0 ; i < channelCount ; i++)
+    if(channels[i].freq) byFreq[indexCount++] = i;
+
+  memcpy(byName, byFreq, indexCount * sizeof(uint16_t));
+
+  std::sort(byFreq, byFreq + indexCount, [](uint16_t a, uint16_t b) {
+    return(compareFreq(&channels[a], &channels[b]) < 0);
+  });
+  std::sort(byName, byName + indexCount, [](uint16_t a, uint16_t b) {
+    return(compareName(&channels[a], &channels[b]) < 0);
+  });
+}
+
+//
+// Insert a new channel into a sorted index
+//
+static void bankInsert(uint16_t *index, uint16_t idx, int (*compare)(const Channel *, const Channel *))
+{
+  uint16_t *pos = std::lower_bound(index, index + indexCount, idx, [compare](uint16_t a, uint16_t b) {
+    return(compare(&channels[a], &channels[b]) < 0);
+  });
+
+  memmove(pos + 1, pos, (index + indexCount - pos) * sizeof(uint16_t));
+  *pos = idx;
+}
+
+//
+// Write all channels except memories to LittleFS
+//
+static bool bankSave()
+{
+  BankHeader header;
+  const Channel *data = channels + MEMORY_COUNT;
+  uint16_t count = channelCount - MEMORY_COUNT;
+
+  memset(&header, 0, sizeof(header));
+  header.magic   = BANK_MAGIC;
+  header.version = BANK_VERSION;
+  header.count   = count;
+  header.crc     = esp_rom_crc32_le(0, (const uint8_t *)data, count * sizeof(Channel));
+  memcpy(header.groups, groupNames, sizeof(header.groups));
+  memcpy(header.tags, tagNames, sizeof(header.tags));
+
+  fs::File file = diskOpen(BANK_TEMP_PATH, "wb");
+  if(!file) return(false);
+
+  bool result =
+    file.write((const uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+    file.write((const uint8_t *)data, count * sizeof(Channel)) == count * sizeof(Channel);
+
+  file.close();
+
+  // Replace the bank only if the new one has been fully written
+  if(result)
+  {
+    diskRemove(BANK_PATH);
+    result = diskRename(BANK_TEMP_PATH, BANK_PATH);
+  }
+  else diskRemove(BANK_TEMP_PATH);
+
+  return(result);
+}
+
+//
+// Read channels saved to LittleFS, returns FALSE if there are none
+//
+static bool bankRead()
+{
+  BankHeader header;
+
+  fs::File file = diskOpen(BANK_PATH, "rb");
+  if(!file) return(false);
+
+  Channel *data = channels + MEMORY_COUNT;
+  bool result =
+    file.read((uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+    header.magic == BANK_MAGIC && header.version == BANK_VERSION &&
+    header.count <= BANK_CHANNELS - MEMORY_COUNT &&
+    file.read((uint8_t *)data, header.count * sizeof(Channel)) == header.count * sizeof(Channel) &&
+    header.crc == esp_rom_crc32_le(0, (const uint8_t *)data, header.count * sizeof(Channel));
+
+  file.close();
+  if(!result) return(false);
+
+  // Group 0 always holds the memories
+  memcpy(groupNames[1], header.groups[1], sizeof(groupNames) - sizeof(groupNames[0]));
+  memcpy(tagNames, header.tags, sizeof(tagNames));
+  for(uint8_t i = 0 ; i < BANK_GROUPS ; i++) groupNames[i][BANK_NAME_LEN - 1] = '\0';
+  for(uint8_t i = 0 ; i < BANK_TAGS ; i++) tagNames[i][BANK_NAME_LEN - 1] = '\0';
+
+  channelCount = MEMORY_COUNT + header.count;
+  return(true);
+}
+
+//
+// Copy memory slots into group 0 and rebuild the indexes
+//
+static void bankCopyMemories()
+{
+  for(uint8_t i = 0 ; i < MEMORY_COUNT ; i++)
+  {
+    Channel *ch = &channels[i];
+
+    memset(ch, 0, sizeof(*ch));
+    ch->freq = memories[i].freq;
+    ch->mode = memories[i].mode;
+    memcpy(ch->name, memories[i].name, min(sizeof(ch->name) - 1, sizeof(memories[i].name)));
+  }
+
+  bankIndex();
+}
+
+//
+// Allocate the bank in the PSRAM arena, call this from setup()
+//
+bool bankInit()
+{
+  channels = (Channel *)arenaAlloc(ARENA_INDEX, BANK_CHANNELS * sizeof(Channel));
+  byFreq   = (uint16_t *)arenaAlloc(ARENA_INDEX, BANK_CHANNELS * sizeof(uint16_t));
+  byName   = (uint16_t *)arenaAlloc(ARENA_INDEX, BANK_CHANNELS * sizeof(uint16_t));
+
+  if(!channels || !byFreq || !byName)
+  {
+    channels = NULL;
+    return(false);
+  }
+
+  channelCount = MEMORY_COUNT;
+
+  saveJob = schedAdd([]() { bankSave(); return(false); }, 0, false, PROF_PREFS);
+  return(true);
+}
+
+//
+// Load the bank once the memories have been loaded. May run on the boot
+// task, the bank stays unavailable until it is done.
+//
+bool bankLoad()
+{
+  if(!channels) return(false);
+
+  bankRead();
+  bankCopyMemories();
+  ready = true;
+  return(true);
+}
+
+bool bankAvailable()
+{
+  return(ready);
+}
+
+//
+// Update group 0 from memory slots, call this after changing memories
+//
+void bankSyncMemories()
+{
+  if(ready) bankCopyMemories();
+}
+
+//
+// Find a name in a table, adding it if not found and add is TRUE.
+// Returns -1 if not found and not added.
+//
+static int findName(char (*names)[BANK_NAME_LEN], uint8_t count, uint8_t first, const char *name, bool add)
+{
+  int empty = -1;
+
+  if(!*name) return(-1);
+
+  for(uint8_t i = first ; i < count ; i++)
+  {
+    if(!strncasecmp(names[i], name, BANK_NAME_LEN - 1)) return(i);
+    if(!names[i][0] && empty < 0) empty = i;
+  }
+
+  if(!add) return(-1);
+  if(empty >= 0) strncpy(names[empty], name, BANK_NAME_LEN - 1);
+  return(empty);
+}
+
+static uint8_t freeNames(char (*names)[BANK_NAME_LEN], uint8_t count, uint8_t first)
+{
+  uint8_t result = 0;
+
+  for(uint8_t i = first ; i < count ; i++)
+    if(!names[i][0]) result++;
+
+  return(result);
+}
+
+int bankAddGroup(const char *name)
+{
+  // Group 0 is reserved for memories
+  return(findName(groupNames, BANK_GROUPS, 1, name, true));
+}
+
+int bankAddTag(const char *name)
+{
+  return(findName(tagNames, BANK_TAGS, 0, name, true));
+}
+
+int bankFindGroup(const char *name)
+{
+  return(findName(groupNames, BANK_GROUPS, 1, name, false));
+}
+
+int bankFindTag(const char *name)
+{
+  return(findName(tagNames, BANK_TAGS, 0, name, false));
+}
+
+//
+// Returns TRUE if there is room for another channel, along with given
+// number of new group and tag names
+//
+bool bankHasRoom(uint8_t groups, uint8_t tags)
+{
+  return(
+    ready && channelCount < BANK_CHANNELS &&
+    freeNames(groupNames, BANK_GROUPS, 1) >= groups &&
+    freeNames(tagNames, BANK_TAGS, 0) >= tags
+  );
+}
+
+const char *bankGroupName(uint8_t group)
+{
+  return(group < BANK_GROUPS? groupNames[group] : "");
+}
+
+const char *bankTagName(uint8_t tag)
+{
+  return(tag < BANK_TAGS? tagNames[tag] : "");
+}
+
+//
+// Add a channel to a group other than memories
+//
+bool bankAdd(const Channel *channel)
+{
+  if(!ready || channelCount >= BANK_CHANNELS) return(false);
+  if(!channel->freq || !channel->group || channel->group >= BANK_GROUPS) return(false);
+
+  channels[channelCount] = *channel;
+  bankInsert(byFreq, channelCount, compareFreq);
+  bankInsert(byName, channelCount, compareName);
+  channelCount++;
+  indexCount++;
+
+  schedStart(saveJob, BANK_SAVE_TIME);
+  return(true);
+}
+
+//
+// Remove all channels of a group other than memories
+//
+void bankClearGroup(uint8_t group)
+{
+  if(!ready || !group || group >= BANK_GROUPS) return;
+
+  uint16_t count = MEMORY_COUNT;
+  for(uint16_t i = MEMORY_COUNT ; i < channelCount ; i++)
+    if(channels[i].group != group) channels[count++] = channels[i];
+
+  channelCount = count;
+  groupNames[group][0] = '\0';
+  bankIndex();
+
+  schedStart(saveJob, BANK_SAVE_TIME);
+}
+
+//
+// Number of non-empty channels, 0 until the bank is loaded
+//
+uint16_t bankCount()
+{
+  return(ready? indexCount : 0);
+}
+
+//
+// Get channel at given position of given index
+//
+const Channel *bankGet(uint8_t order, uint16_t pos)
+{
+  if(!ready || pos >= indexCount) return(NULL);
+  return(&channels[(order == BANK_BY_NAME? byName : byFreq)[pos]]);
+}
+
+//
+// Find the first position in frequency order with frequency at or above
+// given one. Returns bankCount() if there is none.
+//
+uint16_t bankFindFreq(uint32_t freq)
+{
+  if(!ready) return(0);
+
+  uint16_t *pos = std::lower_bound(byFreq, byFreq + indexCount, freq, [](uint16_t a, uint32_t f) {
+    return(channels[a].freq < f);
+  });
+
+  return(pos - byFreq);
+}
+
+//
+// Find the first position in name order with name at or above given one,
+// so it is the first match if given name is a prefix. Returns bankCount()
+// if there is none.
+//
+uint16_t bankFindName(const char *name)
+{
+  if(!ready) return(0);
+
+  uint16_t *pos = std::lower_bound(byName, byName + indexCount, name, [](uint16_t a, const char *n) {
+    return(strncasecmp(channels[a].name, n, sizeof(channels[a].name)) < 0);
+  });
+
+  return(pos - byName);
+}
+
+//
+// Find the nearest channel above given frequency
+//
+const Channel *bankNext(uint32_t freq, uint8_t group)
+{
+  for(uint16_t pos = bankFindFreq(freq + 1) ; pos < indexCount ; pos++)
+  {
+    const Channel *ch = &channels[byFreq[pos]];
+    if(group == BANK_ANY || ch->group == group) return(ch);
+  }
+
+  return(NULL);
+}
+
+//
+// Find the nearest channel below given frequency
+//
+const Channel *bankPrev(uint32_t freq, uint8_t group)
+{
+  for(uint16_t pos = bankFindFreq(freq) ; pos > 0 ; pos--)
+  {
+    const Channel *ch = &channels[byFreq[pos - 1]];
+    if(group == BANK_ANY || ch->group == group) return(ch);
+  }
+
+  return(NULL);
+}
+
+//
+// Make a memory entry for tuning to given channel, using the current
+// band if it has the channel, or the first band that does otherwise
+//
+bool bankToMemory(const Channel *channel, Memory *memory)
+{
+  memory->freq = channel->freq;
+  memory->mode = channel->mode;
+  memcpy(memory->name, channel->name, sizeof(memory->name));
+
+  memory->band = bandIdx;
+  if(isMemoryInBand(&bands[bandIdx], memory)) return(true);
+
+  for(int i = 0 ; i < getTotalBands() ; i++)
+  {
+    memory->band = i;
+    if(isMemoryInBand(&bands[i], memory)) return(true);
+  }
+
+  return(false);
+}
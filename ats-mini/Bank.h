@@ -0,0 +1,50 @@
+#ifndef BANK_H
+#define BANK_H
+
+#include <stdint.h>
+
+#define BANK_PATH       "/bank.bin"
+#define BANK_TEMP_PATH  "/bank.tmp"
+#define BANK_CHANNELS   4096  // Maximal number of channels, memories included
+#define BANK_GROUPS       16  // Maximal number of groups, group 0 is memories
+#define BANK_TAGS         16  // Maximal number of tags
+#define BANK_NAME_LEN     16  // Group and tag name length, with terminator
+#define BANK_SAVE_TIME  2000  // Save the bank once changes stop for this long (ms)
+
+// Index orders
+#define BANK_BY_FREQ  0 // Sorted by frequency, then name
+#define BANK_BY_NAME  1 // Sorted by name (case insensitive), then frequency
+
+#define BANK_ANY   0xFF // Any group
+
+typedef struct __attribute__((packed))
+{
+  uint32_t freq;          // Frequency (Hz), 0 if empty
+  uint8_t  mode;          // Modulation
+  uint8_t  group;         // Group index
+  uint16_t tags;          // Tag bits
+  char     name[24];      // Name
+} Channel;
+
+bool bankInit();
+bool bankLoad();
+bool bankAvailable();
+void bankSyncMemories();
+int bankAddGroup(const char *name);
+int bankAddTag(const char *name);
+int bankFindGroup(const char *name);
+int bankFindTag(const char *name);
+bool bankHasRoom(uint8_t groups, uint8_t tags);
+const char *bankGroupName(uint8_t group);
+const char *bankTagName(uint8_t tag);
+bool bankAdd(const Channel *channel);
+void bankClearGroup(uint8_t group);
+uint16_t bankCount();
+const Channel *bankGet(uint8_t order, uint16_t pos);
+uint16_t bankFindFreq(uint32_t freq);
+uint16_t bankFindName(const char *name);
+const Channel *bankNext(uint32_t freq, uint8_t group = BANK_ANY);
+const Channel *bankPrev(uint32_t freq, uint8_t group = BANK_ANY);
+bool bankToMemory(const Channel *channel, Memory *memory);
+
+#endif // BANK_H
@@ -1,6 +1,8 @@
 #include "Common.h"
 #include "Themes.h"
 #include "Utils.h"
+#include "Format.h"
+#include "Draw.h"
 
 #define VBAT_MON  4                 // GPIO04 -- Battery Monitor PIN
 
@@ -73,6 +75,8 @@ bool drawBattery(int x, int y)
   // Measure battery voltage and status
   batteryMonitor();
 
+  drawWidget(DRAW_W_BATTERY);
+
   // Set display information
   spr.drawRoundRect(x, y + 1, 28, 14, 3, TH.batt_border);
   spr.drawLine(x + 29, y + 5, x + 29, y + 10, TH.batt_border);
@@ -108,12 +112,18 @@ bool drawBattery(int x, int y)
   }
   else
   {
-    char voltage[8];
+    // Text representation of the voltage, only formatted when it changes
+    static char voltage[8];
+    static int lastCentivolts = -1;
+    int centivolts = (int)(batteryVolts * 100 + 0.5);
     uint16_t color;
     int level;
 
-    // Text representation of the voltage
-    sprintf(voltage, "%.02fV", batteryVolts);
+    if(centivolts != lastCentivolts)
+    {
+      fmtStr(fmtFixed(voltage, centivolts, 2), "V");
+      lastCentivolts = centivolts;
+    }
 
     // Battery bar color and width
     switch(batteryState)
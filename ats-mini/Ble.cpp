@@ -2,6 +2,14 @@
 #include "Themes.h"
 #include "Remote.h"
 #include "Ble.h"
+#include "Input.h"
+#include "Heap.h"
+
+// Set when Bluetooth has to be restarted in the current mode
+static bool initPending = false;
+
+// Job sending queued data
+static uint8_t txJob = SCHED_MAX_JOBS;
 
 //
 // Get current connection status
@@ -27,18 +35,56 @@ void bleInit(uint8_t bleMode)
   bleStop();
 
   if(bleMode == BLE_OFF) return;
+
+  // Keep track of the heap taken by Bluetooth
+  HeapMark mark = heapMark();
   BLESerial.start();
+  heapUsed(HEAP_BLE, &mark);
+}
+
+//
+// Register the job sending queued data, call this from setup()
+//
+void bleQueueInit()
+{
+  txJob = schedAdd([]() {
+    if(!BLESerial.sendQueued(false)) schedStop(txJob);
+    return(false);
+  }, SCHED_BLE_TIME, false, PROF_REMOTE);
+}
+
+//
+// Send queued data, one chunk every SCHED_BLE_TIME until none is left
+//
+void bleTxStart()
+{
+  schedStart(txJob, 0);
+}
+
+//
+// Restart Bluetooth in the current mode. While the boot task is
+// bringing Bluetooth up, the restart waits for bleTickTime().
+//
+void bleRequestInit()
+{
+  initPending = true;
+  if(bootIsDone()) bleTickTime();
 }
 
-int bleDoCommand(Stream* stream, RemoteState* state, uint8_t bleMode)
+void bleTickTime()
 {
-  if(bleMode == BLE_OFF) return 0;
+  if(!initPending) return;
 
-  if (BLEDevice::getServer()->getConnectedCount() > 0) {
-    if (BLESerial.available())
-      return remoteDoCommand(stream, state, BLESerial.read());
-  }
-  return 0;
+  initPending = false;
+  bleInit(bleModeIdx);
+}
+
+void bleDoCommand(Stream* stream, RemoteState* state, uint8_t bleMode)
+{
+  if(bleMode == BLE_OFF) return;
+
+  if (BLEDevice::getServer()->getConnectedCount() > 0)
+    remoteDoCommands(stream, state, INPUT_BLE);
 }
 
 void remoteBLETickTime(Stream* stream, RemoteState* state, uint8_t bleMode)
@@ -9,11 +9,17 @@
 #include <semaphore>
 
 #include "Remote.h"
+#include "Scheduler.h"
+#include "Arena.h"
 
 #define NORDIC_UART_SERVICE_UUID           "6E400001-B5A3-F393-E0A9-E50E24DCCA9E"
 #define NORDIC_UART_CHARACTERISTIC_UUID_RX "6E400002-B5A3-F393-E0A9-E50E24DCCA9E"
 #define NORDIC_UART_CHARACTERISTIC_UUID_TX "6E400003-B5A3-F393-E0A9-E50E24DCCA9E"
 
+#define BLE_TX_SIZE MIRROR_BUF_SIZE // Transmit queue, holds a full mirror update
+
+void bleTxStart();
+
 class NordicUART : public Stream, public BLEServerCallbacks, public BLECharacteristicCallbacks {
 private:
   // BLE components
@@ -30,6 +36,12 @@ private:
   String incomingPacket;
   size_t unreadByteCount = 0;
 
+  // Transmit queue, sent one notification at a time
+  uint8_t *txQueue = nullptr;
+  size_t txHead = 0;
+  size_t txCount = 0;
+  uint32_t txTime = 0;
+
   // Device attributes
   const char *deviceName;
 
@@ -116,6 +128,9 @@ public:
       // Hold data until next read
       incomingPacket = pCharacteristic->getValue();
       unreadByteCount = incomingPacket.length();
+
+      // Let the main loop process it right away
+      schedWake();
     }
   }
 
@@ -162,32 +177,57 @@ public:
   // https://github.com/espressif/esp-nimble/issues/75
   // https://github.com/espressif/esp-nimble/issues/106
   // https://github.com/h2zero/esp-nimble-cpp/issues/347
+  //
+  // Data is queued and sent in chunks of MTU size, one every
+  // SCHED_BLE_TIME, by bleTxStart()'s job, so that writes do not wait
+  // for the chunks to go out. Writes only wait when the queue is full.
   size_t write(const uint8_t *data, size_t size)
   {
-    if (pTxCharacteristic)
+    if (!pTxCharacteristic) return 0;
+
+    if (!txQueue) txQueue = (uint8_t *)arenaAlloc(ARENA_NET, BLE_TX_SIZE);
+    if (!txQueue) return 0;
+
+    size_t remainingByteCount = size;
+    while (remainingByteCount > 0)
     {
-      // Data is sent in chunks of MTU size to avoid data loss
-      // as each chunk is notified separately
-      size_t chunkSize = BLEDevice::getMTU();
-      size_t remainingByteCount = size;
-      while (remainingByteCount >= chunkSize)
-      {
-        delay(20);
-        pTxCharacteristic->setValue(data, chunkSize);
-        pTxCharacteristic->notify();
-        data += chunkSize;
-        remainingByteCount -= chunkSize;
-      }
-      if (remainingByteCount > 0)
-      {
-        delay(20);
-        pTxCharacteristic->setValue(data, remainingByteCount);
-        pTxCharacteristic->notify();
-      }
-      return size;
+      if (txCount == BLE_TX_SIZE) sendQueued(true);
+
+      size_t tail = (txHead + txCount) % BLE_TX_SIZE;
+      size_t count = min(remainingByteCount, min(BLE_TX_SIZE - txCount, BLE_TX_SIZE - tail));
+      memcpy(txQueue + tail, data, count);
+      txCount += count;
+      data += count;
+      remainingByteCount -= count;
     }
-    else
-      return 0;
+
+    bleTxStart();
+    return size;
+  }
+
+  // Send a chunk of queued data, if SCHED_BLE_TIME has passed since
+  // the last one, or after waiting for it. Returns TRUE if there is
+  // more data to send.
+  bool sendQueued(bool wait)
+  {
+    if (!pTxCharacteristic) txCount = 0;
+    if (!txCount) return false;
+
+    uint32_t elapsed = millis() - txTime;
+    if (elapsed < SCHED_BLE_TIME)
+    {
+      if (!wait) return true;
+      delay(SCHED_BLE_TIME - elapsed);
+    }
+
+    // Each chunk is notified separately, to avoid data loss
+    size_t chunkSize = min(txCount, min((size_t)BLEDevice::getMTU(), BLE_TX_SIZE - txHead));
+    pTxCharacteristic->setValue(txQueue + txHead, chunkSize);
+    pTxCharacteristic->notify();
+    txTime = millis();
+    txHead = (txHead + chunkSize) % BLE_TX_SIZE;
+    txCount -= chunkSize;
+    return txCount > 0;
   }
 
   size_t write(uint8_t byte)
@@ -195,6 +235,15 @@ public:
     return write(&byte, 1);
   }
 
+  // Room in the transmit queue. Queued data takes a while to send, so
+  // the queue counts as full until it has drained, and writers that
+  // check first, like the screen mirror, skip updates instead of
+  // building up a backlog.
+  int availableForWrite()
+  {
+    return pTxCharacteristic && !txCount ? BLE_TX_SIZE : 0;
+  }
+
   size_t print(std::string str)
   {
     return write((const uint8_t *)str.data(), str.length());
@@ -213,7 +262,8 @@ public:
     }
     else if (requiredSize > 0)
     {
-      char *buffer = (char *)malloc(requiredSize + 1);
+      // Short-lived, keep it off the heap
+      char *buffer = (char *)arenaGet(ARENA_NET, requiredSize + 1);
       if (buffer)
       {
         va_start(args, format);
@@ -222,10 +272,10 @@ public:
         if ((result >= 0) && (result <= requiredSize))
         {
           size_t writtenBytesCount = write((uint8_t *)buffer, result + 1);
-          free(buffer);
+          arenaPut(buffer);
           return writtenBytesCount;
         }
-        free(buffer);
+        arenaPut(buffer);
       }
     }
     return 0;
@@ -233,10 +283,13 @@ public:
 };
 
 void bleInit(uint8_t bleMode);
+void bleQueueInit();
 void bleStop();
+void bleRequestInit();
+void bleTickTime();
 int8_t getBleStatus();
 void remoteBLETickTime(Stream* stream, RemoteState* state, uint8_t bleMode);
-int bleDoCommand(Stream* stream, RemoteState* state, uint8_t bleMode);
+void bleDoCommand(Stream* stream, RemoteState* state, uint8_t bleMode);
 extern NordicUART BLESerial;
 
 #endif
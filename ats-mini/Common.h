@@ -2,7 +2,7 @@
 #define COMMON_H
 
 #include <stdint.h>
-#include <TFT_eSPI.h>
+#include "Sprite.h"
 #include <SI4735-fixed.h>
 
 #define RECEIVER_DESC  "ESP32-SI4732 Receiver"
@@ -19,6 +19,11 @@
 #define VER_MEMORIES   71   // Memories version
 #define VER_BANDS      72   // Bands version
 
+// Default settings
+#define DEFAULT_VOLUME      35  // change it for your favorite sound volume
+#define DEFAULT_SLEEP        0  // Default sleep interval, range = 0 (off) to 255 in steps of 5
+#define DEFAULT_BRIGHTNESS 130  // Default display brightness, range = 10 to 255 in steps of 5
+
 // Modes
 #define FM            0
 #define LSB           1
@@ -70,6 +75,10 @@
 #define NET_CONNECT    3 // Connect to a network normally, if possible
 #define NET_SYNC       4 // Connect to sync time, then disconnect
 
+// Web server pages, built and sent from the web arena region
+#define WEB_PAGE_SIZE  32768 // Space for a single page (bytes)
+#define WEB_PAGES          3 // Number of pages being sent at once
+
 // Bluetooth modes
 #define BLE_OFF        0 // Bluetooth is disabled
 #define BLE_ADHOC      1 // Ad hoc BLE serial protocol
@@ -94,6 +103,7 @@ typedef struct
   int8_t bandwidthIdx;    // Index of the table bandwidthFM, bandwidthAM or bandwidthSSB;
   int16_t usbCal;         // USB calibration value
   int16_t lsbCal;         // LSB calibration value
+  int16_t currentBFO;     // Current SSB BFO offset above currentFreq (0..999Hz)
 } Band;
 
 typedef struct __attribute__((packed))
@@ -129,11 +139,10 @@ typedef struct
 //
 
 extern SI4735_fixed rx;
-extern TFT_eSprite spr;
+extern DrawSprite spr;
 extern TFT_eSPI tft;
 
 extern bool pushAndRotate;
-extern bool seekStop;
 extern uint8_t rssi;
 extern uint8_t snr;
 
@@ -174,18 +183,21 @@ extern const int CALMax;
 static inline bool isSSB() { return(currentMode>FM && currentMode<AM); }
 
 void useBand(const Band *band);
+void storeBandFreq(Band *band);
 bool updateBFO(int newBFO, bool wrap = true);
 bool doSeek(int16_t enc);
 bool clickFreq(bool shortPress);
 uint8_t doAbout(int16_t enc);
-bool checkStopSeeking();
+bool bootIsDone();
 
 // Battery.c
 float batteryMonitor();
 bool drawBattery(int x, int y);
 
 // Scan.c
+void scanInit();
 void scanRun(uint16_t centerFreq, uint16_t step);
+bool scanCancel();
 bool scanHasData(void);
 float scanGetRSSI(uint16_t freq);
 float scanGetSNR(uint16_t freq);
@@ -209,12 +221,11 @@ bool ntpIsAvailable();
 bool ntpSyncTime();
 
 void netRequestConnect();
-void netTickTime();
+void netRequestInit();
+bool netTickTime();
 
 // Remote.c
 #define REMOTE_CHANGED   1
-#define REMOTE_CLICK     2
-#define REMOTE_PREFS     4
-#define REMOTE_DIRECTION 8
+#define REMOTE_PREFS     2
 
 #endif // COMMON_H
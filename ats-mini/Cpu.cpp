@@ -0,0 +1,119 @@
+#include "Common.h"
+#include "Utils.h"
+#include "Cpu.h"
+
+//
+// CPU clock governor. Heavy tasks and bursts of UI activity raise the
+// clock for a while, a periodic job drops it back once nobody needs it.
+//
+// Changing the clock glitches the audio (see issue #244), so the clock
+// is not switched on every encoder move. Only sustained UI activity
+// raises it, and it then stays up until the UI has been idle for a
+// long time. All levels keep the APB bus at 80MHz, so I2C, the display
+// bus, PWM and WiFi timings do not change. Only call these functions
+// from the main loop, that way the clock never changes mid-frame, except
+// for cpuGetStats(), which returns a copy taken by cpuTickTime().
+//
+
+static const uint16_t levels[CPU_LEVELS] = { CPU_FREQ_IDLE, CPU_FREQ_UI, CPU_FREQ_MAX };
+
+// Time until which each level is requested
+static uint32_t holdUntil[CPU_LEVELS];
+
+static uint8_t cpuLevel = 0;
+static uint32_t levelTime = 0;
+static CpuStats stats;
+static CpuStats snapshot;
+
+// Input burst detection
+static uint32_t burstStart = 0;
+static uint8_t burstCount = 0;
+
+//
+// Account time spent at the current level
+//
+static void cpuAccount()
+{
+  uint32_t now = millis();
+  stats.time[cpuLevel] += now - levelTime;
+  levelTime = now;
+}
+
+static void cpuSetLevel(uint8_t level)
+{
+  if(level == cpuLevel) return;
+
+  cpuAccount();
+  setCpuFrequencyMhz(levels[level]);
+  cpuLevel = level;
+  stats.switches++;
+}
+
+//
+// Run at least at the given clock for the next hold ms
+//
+void cpuBoost(uint16_t mhz, uint32_t hold)
+{
+  for(int i = CPU_LEVELS - 1 ; i > 0 ; i--)
+  {
+    if(mhz < levels[i]) continue;
+
+    uint32_t until = millis() + hold;
+    if(holdUntil[i] == 0 || (int32_t)(until - holdUntil[i]) > 0) holdUntil[i] = until;
+    if(i > cpuLevel) cpuSetLevel(i);
+    break;
+  }
+}
+
+//
+// Call on each handled input event, raises the clock on bursts of them
+//
+void cpuInput(uint32_t time)
+{
+  if(time - burstStart > CPU_UI_WINDOW)
+  {
+    burstStart = time;
+    burstCount = 0;
+  }
+
+  if(++burstCount >= CPU_UI_BURST) cpuBoost(CPU_FREQ_UI, CPU_UI_HOLD);
+}
+
+//
+// Drop the clock to the highest level still requested
+//
+void cpuTickTime()
+{
+  uint32_t now = millis();
+  uint8_t level = 0;
+
+  for(int i = CPU_LEVELS - 1 ; i > 0 && !level ; i--)
+  {
+    if(!holdUntil[i]) continue;
+
+    if((int32_t)(now - holdUntil[i]) < 0 && !sleepOn())
+      level = i;
+    else
+      holdUntil[i] = 0;
+  }
+
+  if(level < cpuLevel) cpuSetLevel(level);
+
+  // Statistics for other tasks, such as the web server
+  cpuAccount();
+  snapshot = stats;
+}
+
+uint16_t cpuLevelFreq(uint8_t level)
+{
+  return(levels[level < CPU_LEVELS? level : 0]);
+}
+
+//
+// Statistics as of the last cpuTickTime() call, safe to read from any
+// task, though a copy in progress may be off by a tick
+//
+const CpuStats *cpuGetStats()
+{
+  return(&snapshot);
+}
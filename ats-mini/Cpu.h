@@ -0,0 +1,30 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdint.h>
+
+// CPU clock levels (MHz). Below 80MHz the APB bus clock drops as well,
+// breaking I2C, PWM and UART timings, so 80MHz is the floor.
+#define CPU_FREQ_IDLE   80 // Default clock
+#define CPU_FREQ_UI    160 // Bursts of UI activity
+#define CPU_FREQ_MAX   240 // Scans, screen capture, EiBi parsing
+#define CPU_LEVELS       3
+
+#define CPU_TASK_HOLD   2000 // Keep the clock this long after a heavy task (ms)
+#define CPU_UI_HOLD    30000 // Keep the UI clock this long after the last burst (ms)
+#define CPU_UI_WINDOW    500 // Time window for counting input events (ms)
+#define CPU_UI_BURST       8 // Input events within CPU_UI_WINDOW making a burst
+
+typedef struct
+{
+  uint32_t time[CPU_LEVELS]; // Time spent at each clock level (ms)
+  uint32_t switches;         // Number of clock changes
+} CpuStats;
+
+void cpuBoost(uint16_t mhz, uint32_t hold = CPU_TASK_HOLD);
+void cpuInput(uint32_t time);
+void cpuTickTime();
+uint16_t cpuLevelFreq(uint8_t level);
+const CpuStats *cpuGetStats();
+
+#endif // CPU_H
@@ -0,0 +1,152 @@
+#include "Common.h"
+#include "Disk.h"
+#include <LittleFS.h>
+
+//
+// File access layer over LittleFS. Existence, size and an open read
+// handle are cached for the last few files looked at, so hot files such
+// as the EiBi schedule are not checked and reopened on every lookup.
+// Reads at the current handle position skip the seek. Writing, removing
+// or renaming a file through this layer drops its cache entry. Cached
+// lookups are only meant for the main loop.
+//
+
+typedef struct
+{
+  char path[DISK_PATH_LEN];  // Cached file, empty if the entry is unused
+  bool exists;               // TRUE if the file exists
+  size_t size;               // File size (bytes)
+  size_t pos;                // Read handle position
+  uint32_t used;             // Last use, the oldest entry is replaced
+  fs::File file;             // Read handle, open if the file exists
+} DiskEntry;
+
+static DiskEntry cache[DISK_CACHE_FILES];
+static uint32_t useCount = 0;
+static DiskStats stats;
+
+static void diskDrop(DiskEntry *entry)
+{
+  if(entry->file) entry->file.close();
+  entry->path[0] = '\0';
+  entry->exists = false;
+  entry->size = 0;
+  entry->pos = 0;
+  entry->used = 0;
+}
+
+//
+// Find the cache entry for a file, filling the least recently used entry
+// if the file is not cached yet. Returns NULL if the path is too long to
+// be cached.
+//
+static DiskEntry *diskLookup(const char *path)
+{
+  DiskEntry *oldest = &cache[0];
+
+  if(strlen(path) >= DISK_PATH_LEN) return(NULL);
+
+  for(DiskEntry &entry : cache)
+  {
+    if(!strcmp(entry.path, path))
+    {
+      entry.used = ++useCount;
+      stats.hits++;
+      return(&entry);
+    }
+
+    if(entry.used < oldest->used) oldest = &entry;
+  }
+
+  diskDrop(oldest);
+  strcpy(oldest->path, path);
+  oldest->used = ++useCount;
+  stats.misses++;
+
+  if(LittleFS.exists(path))
+  {
+    oldest->file = LittleFS.open(path, "rb");
+    stats.opens++;
+    oldest->exists = !!oldest->file;
+    oldest->size = oldest->exists? oldest->file.size() : 0;
+  }
+
+  return(oldest);
+}
+
+bool diskExists(const char *path)
+{
+  DiskEntry *entry = diskLookup(path);
+  return(entry? entry->exists : LittleFS.exists(path));
+}
+
+size_t diskSize(const char *path)
+{
+  DiskEntry *entry = diskLookup(path);
+  return(entry? entry->size : 0);
+}
+
+//
+// Read size bytes at given offset of a file, using the cached read
+// handle. Returns the number of bytes read, 0 past the end of file.
+//
+size_t diskRead(const char *path, size_t offset, void *buf, size_t size)
+{
+  DiskEntry *entry = diskLookup(path);
+  if(!entry || !entry->exists || offset >= entry->size) return(0);
+
+  if(offset != entry->pos)
+  {
+    stats.seeks++;
+    if(!entry->file.seek(offset))
+    {
+      // Position is unknown now, seek again next time
+      entry->pos = (size_t)-1;
+      return(0);
+    }
+    entry->pos = offset;
+  }
+
+  stats.reads++;
+  size_t result = entry->file.read((uint8_t *)buf, size);
+  entry->pos += result;
+  return(result);
+}
+
+//
+// Open a file, dropping its cache entry unless it is only read
+//
+fs::File diskOpen(const char *path, const char *mode)
+{
+  if(strcmp(mode, "r") && strcmp(mode, "rb")) diskInvalidate(path);
+  stats.opens++;
+  return(LittleFS.open(path, mode));
+}
+
+bool diskRemove(const char *path)
+{
+  diskInvalidate(path);
+  return(LittleFS.remove(path));
+}
+
+bool diskRename(const char *from, const char *to)
+{
+  diskInvalidate(from);
+  diskInvalidate(to);
+  return(LittleFS.rename(from, to));
+}
+
+//
+// Drop the cache entry of a file, or all entries if path is NULL. Call
+// this before unmounting or formatting LittleFS.
+//
+void diskInvalidate(const char *path)
+{
+  for(DiskEntry &entry : cache)
+    if(!path || !strcmp(entry.path, path)) diskDrop(&entry);
+}
+
+const DiskStats *diskGetStats()
+{
+  return(&stats);
+}
@@ -0,0 +1,29 @@
+#ifndef DISK_H
+#define DISK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <FS.h>
+
+#define DISK_CACHE_FILES  4  // Number of files with cached metadata and read handles
+#define DISK_PATH_LEN    24  // Maximal cached path length, with terminator
+
+typedef struct
+{
+  uint32_t opens;   // Files opened
+  uint32_t reads;   // Reads from cached handles
+  uint32_t seeks;   // Seeks on cached handles
+  uint32_t hits;    // Lookups found in the cache
+  uint32_t misses;  // Lookups that had to check the file system
+} DiskStats;
+
+bool diskExists(const char *path);
+size_t diskSize(const char *path);
+size_t diskRead(const char *path, size_t offset, void *buf, size_t size);
+fs::File diskOpen(const char *path, const char *mode);
+bool diskRemove(const char *path);
+bool diskRename(const char *from, const char *to);
+void diskInvalidate(const char *path = NULL);
+const DiskStats *diskGetStats();
+
+#endif // DISK_H
@@ -5,15 +5,57 @@
 #include "Menu.h"
 #include "Ble.h"
 #include "Draw.h"
+#include "Format.h"
+#include "Trace.h"
+#include "Arena.h"
+#include "Heap.h"
 #include "piggy.h"
 
 #include <pgmspace.h>
 
+// Render scheduler state
+static uint32_t drawTime = 0;     // Time when the last frame was drawn
+static bool drawPending = false;  // TRUE: a frame has been requested
+static bool drawUrgent = false;   // TRUE: requested frame is urgent
+
+// Set of screen tiles, one bit per tile
+#define TILE_WORDS ((DRAW_TILES + 31) / 32)
+typedef uint32_t TileSet[TILE_WORDS];
+
+// Drawing calls made by a widget, see drawWidget()
+typedef struct
+{
+  uint8_t *log;        // Calls recorded in the last frame the widget was drawn
+  uint16_t size;       // Space for the recording
+  uint16_t length;     // Length of the last recording
+  uint16_t pos;        // Length of the recording in this frame
+  uint16_t frame;      // Frame in which the widget was last drawn
+  bool     drawn;      // TRUE: the widget was drawn in the previous frame
+  bool     same;       // TRUE: calls made in this frame match the recording
+  TileSet  tiles;      // Tiles covered by calls made in this frame
+  TileSet  last;       // Tiles covered in the previous frame
+} Widget;
+
+// Tile change tracking state
+static uint8_t tileUsers = 0;              // Number of tile tracking users
+static uint16_t tileFrame = 0;             // Tile update counter, a tile's generation
+static uint16_t tileGen[DRAW_TILES];       // Updates in which tiles last changed
+static TileSet tileDirty;                  // Tiles changed since the last update
+static TileSet tileOverlay;                // Tiles drawn over outside of drawScreen()
+static Widget widgets[DRAW_WIDGETS];
+static uint16_t widgetFrame = 0;           // Frame counter, see Widget.frame
+static uint8_t widgetId = DRAW_W_SCREEN;   // Widget being drawn
+static bool framing = false;               // TRUE: drawScreen() is drawing a frame
+
+static void drawUpdateTiles();
+
 //
 // Draw preferences write indicator
 //
 void drawSaveIndicator(int x, int y)
 {
+  drawWidget(DRAW_W_SAVE);
+
   if(prefsAreWritten() || switchThemeEditor())
   {
     // Draw preferences write request icon
@@ -30,6 +72,8 @@ void drawSaveIndicator(int x, int y)
 //
 void drawBleIndicator(int x, int y)
 {
+  drawWidget(DRAW_W_BLE);
+
   int8_t status = getBleStatus();
 
   // If need to draw BLE icon...
@@ -54,6 +98,8 @@ void drawBleIndicator(int x, int y)
 //
 void drawWiFiIndicator(int x, int y)
 {
+  drawWidget(DRAW_W_WIFI);
+
   int8_t status = getWiFiStatus();
 
   // If need to draw WiFi icon...
@@ -76,6 +122,8 @@ void drawWiFiIndicator(int x, int y)
 //
 bool drawWiFiStatus(const char *statusLine1, const char *statusLine2, int x, int y)
 {
+  drawWidget(DRAW_W_STATUS);
+
   if(statusLine1 || statusLine2)
   {
     // Draw two lines of network status
@@ -96,11 +144,16 @@ void drawZoomedMenu(const char *text, bool force)
 {
   if (!zoomMenu && !force) return;
 
+  // Drawn in the middle of the side bar, continue with it afterwards
+  uint8_t widget = drawWidget(DRAW_W_ZOOM);
+
   spr.fillSmoothRoundRect(RDS_OFFSET_X - 72 + 1, RDS_OFFSET_Y - 3 + 1, 152, 26, 4, TH.menu_bg);
   spr.setTextDatum(TC_DATUM);
   spr.setTextColor(TH.menu_item);
   spr.drawString(text, RDS_OFFSET_X + 5, RDS_OFFSET_Y, 4);
   spr.drawSmoothRoundRect(RDS_OFFSET_X - 72, RDS_OFFSET_Y - 3, 4, 4, 154, 28, TH.menu_border, TH.menu_bg);
+
+  drawWidget(widget);
 }
 
 //
@@ -111,6 +164,7 @@ void drawMessage(const char *msg)
   if(sleepOn()) return;
 
   drawZoomedMenu(msg, true);
+  drawUpdateTiles();
   spr.pushSprite(0, 0);
 }
 
@@ -119,6 +173,8 @@ void drawMessage(const char *msg)
 //
 void drawBandAndMode(const char *band, const char *mode, int x, int y)
 {
+  drawWidget(DRAW_W_BAND);
+
   spr.setTextDatum(TC_DATUM);
   spr.setTextColor(TH.band_text);
   uint16_t band_width = spr.drawString(band, x, y);
@@ -137,6 +193,8 @@ void drawRadioText(int y, int ymax)
 {
   const char *rt = getRadioText();
 
+  drawWidget(DRAW_W_RDS);
+
   // Draw potentially multi-line radio text
   spr.setTextDatum(TC_DATUM);
   spr.setTextColor(TH.rds_text);
@@ -187,23 +245,53 @@ void drawFrequency(uint32_t freq, int x, int y, int ux, int uy, uint8_t hl)
     { x - 30 - 32 * 4 -  0, y + 28, 27 }, //      10000.000
   };
 
+  drawWidget(DRAW_W_FREQ);
+
   // Top bit specifies if the digit selector is on
   bool selectOn = hl & 0x80;
   const struct Line *li;
 
+  // Frequency labels, only formatted when frequency or mode change
+  static char freqText[12];
+  static char fracText[8];
+  static uint32_t lastFreq = 0;
+  static uint8_t lastMode = 0xFF;
+
   // Lower 7 bits specify the selected digit
   hl &= 0x7F;
 
+  // SSB frequency includes BFO, in Hz
+  if(isSSB()) freq = freq * 1000 + currentBFO;
+
+  if(freq != lastFreq || currentMode != lastMode)
+  {
+    if(currentMode==FM)
+      fmtFixed(freqText, freq, 2);
+    else if(isSSB())
+    {
+      fmtUInt(freqText, freq / 1000, 3);
+      fmtUInt(fmtStr(fracText, "."), freq % 1000, 3);
+    }
+    else
+    {
+      fmtUInt(freqText, freq);
+      fmtStr(fracText, ".000");
+    }
+
+    lastFreq = freq;
+    lastMode = currentMode;
+  }
+
   spr.setTextDatum(MR_DATUM);
   spr.setTextColor(TH.freq_text);
+  spr.drawString(freqText, x, y, 7);
 
   if(currentMode==FM)
   {
     // Determine where underscore is located
     li = hl<ITEM_COUNT(hlDigitsFM)? &hlDigitsFM[hl] : 0;
 
-    // FM frequency
-    spr.drawFloat(freq/100.00, 2, x, y, 7);
+    // FM frequency is measured in MHz
     spr.setTextDatum(ML_DATUM);
     spr.setTextColor(TH.funit_text);
     spr.drawString("MHz", ux, uy);
@@ -213,24 +301,9 @@ void drawFrequency(uint32_t freq, int x, int y, int ux, int uy, uint8_t hl)
     // Determine where underscore is located
     li = hl<ITEM_COUNT(hlDigitsAMSSB)? &hlDigitsAMSSB[hl] : 0;
 
-    if(isSSB())
-    {
-      // SSB frequency
-      char text[32];
-      freq = freq * 1000 + currentBFO;
-      sprintf(text, "%3.3lu", freq / 1000);
-      spr.drawString(text, x, y, 7);
-      spr.setTextDatum(ML_DATUM);
-      sprintf(text, ".%3.3lu", freq % 1000);
-      spr.drawString(text, 4+x, 17+y, 4);
-    }
-    else
-    {
-      // AM frequency
-      spr.drawNumber(freq, x, y, 7);
-      spr.setTextDatum(ML_DATUM);
-      spr.drawString(".000", 4+x, 17+y, 4);
-    }
+    // SSB/AM frequency fraction
+    spr.setTextDatum(ML_DATUM);
+    spr.drawString(fracText, 4+x, 17+y, 4);
 
     // SSB/AM frequencies are measured in kHz
     spr.setTextColor(TH.funit_text);
@@ -258,10 +331,20 @@ void drawFrequency(uint32_t freq, int x, int y, int ux, int uy, uint8_t hl)
 //
 void drawPiggy(int x, int y)
 {
-  static uint16_t buf[PIGGY_W * PIGGY_H];
+  drawWidget(DRAW_W_PIGGY);
+
+  static uint16_t *buf = NULL;
   const size_t n = (size_t)PIGGY_W * PIGGY_H;
-  for(size_t i = 0; i < n; i++)
-    buf[i] = pgm_read_word(&piggyBitmap[i]);
+
+  // Copied to the arena once, on first use
+  if(!buf)
+  {
+    buf = (uint16_t *)arenaAlloc(ARENA_DISPLAY, n * sizeof(uint16_t));
+    if(!buf) return;
+    for(size_t i = 0; i < n; i++)
+      buf[i] = pgm_read_word(&piggyBitmap[i]);
+  }
+
   spr.pushImage(x, y, PIGGY_W, PIGGY_H, buf);
 }
 
@@ -270,6 +353,8 @@ void drawPiggy(int x, int y)
 //
 void drawScale(uint32_t freq)
 {
+  drawWidget(DRAW_W_SCALE);
+
   // Scale pointer
   spr.fillTriangle(156, 120, 160, 130, 164, 120, TH.scale_pointer);
   spr.drawLine(160, 130, 160, 169, TH.scale_pointer);
@@ -304,12 +389,14 @@ void drawScale(uint32_t freq)
       {
         spr.drawLine(x, 169, x, 150, lineColor);
         spr.drawLine(x + 1, 169, x + 1, 150, lineColor);
+        char label[12];
         if(currentMode == FM)
-          spr.drawFloat(freq / 10.0, 1, x, 140, 2);
+          fmtFixed(label, freq, 1);
         else if(freq >= 100)
-          spr.drawFloat(freq / 100.0, 3, x, 140, 2);
+          fmtFixed(label, freq * 10, 3);
         else
-          spr.drawNumber(freq * 10, x, 140, 2);
+          fmtUInt(label, freq * 10);
+        spr.drawString(label, x, 140, 2);
       }
       else if((freq % 5) == 0 && (freq % 10) != 0)
       {
@@ -329,6 +416,8 @@ void drawScale(uint32_t freq)
 //
 void drawSMeter(int strength, int x, int y)
 {
+  drawWidget(DRAW_W_SMETER);
+
   spr.drawTriangle(x + 1, y + 1, x + 11, y + 1, x + 6, y + 6, TH.smeter_icon);
   spr.drawLine(x + 6, y + 1, x + 6, y + 14, TH.smeter_icon);
 
@@ -346,6 +435,8 @@ void drawSMeter(int strength, int x, int y)
 //
 void drawStereoIndicator(int x, int y, bool stereo)
 {
+  drawWidget(DRAW_W_STEREO);
+
   if(stereo)
   {
     // Split S-meter into two rows
@@ -359,6 +450,8 @@ void drawStereoIndicator(int x, int y, bool stereo)
 //
 void drawStationName(const char *name, int x, int y)
 {
+  drawWidget(DRAW_W_STATION);
+
   spr.setTextDatum(TC_DATUM);
   spr.setTextColor(TH.rds_text);
   spr.drawString(name, x, y, 4);
@@ -369,6 +462,8 @@ void drawStationName(const char *name, int x, int y)
 //
 void drawLongStationName(const char *name, int x, int y)
 {
+  drawWidget(DRAW_W_STATION);
+
   int width = spr.textWidth(name, 2);
   spr.setTextColor(TH.rds_text);
 
@@ -394,6 +489,8 @@ void drawLongStationName(const char *name, int x, int y)
 //
 void drawScanGraphs(uint32_t freq)
 {
+  drawWidget(DRAW_W_SCAN);
+
   // Scale offset
   int16_t offset = (freq % 10) / 10.0 * 8;
 
@@ -547,23 +644,282 @@ void drawScaleWithSignals(uint32_t freq)
     drawBandMapLine(freq);
 }
 
+//
+// Request a screen update, to be drawn by drawTickTime() as soon as the
+// frame budget allows. Multiple requests coalesce into a single frame.
+//
+void drawRequest(uint8_t priority)
+{
+  drawPending = true;
+  drawUrgent |= priority == DRAW_URGENT;
+}
+
+//
+// Draw requested screen update, if any, once enough time has passed since
+// the previous frame. Urgent updates are limited to DRAW_FRAME_TIME, so the
+// first frame after a pause is drawn immediately, while cosmetic ones wait
+// for DRAW_COSMETIC_TIME. Returns TRUE if a frame has been drawn.
+//
+bool drawTickTime()
+{
+  if(!drawPending) return(false);
+
+  if((millis() - drawTime) < (drawUrgent? DRAW_FRAME_TIME : DRAW_COSMETIC_TIME))
+    return(false);
+
+  drawScreen();
+  return(true);
+}
+
+//
+// Get time (ms) until the requested screen update can be drawn, or
+// 0xFFFFFFFF if no update has been requested
+//
+uint32_t drawWaitTime()
+{
+  if(!drawPending) return(0xFFFFFFFF);
+
+  uint32_t elapsed = millis() - drawTime;
+  uint32_t budget = drawUrgent? DRAW_FRAME_TIME : DRAW_COSMETIC_TIME;
+  return(elapsed >= budget? 0 : budget - elapsed);
+}
+
+//
+// Enable (TRUE) or disable (FALSE) tile change tracking. Calls nest,
+// tracking stays on while at least one user has it enabled.
+//
+void drawTrackTiles(bool on)
+{
+  if(on && !tileUsers++)
+  {
+    static uint8_t *logs = (uint8_t *)arenaAlloc(ARENA_DISPLAY, DRAW_LOGS_SIZE);
+    uint8_t *log = logs;
+
+    // Widgets drawn before tracking was on were not recorded
+    for(int i = 0 ; i < DRAW_WIDGETS ; i++)
+    {
+      widgets[i].size  = i == DRAW_W_SCAN? DRAW_SCAN_LOG_SIZE : DRAW_LOG_SIZE;
+      widgets[i].log   = log;
+      log = log? log + widgets[i].size : NULL;
+      widgets[i].drawn = false;
+      widgets[i].frame = widgetFrame - 1;
+      memset(widgets[i].tiles, 0, sizeof(TileSet));
+    }
+  }
+  else if(!on && tileUsers)
+  {
+    tileUsers--;
+  }
+}
+
+bool drawTracking()
+{
+  return(tileUsers > 0);
+}
+
+//
+// Start drawing given widget, returns the widget drawn so far. All
+// calls made to the sprite until the next widget are recorded for this
+// widget, and its tiles change whenever the calls differ from the ones
+// made in the previous frame. A widget may be picked again later in the
+// same frame, its calls are then added to the ones already made.
+// Widgets are expected to be drawn in the same order every frame.
+//
+uint8_t drawWidget(uint8_t id)
+{
+  uint8_t prev = widgetId;
+  Widget *w = &widgets[id];
+
+  widgetId = id;
+
+  if(framing && w->frame != widgetFrame)
+  {
+    w->frame = widgetFrame;
+    w->pos   = 0;
+    w->same  = w->drawn;
+  }
+
+  return(prev);
+}
+
+//
+// Record a sprite drawing call covering (x0, y0) - (x1, y1), see
+// Sprite.h. Calls made outside of drawScreen() change their tiles right
+// away, and again once the next frame has been drawn over them.
+//
+void drawRecord(const int32_t *args, uint8_t count, int32_t x0, int32_t y0, int32_t x1, int32_t y1, const char *text)
+{
+  if(!tileUsers) return;
+
+  // Tiles covered, if any
+  x0 = max(x0, (int32_t)0) / DRAW_TILE_W;
+  y0 = max(y0, (int32_t)0) / DRAW_TILE_H;
+  x1 = min(x1, (int32_t)(DRAW_TILES_X * DRAW_TILE_W - 1)) / DRAW_TILE_W;
+  y1 = min(y1, (int32_t)(DRAW_TILES_Y * DRAW_TILE_H - 1)) / DRAW_TILE_H;
+
+  Widget *w = &widgets[widgetId];
+  uint32_t *tiles = framing? w->tiles : tileOverlay;
+
+  for(int32_t y = y0 ; y <= y1 ; y++)
+    for(int32_t x = x0 ; x <= x1 ; x++)
+    {
+      int t = y * DRAW_TILES_X + x;
+      tiles[t / 32] |= 1UL << (t % 32);
+      if(!framing) tileDirty[t / 32] |= 1UL << (t % 32);
+    }
+
+  if(!framing) return;
+
+  // Arguments are mostly small, record them as zigzag varints
+  uint8_t packed[SPRITE_MAX_ARGS * 5];
+  size_t size = 0;
+
+  for(uint8_t i = 0 ; i < count && i < SPRITE_MAX_ARGS ; i++)
+  {
+    uint32_t v = ((uint32_t)args[i] << 1) ^ (uint32_t)(args[i] >> 31);
+    for( ; v >= 0x80 ; v >>= 7) packed[size++] = (v & 0x7F) | 0x80;
+    packed[size++] = v;
+  }
+
+  // Compare the call with the recording, replacing the rest of it once
+  // they differ. Recordings that do not fit are longer than any that
+  // do, so they never match.
+  const uint8_t *parts[2] = { packed, (const uint8_t *)text };
+  size_t sizes[2] = { size, text? strlen(text) + 1 : 0 };
+
+  for(int i = 0 ; i < 2 ; i++)
+  {
+    if(!w->log || w->pos + sizes[i] > w->size)
+    {
+      w->same = false;
+      w->pos  = w->size + 1;
+      return;
+    }
+
+    if(w->same && (w->pos + sizes[i] > w->length || memcmp(w->log + w->pos, parts[i], sizes[i])))
+      w->same = false;
+    if(!w->same)
+      memcpy(w->log + w->pos, parts[i], sizes[i]);
+
+    w->pos += sizes[i];
+  }
+}
+
+int16_t DrawSprite::drawNumber(long n, int32_t x, int32_t y, uint8_t font)
+{
+  char text[12];
+  fmtInt(text, n);
+  return(drawString(text, x, y, font));
+}
+
+int16_t DrawSprite::drawNumber(long n, int32_t x, int32_t y)
+{
+  char text[12];
+  fmtInt(text, n);
+  return(drawString(text, x, y));
+}
+
+//
+// Get frame number in which given tile has last changed
+//
+uint16_t drawTileGeneration(uint8_t tile)
+{
+  return(tile < DRAW_TILES? tileGen[tile] : 0);
+}
+
+//
+// Start recording a frame drawn by drawScreen()
+//
+static void drawBeginTiles()
+{
+  if(!tileUsers) return;
+
+  framing = true;
+  drawWidget(DRAW_W_SCREEN);
+}
+
+//
+// Mark tiles changed since the last update with a new generation. At
+// the end of a frame, these are the tiles of widgets whose calls have
+// changed, appeared or gone away, and the ones drawn over in between.
+//
+static void drawUpdateTiles()
+{
+  if(!tileUsers) return;
+
+  if(framing)
+  {
+    for(Widget &w : widgets)
+    {
+      bool drawnNow = w.frame == widgetFrame;
+      bool changed  = !drawnNow || !w.same || w.pos != w.length;
+
+      for(int i = 0 ; i < TILE_WORDS ; i++)
+      {
+        if(changed) tileDirty[i] |= w.last[i] | w.tiles[i];
+        w.last[i]  = w.tiles[i];
+        w.tiles[i] = 0;
+      }
+
+      w.drawn  = drawnNow;
+      w.length = drawnNow? w.pos : 0;
+    }
+
+    for(int i = 0 ; i < TILE_WORDS ; i++)
+    {
+      tileDirty[i] |= tileOverlay[i];
+      tileOverlay[i] = 0;
+    }
+
+    framing  = false;
+    widgetId = DRAW_W_SCREEN;
+    widgetFrame++;
+  }
+
+  tileFrame++;
+
+  for(int t = 0 ; t < DRAW_TILES ; t++)
+    if(tileDirty[t / 32] & (1UL << (t % 32))) tileGen[t] = tileFrame;
+
+  memset(tileDirty, 0, sizeof(tileDirty));
+}
+
 //
 // Draw screen according to given command
 //
 void drawScreen(const char *statusLine1, const char *statusLine2)
 {
+  TRACE_SCOPE(TRACE_DRAW, 0);
+
+  // Any pending update is satisfied by this frame
+  drawPending = drawUrgent = false;
+  drawTime = millis();
+
   if(sleepOn()) return;
 
   // Clear screen buffer
+  drawBeginTiles();
   spr.fillSprite(TH.bg);
 
   // About screen is a special case
   if(currentCmd==CMD_ABOUT)
   {
     drawAbout();
+    drawUpdateTiles();
     return;
   }
 
+  // Warn about low memory, unless there is another status to show
+  char heapLine[40];
+  const HeapSample *heap = heapGetSample(0);
+  if(!statusLine1 && !statusLine2 && heap && heapIsLow())
+  {
+    char *p = fmtStr(fmtUInt(heapLine, heap->free / 1024), "k free, ");
+    fmtStr(fmtUInt(p, heap->block / 1024), "k block");
+    statusLine1 = "LOW MEMORY";
+    statusLine2 = heapLine;
+  }
+
   switch(uiLayoutIdx)
   {
     case UI_SMETER:
@@ -577,5 +933,6 @@ void drawScreen(const char *statusLine1, const char *statusLine2)
       break;
   }
 
+  drawUpdateTiles();
   spr.pushSprite(0, 0);
 }
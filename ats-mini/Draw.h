@@ -34,11 +34,56 @@
 #define PIGGY_OFFSET_X  287   // Piggy mascot: right side under frequency
 #define PIGGY_OFFSET_Y  91    // Piggy mascot vertical offset
 
+// Screen update priorities
+#define DRAW_COSMETIC    0    // Meters, clock, periodic refresh
+#define DRAW_URGENT      1    // Frequency, menus, anything the user did
+
+// Screen update rate limits
+#define DRAW_FRAME_TIME     33  // Minimum time between frames (ms), ~30fps
+#define DRAW_COSMETIC_TIME 200  // Minimum time between cosmetic-only frames (ms)
+
+// Screen tiles tracked for changes, used by the screen mirror
+#define DRAW_TILE_W     32    // Tile width
+#define DRAW_TILE_H     17    // Tile height
+#define DRAW_TILES_X    (320 / DRAW_TILE_W)
+#define DRAW_TILES_Y    (170 / DRAW_TILE_H)
+#define DRAW_TILES      (DRAW_TILES_X * DRAW_TILES_Y)
+#define DRAW_LOG_SIZE   4096  // Space for drawing calls recorded per widget (bytes)
+#define DRAW_SCAN_LOG_SIZE 12288 // Same for scan graphs, drawn pixel by pixel
+
+// Widgets whose drawing calls are recorded, see drawWidget()
+#define DRAW_W_SCREEN   0     // Background and anything not in a widget
+#define DRAW_W_SAVE     1     // Preferences save indicator
+#define DRAW_W_BLE      2     // Bluetooth indicator
+#define DRAW_W_BATTERY  3     // Battery indicator and voltage
+#define DRAW_W_WIFI     4     // WiFi indicator
+#define DRAW_W_BAND     5     // Band and mode
+#define DRAW_W_FREQ     6     // Frequency and units
+#define DRAW_W_PIGGY    7     // Piggy mascot
+#define DRAW_W_STATION  8     // Station name
+#define DRAW_W_SIDEBAR  9     // Side bar, menu or information
+#define DRAW_W_ZOOM    10     // Zoomed menu item
+#define DRAW_W_SMETER  11     // S-meter
+#define DRAW_W_STEREO  12     // Stereo indicator
+#define DRAW_W_STATUS  13     // Network status lines
+#define DRAW_W_RDS     14     // Radio text
+#define DRAW_W_SCALE   15     // Tuner scale
+#define DRAW_W_SCAN    16     // Scan graphs
+#define DRAW_W_SNMETER 17     // Signal to noise meter
+#define DRAW_WIDGETS   18
+#define DRAW_LOGS_SIZE ((DRAW_WIDGETS - 1) * DRAW_LOG_SIZE + DRAW_SCAN_LOG_SIZE)
+
 void drawPiggy(int x, int y);
 void drawMessage(const char *msg);
 void drawZoomedMenu(const char *text, bool force = false);
 void drawScanGraphs(uint32_t freq);
 void drawScreen(const char *statusLine1 = 0, const char *statusLine2 = 0);
+void drawRequest(uint8_t priority = DRAW_URGENT);
+bool drawTickTime();
+uint32_t drawWaitTime();
+void drawTrackTiles(bool on);
+uint8_t drawWidget(uint8_t id);
+uint16_t drawTileGeneration(uint8_t tile);
 
 void drawWiFiIndicator(int x, int y);
 void drawSaveIndicator(int x, int y);
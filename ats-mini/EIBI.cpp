@@ -2,10 +2,12 @@
 #include "Draw.h"
 #include "EIBI.h"
 #include "Button.h"
+#include "Trace.h"
+#include "Cpu.h"
+#include "Disk.h"
 
 #include <HTTPClient.h>
 #include <WiFi.h>
-#include <LittleFS.h>
 #include <FS.h>
 
 #include <ctype.h>
@@ -66,10 +68,9 @@ const BandLabel bandLabels[] =
   {29600, 30000,  "9m BC"         }
 };
 
-// FIXME: this might be slow
 bool eibiAvailable()
 {
-  return(LittleFS.exists(EIBI_PATH));
+  return(diskExists(EIBI_PATH));
 }
 
 static bool entryIsNow(const StationSchedule *entry, int now)
@@ -91,8 +92,15 @@ static bool entryIsNow(const StationSchedule *entry, int now)
   return(false);
 }
 
+static bool eibiRead(size_t offset, StationSchedule *entry)
+{
+  return(diskRead(EIBI_PATH, offset, entry, sizeof(*entry)) == sizeof(*entry));
+}
+
 const StationSchedule *eibiNext(uint16_t freq, uint8_t hour, uint8_t minute, size_t *offset)
 {
+  TRACE_SCOPE(TRACE_EIBI, freq);
+
   // Will return this static entry
   static StationSchedule entry;
 
@@ -102,36 +110,25 @@ const StationSchedule *eibiNext(uint16_t freq, uint8_t hour, uint8_t minute, siz
   // If no valid offset yet, find some
   if(*offset==(size_t)-1) eibiLookup(freq, hour, minute, offset);
 
-  // Open file with EIBI data
-  fs::File file = LittleFS.open(EIBI_PATH, "rb");
-  if(!file) return(NULL);
-
-  StationSchedule *result = NULL;
   int now = hour * 60 + minute;
 
-  // Go to the starting offset
-  if(!file.seek(*offset, fs::SeekSet))
-  {
-    file.close();
-    return(NULL);
-  }
-
-  while(file.read((uint8_t*)&entry, sizeof(entry)) == sizeof(entry))
+  // Read forward from the starting offset
+  for(size_t pos = *offset ; eibiRead(pos, &entry) ; pos += sizeof(entry))
   {
     if((entry.freq>freq) && entryIsNow(&entry, now))
     {
-      *offset = file.position() - sizeof(entry);
-      result = &entry;
-      break;
+      *offset = pos;
+      return(&entry);
     }
   }
 
-  file.close();
-  return(result);
+  return(NULL);
 }
 
 const StationSchedule *eibiPrev(uint16_t freq, uint8_t hour, uint8_t minute, size_t *offset)
 {
+  TRACE_SCOPE(TRACE_EIBI, freq);
+
   // Will return this static entry
   static StationSchedule entry;
 
@@ -141,87 +138,70 @@ const StationSchedule *eibiPrev(uint16_t freq, uint8_t hour, uint8_t minute, siz
   // If no valid offset yet, find some
   if(*offset==(size_t)-1) eibiLookup(freq, hour, minute, offset);
 
-  // Open file with EIBI data
-  fs::File file = LittleFS.open(EIBI_PATH, "rb");
-  if(!file) return(NULL);
-
-  StationSchedule *result = NULL;
   int now = hour * 60 + minute;
 
-  for(size_t pos = *offset; file.seek(pos, fs::SeekSet) ; pos -= sizeof(entry))
+  // Read backward from the starting offset, until the offset wraps
+  // around past the start of file
+  for(size_t pos = *offset ; eibiRead(pos, &entry) ; pos -= sizeof(entry))
   {
-    if(file.read((uint8_t*)&entry, sizeof(entry)) != sizeof(entry)) break;
-
     if((entry.freq<freq) && entryIsNow(&entry, now))
     {
       *offset = pos;
-      result = &entry;
-      break;
+      return(&entry);
     }
   }
 
-  file.close();
-  return(result);
+  return(NULL);
 }
 
 const StationSchedule *eibiAtSameFreq(uint8_t hour, uint8_t minute, size_t *offset, bool same)
 {
+  TRACE_SCOPE(TRACE_EIBI, 0);
+
   // Will return this static entry
   static StationSchedule entry;
 
   // Must have valid offset
   if(!offset) return(NULL);
 
-  // Open file with EIBI data
-  fs::File file = LittleFS.open(EIBI_PATH, "rb");
-  if(!file) return(NULL);
-
   // Read current entry to get frequency
   StationSchedule e0;
-  if(!file.seek(*offset, fs::SeekSet) || file.read((uint8_t*)&e0, sizeof(e0)) != sizeof(e0))
-  {
-    file.close();
-    return(NULL);
-  }
+  if(!eibiRead(*offset, &e0)) return(NULL);
 
-  StationSchedule *result = NULL;
   int now = hour * 60 + minute;
 
   if(same && entryIsNow(&e0, now))
   {
     entry = e0;
-    result = &entry;
-    file.close();
-    return(result);
+    return(&entry);
   }
 
-  while(file.read((uint8_t*)&entry, sizeof(entry)) == sizeof(entry))
+  for(size_t pos = *offset + sizeof(entry) ; eibiRead(pos, &entry) ; pos += sizeof(entry))
   {
     if(entry.freq != e0.freq)
       break;
     else if(entryIsNow(&entry, now))
     {
-      *offset = file.position() - sizeof(entry);
-      result = &entry;
-      break;
+      *offset = pos;
+      return(&entry);
     }
   }
 
-  file.close();
-  return(result);
+  return(NULL);
 }
 
 const StationSchedule *eibiLookup(uint16_t freq, uint8_t hour, uint8_t minute, size_t *offset)
 {
+  TRACE_SCOPE(TRACE_EIBI, freq);
+
   // Will return this static entry
   static StationSchedule entry;
 
-  // Open file with EIBI data
-  fs::File file = LittleFS.open(EIBI_PATH, "rb");
-  if(!file) return(NULL);
+  // Need EIBI data
+  if(!diskExists(EIBI_PATH)) return(NULL);
 
   // Set up binary search
-  ssize_t total = file.size() / sizeof(entry);
+  ssize_t total = diskSize(EIBI_PATH) / sizeof(entry);
   ssize_t left  = 0;
   ssize_t right = total;
   ssize_t match = -1;
@@ -236,19 +216,8 @@ const StationSchedule *eibiLookup(uint16_t freq, uint8_t hour, uint8_t minute, s
     // Save current offset, correcting for file size
     if(offset) *offset = (mid<0? 0 : mid>=total? total-1 : mid) * sizeof(entry);
 
-    // Go to the middle entry
-    if(!file.seek(mid * sizeof(entry), fs::SeekSet))
-    {
-      file.close();
-      return(NULL);
-    }
-
     // Read middle entry
-    if(file.read((uint8_t*)&entry, sizeof(entry)) != sizeof(entry))
-    {
-      file.close();
-      return(NULL);
-    }
+    if(!eibiRead(mid * sizeof(entry), &entry)) return(NULL);
 
     // Compare frequency
     if(entry.freq < freq)
@@ -263,27 +232,12 @@ const StationSchedule *eibiLookup(uint16_t freq, uint8_t hour, uint8_t minute, s
   }
 
   // Drop out if not found
-  if(match < 0)
-  {
-    file.close();
-    return(NULL);
-  }
+  if(match < 0) return(NULL);
 
-  // If found entry is not the same as the last read entry...
-  if(match != mid)
-  {
-    // Read the right entry
-    if(file.seek(match * sizeof(entry), fs::SeekSet))
-      if(file.read((uint8_t*)&entry, sizeof(entry)) == sizeof(entry))
-        mid = match;
-
-    // Drop out if failed to read
-    if(match != mid)
-    {
-      file.close();
-      return(NULL);
-    }
-  }
+  // If found entry is not the same as the last read entry, read the
+  // right entry, dropping out if failed to read
+  size_t pos = match * sizeof(entry);
+  if(match != mid && !eibiRead(pos, &entry)) return(NULL);
 
   // This is our current time in minutes
   int now = hour * 60 + minute;
@@ -292,22 +246,19 @@ const StationSchedule *eibiLookup(uint16_t freq, uint8_t hour, uint8_t minute, s
   do
   {
     // Report offset within the file
-    if(offset) *offset = file.position() - sizeof(entry);
+    if(offset) *offset = pos;
 
     // Match frequency
     if(entry.freq != freq) break;
 
     // Match time
-    if(entryIsNow(&entry, now))
-    {
-      file.close();
-      return(&entry);
-    }
+    if(entryIsNow(&entry, now)) return(&entry);
+
+    pos += sizeof(entry);
   }
-  while(file.read((uint8_t*)&entry, sizeof(entry)) == sizeof(entry));
+  while(eibiRead(pos, &entry));
 
   // Not found
-  file.close();
   return(NULL);
 }
 
@@ -393,6 +344,9 @@ bool eibiLoadSchedule()
   // Need to be connected to the network
   if(getWiFiStatus() < 2) return(false);
 
+  // Parsing the schedule takes a while
+  cpuBoost(CPU_FREQ_MAX);
+
   drawScreen(eibiMessage, "Connecting...");
 
   // Open HTTP connection to EiBi site
@@ -405,7 +359,7 @@ bool eibiLoadSchedule()
   }
 
   // Open file in the local flash file system
-  fs::File file = LittleFS.open(TEMP_PATH, "wb");
+  fs::File file = diskOpen(TEMP_PATH, "wb");
   if(!file)
   {
     drawScreen(eibiMessage, "Failed opening local storage!");
@@ -429,7 +383,7 @@ bool eibiLoadSchedule()
 
       file.close();
       http.end();
-      LittleFS.remove(TEMP_PATH);
+      diskRemove(TEMP_PATH);
       drawScreen(eibiMessage, "CANCELED!");
       return(false);
     }
@@ -486,8 +440,8 @@ bool eibiLoadSchedule()
   http.end();
 
   // Move new schedule to its permanent place
-  LittleFS.remove(EIBI_PATH);
-  LittleFS.rename(TEMP_PATH, EIBI_PATH);
+  diskRemove(EIBI_PATH);
+  diskRename(TEMP_PATH, EIBI_PATH);
 
   // Success
   identifyFrequency(currentFrequency + currentBFO / 1000);
@@ -0,0 +1,91 @@
+#include "Format.h"
+
+//
+// Format unsigned decimal number, padded to at least width characters
+//
+char *fmtUInt(char *buf, uint32_t value, uint8_t width, char pad)
+{
+  char digits[10];
+  uint8_t n = 0;
+
+  // Produce digits in reverse order
+  do
+  {
+    digits[n++] = '0' + value % 10;
+    value /= 10;
+  }
+  while(value);
+
+  while(width > n) { *buf++ = pad; width--; }
+  while(n) *buf++ = digits[--n];
+
+  *buf = '\0';
+  return(buf);
+}
+
+//
+// Format signed decimal number, zero padded to at least width digits
+// (same as printf("%<width>.<width>d"))
+//
+char *fmtInt(char *buf, int32_t value, uint8_t width)
+{
+  if(value < 0)
+  {
+    *buf++ = '-';
+    return(fmtUInt(buf, -(uint32_t)value, width));
+  }
+
+  return(fmtUInt(buf, value, width));
+}
+
+//
+// Format fixed point number with given number of decimals
+//
+char *fmtFixed(char *buf, int32_t value, uint8_t decimals)
+{
+  uint32_t divisor = 1;
+  uint32_t absValue = value < 0? -(uint32_t)value : value;
+
+  for(uint8_t i = 0 ; i < decimals ; i++) divisor *= 10;
+
+  if(value < 0) *buf++ = '-';
+  buf = fmtUInt(buf, absValue / divisor);
+
+  if(!decimals) return(buf);
+
+  *buf++ = '.';
+  return(fmtUInt(buf, absValue % divisor, decimals));
+}
+
+//
+// Format uppercase hexadecimal number, zero padded to at least width digits
+//
+char *fmtHex(char *buf, uint32_t value, uint8_t width)
+{
+  char digits[8];
+  uint8_t n = 0;
+
+  do
+  {
+    digits[n++] = "0123456789ABCDEF"[value & 0x0F];
+    value >>= 4;
+  }
+  while(value);
+
+  while(width > n) { *buf++ = '0'; width--; }
+  while(n) *buf++ = digits[--n];
+
+  *buf = '\0';
+  return(buf);
+}
+
+//
+// Copy string
+//
+char *fmtStr(char *buf, const char *str)
+{
+  while(*str) *buf++ = *str++;
+
+  *buf = '\0';
+  return(buf);
+}
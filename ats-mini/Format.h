@@ -0,0 +1,26 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <stdint.h>
+
+//
+// Integer and fixed point text formatting for the draw path. These do
+// not use printf(), floating point or the heap. Each function writes a
+// NUL-terminated string to buf and returns a pointer to the terminating
+// NUL, so that calls can be chained.
+//
+
+// Decimal number, padded to at least width characters with pad
+char *fmtUInt(char *buf, uint32_t value, uint8_t width = 0, char pad = '0');
+char *fmtInt(char *buf, int32_t value, uint8_t width = 0);
+
+// Fixed point number, value is scaled by 10^decimals (1234, 2 => 12.34)
+char *fmtFixed(char *buf, int32_t value, uint8_t decimals);
+
+// Uppercase hexadecimal number, zero padded to at least width digits
+char *fmtHex(char *buf, uint32_t value, uint8_t width = 0);
+
+// Copy string
+char *fmtStr(char *buf, const char *str);
+
+#endif // FORMAT_H
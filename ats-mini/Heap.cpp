@@ -0,0 +1,128 @@
+#include "Common.h"
+#include "Heap.h"
+#include "esp_heap_caps.h"
+
+//
+// Heap telemetry. Free internal heap, its largest free block and free
+// PSRAM are sampled periodically into a ring buffer, so slow leaks and
+// fragmentation (WiFi and Bluetooth fail once no large enough block is
+// left) show up over hours of use. Known heap users count their
+// allocations with heapCount(), or take a heapMark() before a use and
+// pass it to heapUsed() after, recording how much free heap the use
+// kept and how far it pushed the lowest free heap down. Both may be
+// called from any task.
+//
+
+static HeapSample samples[HEAP_SAMPLES];
+static uint32_t sampleCount = 0;
+static bool heapLow = false;
+
+static HeapUser users[HEAP_USERS] =
+{
+  { "web",   0, 0, 0, 0, 0 },
+  { "arena", 0, 0, 0, 0, 0 },
+  { "wifi",  0, 0, 0, 0, 0 },
+  { "ble",   0, 0, 0, 0, 0 },
+};
+
+//
+// Take a heap sample, call this every SCHED_HEAP_TIME. Returns TRUE if
+// the low memory warning has to be shown or removed.
+//
+bool heapTickTime()
+{
+  HeapSample *s = &samples[sampleCount++ % HEAP_SAMPLES];
+
+  s->time    = millis();
+  s->free    = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+  s->block   = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+  s->minFree = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+  s->psram   = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+
+  bool low = s->free < HEAP_LOW_FREE || s->block < HEAP_LOW_BLOCK;
+  bool changed = low != heapLow;
+  heapLow = low;
+  return(changed);
+}
+
+void heapCount(uint8_t user, size_t size)
+{
+  if(user >= HEAP_USERS) return;
+
+  __atomic_fetch_add(&users[user].count, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&users[user].bytes, size, __ATOMIC_RELAXED);
+}
+
+HeapMark heapMark()
+{
+  HeapMark mark;
+
+  mark.free    = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+  mark.minFree = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+  return(mark);
+}
+
+//
+// Count a use started with heapMark(). Uses on different tasks may
+// overlap, so the numbers are a rough guide.
+//
+void heapUsed(uint8_t user, const HeapMark *mark, size_t size)
+{
+  if(user >= HEAP_USERS) return;
+
+  HeapUser *u = &users[user];
+  int32_t held = mark->free - heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+  uint32_t peak = mark->minFree - heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+
+  heapCount(user, size);
+  u->lastHeld = held;
+  u->maxHeld = max(u->maxHeld, held);
+  u->maxPeak = max(u->maxPeak, peak);
+}
+
+//
+// Returns TRUE if the last sample was below the low-water mark
+//
+bool heapIsLow()
+{
+  return(heapLow);
+}
+
+//
+// Get a heap sample, 0 being the latest one. Returns NULL past the
+// oldest sample kept.
+//
+const HeapSample *heapGetSample(uint8_t idx)
+{
+  if(idx >= min(sampleCount, (uint32_t)HEAP_SAMPLES)) return(NULL);
+  return(&samples[(sampleCount - 1 - idx) % HEAP_SAMPLES]);
+}
+
+const HeapUser *heapGetUser(uint8_t user)
+{
+  return(user < HEAP_USERS? &users[user] : NULL);
+}
+
+//
+// Print heap users and samples, oldest first. Samples may be taken
+// while printing, so the output may be off by a sample.
+//
+void heapDump(Print *out)
+{
+  uint8_t count = min(sampleCount, (uint32_t)HEAP_SAMPLES);
+
+  out->printf("HEAP %u\r\n", count);
+  out->printf("size,%u,%u\r\n", heap_caps_get_total_size(MALLOC_CAP_INTERNAL), heap_caps_get_total_size(MALLOC_CAP_SPIRAM));
+  out->printf("low,%u,%u,%u\r\n", heapLow, HEAP_LOW_FREE, HEAP_LOW_BLOCK);
+
+  for(const HeapUser &user : users)
+    out->printf("user,%s,%lu,%lu,%ld,%ld,%lu\r\n", user.name, user.count, user.bytes, user.lastHeld, user.maxHeld, user.maxPeak);
+
+  for(uint8_t i = count ; i-- ; )
+  {
+    const HeapSample *s = heapGetSample(i);
+    out->printf("%lu,%lu,%lu,%lu,%lu\r\n", s->time, s->free, s->block, s->minFree, s->psram);
+  }
+
+  out->print("END\r\n");
+}
@@ -0,0 +1,54 @@
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class Print;
+
+#define HEAP_SAMPLES     120  // Heap samples kept, two hours at SCHED_HEAP_TIME
+#define HEAP_LOW_FREE  24576  // Internal heap low-water mark, free bytes
+#define HEAP_LOW_BLOCK  8192  // Internal heap low-water mark, largest free block
+
+// Heap users counted by heapCount()
+#define HEAP_WEB         0  // Web requests and responses, pages are in the arena
+#define HEAP_ARENA       1  // Arena requests that went to the heap
+#define HEAP_WIFI        2  // WiFi and web server startup
+#define HEAP_BLE         3  // Bluetooth startup
+#define HEAP_USERS       4
+
+typedef struct
+{
+  uint32_t time;      // When the sample was taken (ms since boot)
+  uint32_t free;      // Free internal heap (bytes)
+  uint32_t block;     // Largest free internal heap block (bytes)
+  uint32_t minFree;   // Lowest free internal heap since boot (bytes)
+  uint32_t psram;     // Free PSRAM (bytes)
+} HeapSample;
+
+typedef struct
+{
+  const char *name;   // Heap user name
+  uint32_t count;     // Number of allocations or uses
+  uint32_t bytes;     // Total size of allocations (bytes)
+  int32_t  lastHeld;  // Free internal heap lost over the last use (bytes)
+  int32_t  maxHeld;   // Most free internal heap lost over a use (bytes)
+  uint32_t maxPeak;   // Most the lowest free internal heap dropped over a use (bytes)
+} HeapUser;
+
+typedef struct
+{
+  uint32_t free;      // Free internal heap when the use started (bytes)
+  uint32_t minFree;   // Lowest free internal heap when the use started (bytes)
+} HeapMark;
+
+bool heapTickTime();
+void heapCount(uint8_t user, size_t size);
+HeapMark heapMark();
+void heapUsed(uint8_t user, const HeapMark *mark, size_t size = 0);
+bool heapIsLow();
+const HeapSample *heapGetSample(uint8_t idx);
+const HeapUser *heapGetUser(uint8_t user);
+void heapDump(Print *out);
+
+#endif // HEAP_H
@@ -0,0 +1,103 @@
+#include "Common.h"
+#include "Input.h"
+#include "Profile.h"
+
+//
+// Input event queue. The encoder, its button and the remote interfaces
+// all post events here, the main loop then handles them in the order
+// they came in. All sources are polled from the main loop, so there is
+// a single producer and a single consumer and no locking.
+//
+
+static InputEvent queue[INPUT_QUEUE_SIZE];
+static uint32_t queueHead = 0;
+static uint32_t queueTail = 0;
+
+static InputStats stats;
+
+// Time of the oldest handled event not shown on the screen yet, 0 if none
+static uint32_t undrawnTime = 0;
+
+//
+// Queue an input event. Rotations from the same source following each
+// other are merged into one event, keeping the earliest time.
+//
+void inputPost(uint8_t type, uint8_t source, int16_t value, int16_t accel, uint32_t time)
+{
+  if(!time) time = millis();
+
+  if(queueHead != queueTail)
+  {
+    InputEvent *last = &queue[(queueHead - 1) & (INPUT_QUEUE_SIZE - 1)];
+    if(type == INPUT_ROTATE && last->type == INPUT_ROTATE && last->source == source)
+    {
+      last->value += value;
+      last->accel += accel;
+      return;
+    }
+  }
+
+  if(queueHead - queueTail >= INPUT_QUEUE_SIZE)
+  {
+    stats.dropped++;
+    return;
+  }
+
+  InputEvent *event = &queue[queueHead++ & (INPUT_QUEUE_SIZE - 1)];
+  event->time   = time;
+  event->type   = type;
+  event->source = source;
+  event->value  = value;
+  event->accel  = accel;
+}
+
+//
+// Returns TRUE if count more events can be queued. Remote commands are
+// only read while there is room for them, so that they are never
+// dropped and wait in the transport instead.
+//
+bool inputHasRoom(uint8_t count)
+{
+  return(queueHead - queueTail + count <= INPUT_QUEUE_SIZE);
+}
+
+//
+// Get the next queued event, returns FALSE if there are none
+//
+bool inputGet(InputEvent *event)
+{
+  if(queueHead == queueTail) return(false);
+
+  *event = queue[queueTail++ & (INPUT_QUEUE_SIZE - 1)];
+  return(true);
+}
+
+//
+// Call after handling an event, with redraw set if the event changed
+// what is on the screen
+//
+void inputHandled(const InputEvent *event, bool redraw)
+{
+  stats.events++;
+
+  if(redraw && (!undrawnTime || (int32_t)(event->time - undrawnTime) < 0))
+    undrawnTime = event->time;
+}
+
+//
+// Call after drawing the screen, measures end to end input latency
+//
+void inputDrawn()
+{
+  if(!undrawnTime) return;
+
+  stats.lastLatency = millis() - undrawnTime;
+  stats.maxLatency  = max(stats.maxLatency, stats.lastLatency);
+  profAdd(PROF_LATENCY, stats.lastLatency * 1000);
+  undrawnTime = 0;
+}
+
+const InputStats *inputGetStats()
+{
+  return(&stats);
+}
@@ -0,0 +1,51 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdint.h>
+
+#define INPUT_BATCH      16 // Maximal remote commands read per loop pass
+#define INPUT_SOURCES     3 // Number of event sources below
+#define INPUT_REMOTE_MAX  2 // Most events posted by one remote command
+
+// Maximal number of queued events, power of 2. Holds a full batch of
+// remote commands from every remote source on top of the encoder.
+#define INPUT_QUEUE_SIZE 128
+
+// Event types
+#define INPUT_ROTATE  1 // Encoder rotation: value = steps, accel = accelerated steps
+#define INPUT_PRESS   2 // Button pressed down
+#define INPUT_CLICK   3 // Button released after a click
+#define INPUT_SHORT   4 // Button released after a short press
+#define INPUT_LONG    5 // Button held for a long press, repeats while held
+#define INPUT_COMMAND 6 // Remote command: value = key, accel = REMOTE_* flags
+
+// Event sources
+#define INPUT_KNOB    0 // Encoder and its button
+#define INPUT_SERIAL  1 // USB serial remote
+#define INPUT_BLE     2 // Bluetooth remote
+
+typedef struct
+{
+  uint32_t time;   // Time the event happened (ms)
+  uint8_t  type;   // INPUT_ROTATE, INPUT_CLICK, ...
+  uint8_t  source; // INPUT_KNOB, INPUT_SERIAL, ...
+  int16_t  value;  // Event specific value
+  int16_t  accel;  // Accelerated steps for INPUT_ROTATE
+} InputEvent;
+
+typedef struct
+{
+  uint32_t events;      // Events handled
+  uint32_t dropped;     // Encoder events dropped on a full queue
+  uint32_t lastLatency; // Time from the last event to the screen showing it (ms)
+  uint32_t maxLatency;  // Maximal time from an event to the screen showing it (ms)
+} InputStats;
+
+void inputPost(uint8_t type, uint8_t source, int16_t value = 0, int16_t accel = 0, uint32_t time = 0);
+bool inputGet(InputEvent *event);
+bool inputHasRoom(uint8_t count);
+void inputHandled(const InputEvent *event, bool redraw);
+void inputDrawn();
+const InputStats *inputGetStats();
+
+#endif // INPUT_H
@@ -0,0 +1,324 @@
+#include "Common.h"
+#include "Journal.h"
+#include "Disk.h"
+#include "esp_rom_crc.h"
+
+//
+// Append-only preferences journal on LittleFS. Each save appends the
+// changed chunks as records, followed by a commit record. At boot, the
+// journal is replayed and the latest committed record of each chunk
+// wins, so a save interrupted by a power loss is either fully there or
+// not at all. Once the journal grows over JOURNAL_MAX_SIZE, the latest
+// records are copied to a new file that replaces the journal.
+//
+
+#define JOURNAL_MAGIC  0x4A50  // "PJ"
+#define JOURNAL_COMMIT 0xFF    // Commit record section
+
+typedef struct
+{
+  uint16_t magic;    // JOURNAL_MAGIC
+  uint8_t  section;  // Section, or JOURNAL_COMMIT
+  uint8_t  chunk;    // Chunk within section
+  uint32_t seq;      // Sequence number of the save
+  uint16_t length;   // Payload length
+  uint16_t reserved;
+  uint32_t crc;      // CRC32 of the record up to this field and the payload
+} JournalRecord;
+
+// File offset of the latest committed payload of each chunk, 0 if none
+static uint32_t latest[JOURNAL_SECTIONS][JOURNAL_CHUNKS];
+static uint16_t latestLength[JOURNAL_SECTIONS][JOURNAL_CHUNKS];
+
+// Payloads written by the current save, until it is committed
+static uint32_t uncommitted[JOURNAL_SECTIONS][JOURNAL_CHUNKS];
+static uint16_t uncommittedLength[JOURNAL_SECTIONS][JOURNAL_CHUNKS];
+static bool saveFailed = false;
+
+static bool journalOn = false;
+static uint32_t journalSeq = 0;
+static fs::File journalFile;
+static uint32_t journalEnd = 0;
+static JournalStats stats;
+
+static uint32_t recordCrc(const JournalRecord *record, const void *data)
+{
+  uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)record, offsetof(JournalRecord, crc));
+  return(esp_rom_crc32_le(crc, (const uint8_t *)data, record->length));
+}
+
+static bool recordWrite(fs::File &file, uint8_t section, uint8_t chunk, const void *data, uint16_t length)
+{
+  JournalRecord record = { JOURNAL_MAGIC, section, chunk, journalSeq, length, 0, 0 };
+  record.crc = recordCrc(&record, data);
+
+  return(file.write((const uint8_t *)&record, sizeof(record)) == sizeof(record) &&
+         file.write((const uint8_t *)data, length) == length);
+}
+
+//
+// Read the journal, recording the latest committed record of each chunk.
+// Returns the offset just past the last commit.
+//
+static uint32_t journalReplay(fs::File &file)
+{
+  static uint8_t buf[JOURNAL_MAX_RECORD];
+  uint32_t pending[JOURNAL_SECTIONS][JOURNAL_CHUNKS];
+  uint16_t pendingLength[JOURNAL_SECTIONS][JOURNAL_CHUNKS];
+  uint32_t committed = 0;
+  JournalRecord record;
+
+  memset(latest, 0, sizeof(latest));
+  memset(pending, 0, sizeof(pending));
+  stats.records = 0;
+
+  while(file.read((uint8_t *)&record, sizeof(record)) == sizeof(record))
+  {
+    uint32_t offset = file.position();
+
+    // Stop at the first damaged record, it is the end of the journal
+    if(record.magic != JOURNAL_MAGIC || record.length > sizeof(buf)) break;
+    if(file.read(buf, record.length) != record.length) break;
+    if(record.crc != recordCrc(&record, buf)) break;
+
+    if(record.section == JOURNAL_COMMIT)
+    {
+      // Save is complete, its records become current
+      for(int i = 0 ; i < JOURNAL_SECTIONS ; i++)
+        for(int j = 0 ; j < JOURNAL_CHUNKS ; j++)
+          if(pending[i][j])
+          {
+            latest[i][j] = pending[i][j];
+            latestLength[i][j] = pendingLength[i][j];
+          }
+
+      memset(pending, 0, sizeof(pending));
+      committed = file.position();
+      journalSeq = record.seq + 1;
+    }
+    else if(record.section < JOURNAL_SECTIONS && record.chunk < JOURNAL_CHUNKS)
+    {
+      pending[record.section][record.chunk] = offset;
+      pendingLength[record.section][record.chunk] = record.length;
+    }
+
+    stats.records++;
+  }
+
+  return(committed);
+}
+
+//
+// Copy the latest records into a new journal, replacing the old one
+//
+static bool journalCompact()
+{
+  static uint8_t buf[JOURNAL_MAX_RECORD];
+  uint32_t offsets[JOURNAL_SECTIONS][JOURNAL_CHUNKS];
+  bool result = true;
+
+  fs::File src = diskOpen(JOURNAL_PATH, "rb");
+  fs::File dst = diskOpen(JOURNAL_TEMP_PATH, "wb");
+  if(!dst) return(false);
+
+  memset(offsets, 0, sizeof(offsets));
+
+  for(int i = 0 ; src && result && i < JOURNAL_SECTIONS ; i++)
+    for(int j = 0 ; result && j < JOURNAL_CHUNKS ; j++)
+    {
+      if(!latest[i][j]) continue;
+
+      result = src.seek(latest[i][j]) && src.read(buf, latestLength[i][j]) == latestLength[i][j];
+      offsets[i][j] = dst.position() + sizeof(JournalRecord);
+      result = result && recordWrite(dst, i, j, buf, latestLength[i][j]);
+    }
+
+  result = result && recordWrite(dst, JOURNAL_COMMIT, 0, buf, 0);
+  uint32_t size = dst.position();
+  journalSeq++;
+  if(src) src.close();
+  dst.close();
+
+  if(!result)
+  {
+    diskRemove(JOURNAL_TEMP_PATH);
+    return(false);
+  }
+
+  // Journal is replaced by a complete copy, see journalInit() for the
+  // case of a power loss in between
+  diskRemove(JOURNAL_PATH);
+  if(!diskRename(JOURNAL_TEMP_PATH, JOURNAL_PATH)) return(false);
+
+  memcpy(latest, offsets, sizeof(latest));
+  stats.size = size;
+  stats.compactions++;
+  return(true);
+}
+
+//
+// Replay the journal, call this once LittleFS is mounted. Returns FALSE
+// if the journal can not be used, preferences then stay in NVS.
+//
+bool journalInit()
+{
+  uint32_t start = micros();
+
+  journalOn = false;
+  journalSeq = 0;
+  memset(latest, 0, sizeof(latest));
+
+  // Finish a compaction interrupted after removing the old journal
+  if(!diskExists(JOURNAL_PATH) && diskExists(JOURNAL_TEMP_PATH))
+    diskRename(JOURNAL_TEMP_PATH, JOURNAL_PATH);
+  else
+    diskRemove(JOURNAL_TEMP_PATH);
+
+  fs::File file = diskOpen(JOURNAL_PATH, "rb");
+  if(file)
+  {
+    uint32_t end = journalReplay(file);
+    uint32_t size = file.size();
+    file.close();
+    stats.size = size;
+
+    // Drop the partial save at the end, so new saves are not appended
+    // after it
+    if(end < size && !journalCompact()) return(false);
+  }
+  else
+  {
+    // Create an empty journal
+    file = diskOpen(JOURNAL_PATH, "wb");
+    if(!file) return(false);
+    file.close();
+  }
+
+  stats.replayTime = micros() - start;
+  journalOn = true;
+  return(true);
+}
+
+bool journalAvailable()
+{
+  return(journalOn);
+}
+
+//
+// Read the latest committed payload of a chunk, returns its length or
+// 0 if the chunk is not in the journal or does not fit into size bytes
+//
+size_t journalRead(uint8_t section, uint8_t chunk, void *buf, size_t size)
+{
+  if(!journalOn || section >= JOURNAL_SECTIONS || chunk >= JOURNAL_CHUNKS) return(0);
+  if(!latest[section][chunk] || latestLength[section][chunk] > size) return(0);
+
+  // Chunks are read one after another at boot, keep the journal open
+  size_t result = latestLength[section][chunk];
+  return(diskRead(JOURNAL_PATH, latest[section][chunk], buf, result) == result? result : 0);
+}
+
+//
+// Append a chunk to the current save. After a power loss, the save only
+// counts if journalCommit() has completed.
+//
+bool journalWrite(uint8_t section, uint8_t chunk, const void *data, uint16_t length)
+{
+  if(!journalOn || section >= JOURNAL_SECTIONS || chunk >= JOURNAL_CHUNKS) return(false);
+  if(length > JOURNAL_MAX_RECORD) return(false);
+
+  // After a failed write, the rest of the save is dropped anyway
+  if(saveFailed) return(false);
+
+  if(!journalFile)
+  {
+    journalFile = diskOpen(JOURNAL_PATH, "ab");
+    journalEnd = journalFile? journalFile.size() : 0;
+  }
+
+  if(!journalFile || !recordWrite(journalFile, section, chunk, data, length))
+  {
+    saveFailed = true;
+    return(false);
+  }
+
+  journalEnd += sizeof(JournalRecord) + length;
+  uncommitted[section][chunk] = journalEnd - length;
+  uncommittedLength[section][chunk] = length;
+  return(true);
+}
+
+//
+// Complete the current save with a commit record. If any part of the
+// save failed, it is dropped instead: the partial records are cut off
+// by a compaction, or if that fails too, the journal is removed and
+// turned off, so preferences go to NVS. Returns FALSE if the save has
+// been dropped.
+//
+bool journalCommit()
+{
+  // Nothing has been written to the journal
+  if(!journalFile && !saveFailed) return(true);
+
+  uint32_t start = micros();
+  bool result = !saveFailed && journalFile &&
+    recordWrite(journalFile, JOURNAL_COMMIT, 0, &start, 0);
+
+  if(journalFile)
+  {
+    journalFile.flush();
+    journalFile.close();
+  }
+
+  if(result)
+  {
+    // Save is complete, its records become current
+    for(int i = 0 ; i < JOURNAL_SECTIONS ; i++)
+      for(int j = 0 ; j < JOURNAL_CHUNKS ; j++)
+        if(uncommitted[i][j])
+        {
+          latest[i][j] = uncommitted[i][j];
+          latestLength[i][j] = uncommittedLength[i][j];
+        }
+  }
+
+  memset(uncommitted, 0, sizeof(uncommitted));
+  saveFailed = false;
+  stats.size = journalEnd + sizeof(JournalRecord);
+  journalSeq++;
+  stats.appendTime = micros() - start;
+
+  if(!result)
+  {
+    stats.failures++;
+    if(!journalCompact())
+    {
+      journalOn = false;
+      diskRemove(JOURNAL_PATH);
+    }
+  }
+  else if(stats.size > JOURNAL_MAX_SIZE) journalCompact();
+
+  return(result);
+}
+
+//
+// Discard all journaled preferences
+//
+void journalClear()
+{
+  if(journalFile) journalFile.close();
+  memset(latest, 0, sizeof(latest));
+  memset(uncommitted, 0, sizeof(uncommitted));
+  saveFailed = false;
+  diskRemove(JOURNAL_TEMP_PATH);
+
+  fs::File file = diskOpen(JOURNAL_PATH, "wb");
+  if(file) file.close();
+  stats.size = 0;
+}
+
+const JournalStats *journalGetStats()
+{
+  return(&stats);
+}
@@ -0,0 +1,32 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define JOURNAL_PATH       "/prefs.log"
+#define JOURNAL_TEMP_PATH  "/prefs.tmp"
+#define JOURNAL_SECTIONS    4     // Maximal number of sections
+#define JOURNAL_CHUNKS     16     // Maximal number of chunks per section
+#define JOURNAL_MAX_RECORD 512    // Maximal record payload (bytes)
+#define JOURNAL_MAX_SIZE   32768  // Journal size triggering compaction (bytes)
+
+typedef struct
+{
+  uint32_t appendTime;   // Last commit time (us)
+  uint32_t replayTime;   // Boot replay time (us)
+  uint32_t records;      // Records replayed at boot
+  uint32_t size;         // Current journal size (bytes)
+  uint32_t compactions;  // Number of compactions
+  uint32_t failures;     // Saves dropped after a failed write
+} JournalStats;
+
+bool journalInit();
+bool journalAvailable();
+size_t journalRead(uint8_t section, uint8_t chunk, void *buf, size_t size);
+bool journalWrite(uint8_t section, uint8_t chunk, const void *data, uint16_t length);
+bool journalCommit();
+void journalClear();
+const JournalStats *journalGetStats();
+
+#endif // JOURNAL_H
@@ -2,6 +2,8 @@
 #include "Themes.h"
 #include "Menu.h"
 #include "Draw.h"
+#include "Radio.h"
+#include "Format.h"
 
 static int getInterpolatedStrength(int rssi)
 {
@@ -47,6 +49,8 @@ static int getInterpolatedStrength(int rssi)
 //
 static void drawSmallScale(uint32_t freq, int y)
 {
+  drawWidget(DRAW_W_SCALE);
+
   const Band *band = getCurrentBand();
   const uint16_t scaleStart = 51;
   const uint16_t scaleEnd = 269;
@@ -60,14 +64,14 @@ static void drawSmallScale(uint32_t freq, int y)
   spr.setTextColor(TH.scale_text);
   spr.setTextDatum(MC_DATUM);
   if(band->bandType==FM_BAND_TYPE)
-    sprintf(lim, "%0.2f", band->minimumFreq/100.00);
+    fmtFixed(lim, band->minimumFreq, 2);
   else
-    sprintf(lim, "%u", band->minimumFreq);
+    fmtUInt(lim, band->minimumFreq);
   spr.drawString(lim, scaleStart-27, y, 2);
   if(band->bandType==FM_BAND_TYPE)
-    sprintf(lim, "%0.2f", band->maximumFreq/100.00);
+    fmtFixed(lim, band->maximumFreq, 2);
   else
-    sprintf(lim, "%u", band->maximumFreq);
+    fmtUInt(lim, band->maximumFreq);
   spr.drawString(lim, scaleEnd+27, y, 2);
 }
 
@@ -76,6 +80,8 @@ static void drawSmallScale(uint32_t freq, int y)
 //
 static void drawAltStereoIndicator(int x, int y, bool stereo = true)
 {
+  drawWidget(DRAW_W_STEREO);
+
   if(stereo)
   {
     spr.drawCircle(x - 4, y, 7, TH.stereo_icon);
@@ -86,6 +92,8 @@ static void drawAltStereoIndicator(int x, int y, bool stereo = true)
 
 static void drawLargeSMeter(int rssi, int strength, int x, int y)
 {
+  drawWidget(DRAW_W_SMETER);
+
   // S-Meter legend
   spr.setTextDatum(TC_DATUM);
   spr.setTextColor(TH.scale_text);
@@ -132,6 +140,8 @@ static void drawLargeSMeter(int rssi, int strength, int x, int y)
 
 static void drawLargeSNMeter(int snr, int x, int y)
 {
+  drawWidget(DRAW_W_SNMETER);
+
   spr.setTextColor(TH.scale_text);
   spr.setTextDatum(BL_DATUM);
   spr.drawString("N", x - 10, 12 + y, 2);
@@ -204,7 +214,7 @@ void drawLayoutSmeter(const char *statusLine1, const char *statusLine2)
   drawSideBar(currentCmd, ALT_MENU_OFFSET_X, ALT_MENU_OFFSET_Y, MENU_DELTA_X);
 
   // Indicate FM pilot detection (stereo indicator)
-  drawAltStereoIndicator(ALT_STEREO_OFFSET_X, ALT_STEREO_OFFSET_Y, (currentMode==FM) && rx.getCurrentPilot());
+  drawAltStereoIndicator(ALT_STEREO_OFFSET_X, ALT_STEREO_OFFSET_Y, (currentMode==FM) && radioPilot());
 
   if(currentCmd == CMD_SCAN)
   {
@@ -6,6 +6,12 @@
 #include "EIBI.h"
 #include "Ble.h"
 #include "Menu.h"
+#include "Format.h"
+#include "Radio.h"
+#include "Trace.h"
+#include "Scheduler.h"
+#include "Bank.h"
+#include "Bands.h"
 
 //
 // Bands Menu
@@ -20,28 +26,29 @@
 // at first time to RESET the preferences.
 //
 
-int bandIdx = 0;
+int bandIdx;
 
 // Band limits are expanded to align with the nearest tuning scale mark
 // Do not forget to update the bands table in the manual.md
-Band bands[] =
+// User bands loaded from BANDS_USER_PATH follow the built-in ones
+Band bands[BANDS_MAX] =
 {
-  {"VHF",  FM_BAND_TYPE, FM,   6400, 10800, 10390, 2, 0, 0, 0},
+  {"VHF",  FM_BAND_TYPE, FM,   6400, 10800, 10390, 2, 0, 0, 0, 0},
   // All band. LW, MW and SW (from 150kHz to 30MHz)
-  {"ALL",  SW_BAND_TYPE, AM,    150, 30000, 15000, 1, 4, 0, 0},
-  {"11M",  SW_BAND_TYPE, AM,  25600, 26100, 25850, 1, 4, 0, 0},
-  {"13M",  SW_BAND_TYPE, AM,  21500, 21900, 21650, 1, 4, 0, 0},
-  {"15M",  SW_BAND_TYPE, AM,  18900, 19100, 18950, 1, 4, 0, 0},
-  {"16M",  SW_BAND_TYPE, AM,  17400, 18100, 17650, 1, 4, 0, 0},
-  {"19M",  SW_BAND_TYPE, AM,  15100, 15900, 15450, 1, 4, 0, 0},
-  {"22M",  SW_BAND_TYPE, AM,  13500, 13900, 13650, 1, 4, 0, 0},
-  {"25M",  SW_BAND_TYPE, AM,  11000, 13000, 11850, 1, 4, 0, 0},
-  {"31M",  SW_BAND_TYPE, AM,   9000, 11000,  9650, 1, 4, 0, 0},
-  {"41M",  SW_BAND_TYPE, AM,   7000,  9000,  7300, 1, 4, 0, 0},
-  {"49M",  SW_BAND_TYPE, AM,   5000,  7000,  6000, 1, 4, 0, 0},
-  {"60M",  SW_BAND_TYPE, AM,   4000,  5100,  4950, 1, 4, 0, 0},
-  {"75M",  SW_BAND_TYPE, AM,   3500,  4000,  3950, 1, 4, 0, 0},
-  {"90M",  SW_BAND_TYPE, AM,   3000,  3500,  3300, 1, 4, 0, 0},
+  {"ALL",  SW_BAND_TYPE, AM,    150, 30000, 15000, 1, 4, 0, 0, 0},
+  {"11M",  SW_BAND_TYPE, AM,  25600, 26100, 25850, 1, 4, 0, 0, 0},
+  {"13M",  SW_BAND_TYPE, AM,  21500, 21900, 21650, 1, 4, 0, 0, 0},
+  {"15M",  SW_BAND_TYPE, AM,  18900, 19100, 18950, 1, 4, 0, 0, 0},
+  {"16M",  SW_BAND_TYPE, AM,  17400, 18100, 17650, 1, 4, 0, 0, 0},
+  {"19M",  SW_BAND_TYPE, AM,  15100, 15900, 15450, 1, 4, 0, 0, 0},
+  {"22M",  SW_BAND_TYPE, AM,  13500, 13900, 13650, 1, 4, 0, 0, 0},
+  {"25M",  SW_BAND_TYPE, AM,  11000, 13000, 11850, 1, 4, 0, 0, 0},
+  {"31M",  SW_BAND_TYPE, AM,   9000, 11000,  9650, 1, 4, 0, 0, 0},
+  {"41M",  SW_BAND_TYPE, AM,   7000,  9000,  7300, 1, 4, 0, 0, 0},
+  {"49M",  SW_BAND_TYPE, AM,   5000,  7000,  6000, 1, 4, 0, 0, 0},
+  {"60M",  SW_BAND_TYPE, AM,   4000,  5100,  4950, 1, 4, 0, 0, 0},
+  {"75M",  SW_BAND_TYPE, AM,   3500,  4000,  3950, 1, 4, 0, 0, 0},
+  {"90M",  SW_BAND_TYPE, AM,   3000,  3500,  3300, 1, 4, 0, 0, 0},
 //  {"25M",  SW_BAND_TYPE, AM,  11600, 12100, 11850, 1, 4, 0},
 //  {"31M",  SW_BAND_TYPE, AM,   9400,  9900,  9650, 1, 4, 0},
 //  {"41M",  SW_BAND_TYPE, AM,   7200,  7500,  7300, 1, 4, 0},
@@ -49,24 +56,31 @@ Band bands[] =
 //  {"60M",  SW_BAND_TYPE, AM,   4700,  5100,  4950, 1, 4, 0},
 //  {"75M",  SW_BAND_TYPE, AM,   3900,  4000,  3950, 1, 4, 0},
 //  {"90M",  SW_BAND_TYPE, AM,   3200,  3400,  3300, 1, 4, 0},
-  {"MW3",  MW_BAND_TYPE, AM,   1700,  3500,  2500, 1, 4, 0, 0},
-  {"MW2",  MW_BAND_TYPE, AM,    495,  1701,   783, 2, 4, 0, 0},
-  {"MW1",  MW_BAND_TYPE, AM,    150,  1800,   810, 3, 4, 0, 0},
-  {"160M", MW_BAND_TYPE, LSB,  1800,  2000,  1900, 5, 4, 0, 0},
-  {"80M",  SW_BAND_TYPE, LSB,  3500,  4000,  3800, 5, 4, 0, 0},
-  {"40M",  SW_BAND_TYPE, LSB,  7000,  7300,  7150, 5, 4, 0, 0},
-  {"30M",  SW_BAND_TYPE, LSB, 10000, 10200, 10125, 5, 4, 0, 0},
-  {"20M",  SW_BAND_TYPE, USB, 14000, 14400, 14100, 5, 4, 0, 0},
-  {"17M",  SW_BAND_TYPE, USB, 18000, 18200, 18115, 5, 4, 0, 0},
-  {"15M",  SW_BAND_TYPE, USB, 21000, 21500, 21225, 5, 4, 0, 0},
-  {"12M",  SW_BAND_TYPE, USB, 24800, 25000, 24940, 5, 4, 0, 0},
-  {"10M",  SW_BAND_TYPE, USB, 28000, 29700, 28500, 5, 4, 0, 0},
+  {"MW3",  MW_BAND_TYPE, AM,   1700,  3500,  2500, 1, 4, 0, 0, 0},
+  {"MW2",  MW_BAND_TYPE, AM,    495,  1701,   783, 2, 4, 0, 0, 0},
+  {"MW1",  MW_BAND_TYPE, AM,    150,  1800,   810, 3, 4, 0, 0, 0},
+  {"160M", MW_BAND_TYPE, LSB,  1800,  2000,  1900, 5, 4, 0, 0, 0},
+  {"80M",  SW_BAND_TYPE, LSB,  3500,  4000,  3800, 5, 4, 0, 0, 0},
+  {"40M",  SW_BAND_TYPE, LSB,  7000,  7300,  7150, 5, 4, 0, 0, 0},
+  {"30M",  SW_BAND_TYPE, LSB, 10000, 10200, 10125, 5, 4, 0, 0, 0},
+  {"20M",  SW_BAND_TYPE, USB, 14000, 14400, 14100, 5, 4, 0, 0, 0},
+  {"17M",  SW_BAND_TYPE, USB, 18000, 18200, 18115, 5, 4, 0, 0, 0},
+  {"15M",  SW_BAND_TYPE, USB, 21000, 21500, 21225, 5, 4, 0, 0, 0},
+  {"12M",  SW_BAND_TYPE, USB, 24800, 25000, 24940, 5, 4, 0, 0, 0},
+  {"10M",  SW_BAND_TYPE, USB, 28000, 29700, 28500, 5, 4, 0, 0, 0},
   // https://www.hfunderground.com/wiki/CB
   // Also see MIN_CB_FREQUENCY and MAX_CB_FREQUENCY
-  {"CB",   SW_BAND_TYPE, AM,  25000, 28000, 27135, 0, 4, 0, 0},
+  {"CB",   SW_BAND_TYPE, AM,  25000, 28000, 27135, 0, 4, 0, 0, 0},
 };
 
-int getTotalBands() { return(ITEM_COUNT(bands)); }
+// Number of built-in and user bands
+static int bandCount = []() {
+  int n = 0;
+  while(n < BANDS_MAX && bands[n].bandName) n++;
+  return(n);
+}();
+
+int getTotalBands() { return(bandCount); }
 Band *getCurrentBand() { return(&bands[bandIdx]); }
 
 //
@@ -184,7 +198,7 @@ int getTotalMemories() { return(ITEM_COUNT(memories)); }
 // RDS Menu
 //
 
-uint8_t rdsModeIdx = 0;
+uint8_t rdsModeIdx;
 static const RDSMode rdsMode[] =
 {
   { RDS_PS, "PS"},
@@ -198,21 +212,24 @@ static const RDSMode rdsMode[] =
 };
 
 uint8_t getRDSMode() { return(rdsMode[rdsModeIdx].mode); }
+int getTotalRDSModes() { return(ITEM_COUNT(rdsMode)); }
 
 //
 // Sleep Mode Menu
 //
 
-uint8_t sleepModeIdx = SLEEP_LOCKED;
+uint8_t sleepModeIdx;
 static const char *sleepModeDesc[] =
 { "Locked", "Unlocked", "CPU Sleep" };
 
+int getTotalSleepModes() { return(ITEM_COUNT(sleepModeDesc)); }
+
 //
 // UTC Offset Menu
 // https://en.wikipedia.org/wiki/List_of_UTC_offsets
 // https://www.timeanddate.com/time/time-zones-interesting.html
 //
-uint8_t utcOffsetIdx = 8;
+uint8_t utcOffsetIdx;
 const UTCOffset utcOffsets[] =
 {
   { -12 * 4, "UTC-12" },
@@ -263,15 +280,17 @@ int getTotalUTCOffsets() { return(ITEM_COUNT(utcOffsets)); }
 //
 // UI Layout Menu
 //
-uint8_t uiLayoutIdx = 0;
+uint8_t uiLayoutIdx;
 static const char *uiLayoutDesc[] =
 { "Default", "S-Meter", "Signal scale" };
 
+int getTotalUILayouts() { return(ITEM_COUNT(uiLayoutDesc)); }
+
 //
 // USB Port Mode Menu
 //
 
-uint8_t usbModeIdx = USB_OFF;
+uint8_t usbModeIdx;
 static const char *usbModeDesc[] =
 { "Off", "Ad hoc" };
 
@@ -281,7 +300,7 @@ int getTotalUSBModes() { return(ITEM_COUNT(usbModeDesc)); }
 // Bluetooth Mode Menu
 //
 
-uint8_t bleModeIdx = BLE_OFF;
+uint8_t bleModeIdx;
 static const char *bleModeDesc[] =
 { "Off", "Ad hoc" };
 
@@ -291,10 +310,12 @@ int getTotalBleModes() { return(ITEM_COUNT(bleModeDesc)); }
 // WiFi Mode Menu
 //
 
-uint8_t wifiModeIdx = NET_OFF;
+uint8_t wifiModeIdx;
 static const char *wifiModeDesc[] =
 { "Off", "AP Only", "AP+Connect", "Connect", "Sync Only" };
 
+int getTotalWiFiModes() { return(ITEM_COUNT(wifiModeDesc)); }
+
 //
 // Step Menu
 //
@@ -450,27 +471,50 @@ const Bandwidth *getCurrentBandwidth()
   return(&bandwidths[currentMode][bands[bandIdx].bandwidthIdx > getLastBandwidth(currentMode) ? defaultBwIdx[currentMode] : bands[bandIdx].bandwidthIdx]);
 }
 
+//
+// Add a user band after the built-in ones, with default step and
+// bandwidth. Returns FALSE if there is no room left.
+//
+bool addBand(const char *name, uint8_t type, uint8_t mode, uint16_t minFreq, uint16_t maxFreq, uint16_t freq)
+{
+  if(bandCount >= BANDS_MAX || mode > AM) return(false);
+
+  Band *band = &bands[bandCount++];
+  memset(band, 0, sizeof(*band));
+  band->bandName       = name;
+  band->bandType       = type;
+  band->bandMode       = mode;
+  band->minimumFreq    = minFreq;
+  band->maximumFreq    = maxFreq;
+  band->currentFreq    = freq;
+  band->currentStepIdx = defaultStepIdx[mode];
+  band->bandwidthIdx   = defaultBwIdx[mode];
+  return(true);
+}
+
 static void setBandwidth()
 {
   uint8_t idx = getCurrentBandwidth()->idx;
 
-  switch(currentMode)
-  {
-    case FM:
-      rx.setFmBandwidth(idx);
-      break;
-    case AM:
-      rx.setBandwidth(idx, 1);
-      break;
-    case LSB:
-    case USB:
-      // Set Audio
-      rx.setSSBAudioBandwidth(idx);
-      // If audio bandwidth selected is about 2 kHz or below, it is
-      // recommended to set Sideband Cutoff Filter to 0.
-      rx.setSSBSidebandCutoffFilter(idx==0 || idx==4 || idx==5? 0 : 1);
-      break;
-  }
+  radioPost([](int32_t idx, int32_t mode) {
+    switch(mode)
+    {
+      case FM:
+        rx.setFmBandwidth(idx);
+        break;
+      case AM:
+        rx.setBandwidth(idx, 1);
+        break;
+      case LSB:
+      case USB:
+        // Set Audio
+        rx.setSSBAudioBandwidth(idx);
+        // If audio bandwidth selected is about 2 kHz or below, it is
+        // recommended to set Sideband Cutoff Filter to 0.
+        rx.setSSBSidebandCutoffFilter(idx==0 || idx==4 || idx==5? 0 : 1);
+        break;
+    }
+  }, idx, currentMode);
 }
 
 // Seek mode. Pass true to toggle, false to return the current one
@@ -519,7 +563,7 @@ void doSelectDigit(int16_t enc)
 void doVolume(int16_t enc)
 {
   volume = clamp_range(volume, enc, 0, 63);
-  if(!muteOn(MUTE_MAIN)) rx.setVolume(volume);
+  if(!muteOn(MUTE_MAIN)) radioPost([](int32_t vol, int32_t) { rx.setVolume(vol); }, volume);
 }
 
 static void clickVolume(bool shortPress)
@@ -576,7 +620,7 @@ void doAvc(int16_t enc)
   {
     AmAvcIdx = newAvcIdx;
   }
-  rx.setAvcAmMaxGain(newAvcIdx);
+  radioPost([](int32_t gain, int32_t) { rx.setAvcAmMaxGain(gain); }, newAvcIdx);
 }
 
 void doFmRegion(int16_t enc)
@@ -585,7 +629,7 @@ void doFmRegion(int16_t enc)
   if(currentMode!=FM) return;
 
   FmRegionIdx = wrap_range(FmRegionIdx, enc, 0, LAST_ITEM(fmRegions));
-  rx.setFMDeEmphasis(fmRegions[FmRegionIdx].value);
+  radioPost([](int32_t value, int32_t) { rx.setFMDeEmphasis(value); }, fmRegions[FmRegionIdx].value);
 }
 
 void doCal(int16_t enc)
@@ -624,9 +668,8 @@ static void doUSBMode(int16_t enc)
 
 static void doBleMode(int16_t enc)
 {
-  uint8_t newBleModeIdx = wrap_range(bleModeIdx, enc, 0, LAST_ITEM(bleModeDesc));
-  bleInit(newBleModeIdx);
-  bleModeIdx = newBleModeIdx;
+  bleModeIdx = wrap_range(bleModeIdx, enc, 0, LAST_ITEM(bleModeDesc));
+  bleRequestInit();
 }
 
 static void doWiFiMode(int16_t enc)
@@ -637,7 +680,9 @@ static void doWiFiMode(int16_t enc)
 static void clickWiFiMode(uint8_t mode, bool shortPress)
 {
   currentCmd = CMD_NONE;
-  netInit(mode);
+
+  // The boot task may still be bringing WiFi up, connect after it
+  if(bootIsDone()) netInit(mode); else netRequestConnect();
 }
 
 static void doRDSMode(int16_t enc)
@@ -669,6 +714,54 @@ uint8_t doAbout(int16_t enc)
   return aboutScreen;
 }
 
+// Band selection waiting for the menu to settle
+static bool bandPending = false;
+static int bandPendingBfo = 0;
+static uint8_t settleJob = SCHED_MAX_JOBS;
+
+//
+// Register the job applying deferred band selections, call this from
+// setup()
+//
+void menuInit()
+{
+  settleJob = schedAdd([]() { return(applyBand()); }, 0, false);
+}
+
+//
+// Show given band right away, but only reconfigure the receiver once
+// the selection has not changed for SCHED_SETTLE_TIME. Scrolling the
+// band, mode and memory menus then does not load SSB patches or retune
+// for every item passed.
+//
+static void deferBand(uint8_t idx, int bfo = 0)
+{
+  bandIdx = min((int)idx, getTotalBands() - 1);
+  currentMode = bands[bandIdx].bandMode;
+  currentFrequency = bands[bandIdx].currentFreq;
+  currentBFO = 0;
+
+  bandPending = true;
+  bandPendingBfo = bfo;
+  schedStart(settleJob, SCHED_SETTLE_TIME);
+}
+
+//
+// Apply deferred band selection, if any. Returns TRUE if applied.
+//
+bool applyBand()
+{
+  if(!bandPending) return(false);
+
+  bandPending = false;
+  schedStop(settleJob);
+  selectBand(bandIdx);
+
+  // Update BFO if present in memory slot
+  if(bandPendingBfo) updateBFO(bandPendingBfo);
+  return(true);
+}
+
 bool tuneToMemory(const Memory *memory)
 {
   uint16_t freq = freqFromHz(memory->freq, memory->mode);
@@ -684,28 +777,25 @@ bool tuneToMemory(const Memory *memory)
   if(!isMemoryInBand(&bands[memory->band], memory)) return(false);
 
   // Must differ from the current band, frequency and modulation
-  // FIXME: bands should store frequency in Hz (otherwise sub-kHz
-  // digits are lost after a power cycle)
-  if(memory->band==bandIdx && freq==bands[bandIdx].currentFreq && memory->mode==bands[bandIdx].bandMode)
+  if(memory->band==bandIdx && freq==bands[bandIdx].currentFreq &&
+     bfo==bands[bandIdx].currentBFO && memory->mode==bands[bandIdx].bandMode)
     return(true);
 
   // Save current band settings
-  bands[bandIdx].currentFreq = currentFrequency + currentBFO / 1000;
+  storeBandFreq(&bands[bandIdx]);
 
   // Use default step when changing modes
   if(bands[memory->band].bandMode != memory->mode)
     bands[memory->band].currentStepIdx = defaultStepIdx[memory->mode];
 
-  // Load frequency and modulation from memory slot
+  // Load frequency and modulation from memory slot, BFO is applied
+  // once the band is enabled
   bands[memory->band].currentFreq = freq;
+  bands[memory->band].currentBFO  = 0;
   bands[memory->band].bandMode    = memory->mode;
 
-  // Enable the new band
-  selectBand(memory->band);
-
-  // Update BFO if present in memory slot
-  if(bfo) updateBFO(bfo);
-
+  // Enable the new band and BFO, once the selection settles
+  deferBand(memory->band, bfo);
   return(true);
 }
 
@@ -726,6 +816,8 @@ static void clickMemory(uint8_t idx, bool shortPress)
     if(!memories[idx].freq) memories[idx] = newMemory;
     // Otherwise, delete memory slot contents
     else memories[idx].freq = 0;
+
+    bankSyncMemories();
   }
   // On a click, do nothing, slot already activated in doMemory()
   else currentCmd = CMD_NONE;
@@ -738,13 +830,15 @@ void doStep(int16_t enc)
   idx = wrap_range(idx, enc, 0, getLastStep(currentMode));
   bands[bandIdx].currentStepIdx = idx;
 
-  rx.setFrequencyStep(steps[currentMode][idx].step);
+  radioPost([](int32_t mode, int32_t idx) {
+    rx.setFrequencyStep(steps[mode][idx].step);
 
-  // Set seek spacing
-  if(currentMode==FM)
-    rx.setSeekFmSpacing(steps[currentMode][idx].spacing);
-  else
-    rx.setSeekAmSpacing(steps[currentMode][idx].spacing);
+    // Set seek spacing
+    if(mode==FM)
+      rx.setSeekFmSpacing(steps[mode][idx].spacing);
+    else
+      rx.setSeekAmSpacing(steps[mode][idx].spacing);
+  }, currentMode, idx);
 }
 
 void doAgc(int16_t enc)
@@ -766,7 +860,7 @@ void doAgc(int16_t enc)
   agcNdx     = agcIdx>1? agcIdx - 1 : 0;
 
   // Configure SI4732/5 (if agcNdx = 0, no attenuation)
-  rx.setAutomaticGainControl(disableAgc, agcNdx);
+  radioSetAgc(disableAgc, agcNdx);
 }
 
 void doMode(int16_t enc)
@@ -783,13 +877,13 @@ void doMode(int16_t enc)
   while(currentMode==FM);
 
   // Save current band settings
-  bands[bandIdx].currentFreq = currentFrequency + currentBFO / 1000;
+  storeBandFreq(&bands[bandIdx]);
   bands[bandIdx].currentStepIdx = defaultStepIdx[currentMode];
   bands[bandIdx].bandwidthIdx = defaultBwIdx[currentMode];
   bands[bandIdx].bandMode = currentMode;
 
-  // Enable the new band
-  selectBand(bandIdx);
+  // Enable the new band, once the selection settles
+  deferBand(bandIdx);
 }
 
 void doSquelch(int16_t enc)
@@ -807,20 +901,17 @@ void doSoftMute(int16_t enc)
   else
     softMuteMaxAttIdx = AmSoftMuteIdx = wrap_range(AmSoftMuteIdx, enc, 0, 32);
 
-  rx.setAmSoftMuteMaxAttenuation(softMuteMaxAttIdx);
+  radioPost([](int32_t att, int32_t) { rx.setAmSoftMuteMaxAttenuation(att); }, softMuteMaxAttIdx);
 }
 
 void doBand(int16_t enc)
 {
   // Save current band settings
-  bands[bandIdx].currentFreq = currentFrequency + currentBFO / 1000;
+  storeBandFreq(&bands[bandIdx]);
   bands[bandIdx].bandMode = currentMode;
 
-  // Change band
-  bandIdx = wrap_range(bandIdx, enc, 0, LAST_ITEM(bands));
-
-  // Enable the new band
-  selectBand(bandIdx);
+  // Enable the new band, once the selection settles
+  deferBand(wrap_range(bandIdx, enc, 0, getTotalBands() - 1));
 }
 
 void doBandwidth(int16_t enc)
@@ -992,12 +1083,14 @@ bool clickHandler(uint16_t cmd, bool shortPress)
 
 void selectBand(uint8_t idx, bool drawLoadingSSB)
 {
+  TRACE_SCOPE(TRACE_BAND, idx);
+
   // Silence click on some hardware versions
   // https://github.com/esp32-si4732/ats-mini/discussions/103
   muteOn(MUTE_TEMP, true);
 
   // Set band and mode
-  bandIdx = min(idx, LAST_ITEM(bands));
+  bandIdx = min((int)idx, getTotalBands() - 1);
   currentMode = bands[bandIdx].bandMode;
 
   // Load SSB patch as needed
@@ -1009,6 +1102,9 @@ void selectBand(uint8_t idx, bool drawLoadingSSB)
   // Switch radio to the selected band
   useBand(&bands[bandIdx]);
 
+  // Restore sub-kHz SSB tuning saved with the band
+  if(isSSB() && bands[bandIdx].currentBFO) updateBFO(bands[bandIdx].currentBFO);
+
   // Set bandwidth for the current mode
   setBandwidth();
 
@@ -1185,7 +1281,7 @@ static void drawBand(int x, int y, int sx)
 {
   drawCommon(menu[MENU_BAND], x, y, sx, true);
 
-  int count = ITEM_COUNT(bands);
+  int count = getTotalBands();
   for(int i=-2 ; i<3 ; i++)
   {
     if(i==0) {
@@ -1396,7 +1492,7 @@ static void drawUTCOffset(int x, int y, int sx)
 static void drawMemory(int x, int y, int sx)
 {
   char label_memory[16];
-  sprintf(label_memory, "%s %2.2d", menu[MENU_MEMORY], memoryIdx + 1);
+  fmtInt(fmtStr(fmtStr(label_memory, menu[MENU_MEMORY]), " "), memoryIdx + 1, 2);
   drawCommon(label_memory, x, y, sx, true);
 
   int count = ITEM_COUNT(memories);
@@ -1409,9 +1505,9 @@ static void drawMemory(int x, int y, int sx)
     if(!memories[j].freq)
       text = "- - -";
     else if(memories[j].mode==FM)
-      sprintf(buf, "%3.2f %s", memories[j].freq / 1000000.0, bandModeDesc[memories[j].mode]);
+      fmtStr(fmtStr(fmtFixed(buf, (memories[j].freq + 5000) / 10000, 2), " "), bandModeDesc[memories[j].mode]);
     else
-      sprintf(buf, "%5lu %s", memories[j].freq / 1000, bandModeDesc[memories[j].mode]);
+      fmtStr(fmtStr(fmtUInt(buf, memories[j].freq / 1000, 5, ' '), " "), bandModeDesc[memories[j].mode]);
 
     if(i==0) {
       drawZoomedMenu(text);
@@ -1462,7 +1558,7 @@ static void drawAgc(int x, int y, int sx)
   else
   {
     char text[16];
-    sprintf(text, "%2.2d", agcNdx);
+    fmtInt(text, agcNdx, 2);
     spr.drawString(text, 40+x+(sx/2), 60+y, 7);
   }
 }
@@ -1626,7 +1722,7 @@ static void drawInfo(int x, int y, int sx)
   }
   else
   {
-    sprintf(text, "%2.2d", agcNdx);
+    fmtInt(text, agcNdx, 2);
     spr.drawString("Att:", 6+x, 64+y+(-1*16), 2);
     spr.drawString(text, 48+x, 64+y+(-1*16), 2);
   }
@@ -1635,7 +1731,10 @@ static void drawInfo(int x, int y, int sx)
   if(muteOn(MUTE_MAIN) || muteOn(MUTE_SQUELCH))
   {
     spr.setTextColor(TH.box_off_text, TH.box_off_bg);
-    sprintf(text, muteOn(MUTE_MAIN) ? "Muted" : "%d/sq", volume);
+    if(muteOn(MUTE_MAIN))
+      fmtStr(text, "Muted");
+    else
+      fmtStr(fmtInt(text, volume), "/sq");
     spr.drawString(text, 48+x, 64+y+(0*16), 2);
     spr.setTextColor(TH.box_text);
   }
@@ -1649,7 +1748,7 @@ static void drawInfo(int x, int y, int sx)
   uint16_t piCode = getRdsPiCode();
   if(piCode && currentMode == FM)
   {
-    sprintf(text, "%04X", piCode);
+    fmtHex(text, piCode, 4);
     spr.drawString("PI:", 6+x, 64+y + (1*16), 2);
     spr.drawString(text, 48+x, 64+y + (1*16), 2);
   }
@@ -1658,11 +1757,11 @@ static void drawInfo(int x, int y, int sx)
     spr.drawString("AVC:", 6+x, 64+y + (1*16), 2);
 
     if(currentMode==FM)
-      sprintf(text, "n/a");
+      fmtStr(text, "n/a");
     else if(isSSB())
-      sprintf(text, "%2.2ddB", SsbAvcIdx);
+      fmtStr(fmtInt(text, SsbAvcIdx, 2), "dB");
     else
-      sprintf(text, "%2.2ddB", AmAvcIdx);
+      fmtStr(fmtInt(text, AmAvcIdx, 2), "dB");
 
     spr.drawString(text, 48+x, 64+y + (1*16), 2);
   }
@@ -1682,6 +1781,8 @@ void drawSideBar(uint16_t cmd, int x, int y, int sx)
 {
   if(sleepOn()) return;
 
+  drawWidget(DRAW_W_SIDEBAR);
+
   switch(cmd)
   {
     case CMD_MENU:       drawMenu(x, y, sx);       break;
@@ -107,7 +107,11 @@ bool doSideBar(uint16_t cmd, int16_t enc, int16_t enca);
 void doSelectDigit(int16_t enc);
 bool clickHandler(uint16_t cmd, bool shortPress);
 void selectBand(uint8_t idx, bool drawLoadingSSB = true);
+bool applyBand();
+bool tuneToMemory(const Memory *memory);
+void menuInit();
 int getTotalBands();
+bool addBand(const char *name, uint8_t type, uint8_t mode, uint16_t minFreq, uint16_t maxFreq, uint16_t freq);
 int getTotalModes();
 int getTotalMemories();
 Band *getCurrentBand();
@@ -121,6 +125,11 @@ int getCurrentUTCOffset();
 int getTotalUTCOffsets();
 int getTotalFmRegions();
 int getTotalBleModes();
+int getTotalUSBModes();
+int getTotalWiFiModes();
+int getTotalRDSModes();
+int getTotalSleepModes();
+int getTotalUILayouts();
 
 void doSoftMute(int16_t enc);
 void doAgc(int16_t enc);
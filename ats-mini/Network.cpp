@@ -4,6 +4,12 @@
 #include "Utils.h"
 #include "Menu.h"
 #include "Draw.h"
+#include "Profile.h"
+#include "Cpu.h"
+#include "Bank.h"
+#include "Settings.h"
+#include "Heap.h"
+#include "Arena.h"
 
 #include <WiFi.h>
 #include <WiFiMulti.h>
@@ -12,8 +18,13 @@
 #include <ESPAsyncWebServer.h>
 #include <NTPClient.h>
 #include <ESPmDNS.h>
+#include <atomic>
+#include <memory>
+#include <stdarg.h>
 
 #define CONNECT_TIME  3000  // Time of inactivity to start connecting WiFi
+#define WEB_CHANNELS   200  // Maximal number of channels on a page
+#define WEB_ROW_SIZE   512  // Page space kept for a channel row and the end
 
 WiFiMulti wifiMulti;
 
@@ -29,8 +40,14 @@ static const int   apClients = 3;       // Maximum simultaneous connected client
 static uint16_t ajaxInterval = 2500;
 
 static bool itIsTimeToWiFi = false; // TRUE: Need to connect to WiFi
+static bool initPending = false;    // TRUE: Need to restart WiFi in the current mode
 static uint32_t connectTime = millis();
 
+// Settings changed from the web page, one bit per setting index. The
+// web server runs on its own task, so their apply hooks are left to
+// netTickTime() on the main loop.
+static std::atomic<uint32_t> webApplyPending(0);
+
 // Settings
 String loginUsername = "";
 String loginPassword = "";
@@ -42,20 +59,78 @@ AsyncWebServer server(80);
 WiFiUDP ntpUDP;
 NTPClient ntpClient(ntpUDP, "pool.ntp.org");
 
-static bool wifiInitAP();
-static bool wifiConnect();
+static bool wifiInitAP(bool showStatus);
+static bool wifiConnect(bool showStatus);
 static void webInit();
 
 static void webSetConfig(AsyncWebServerRequest *request);
 
-static const String webInputField(const String &name, const String &value, bool pass = false);
-static const String webStyleSheet();
-static const String webPage(const String &body);
-static const String webUtcOffsetSelector();
-static const String webThemeSelector();
-static const String webRadioPage();
-static const String webMemoryPage();
-static const String webConfigPage();
+//
+// Web page, built in a block from the web arena region rather than in
+// Strings on the internal heap. Text past the end of the block is cut.
+//
+class WebPage : public Print
+{
+  public:
+    WebPage() : data((char *)arenaGet(ARENA_WEB, WEB_PAGE_SIZE)), length(0) {}
+    ~WebPage() { arenaPut(data); }
+
+    size_t write(uint8_t c) { return(write(&c, 1)); }
+
+    size_t write(const uint8_t *buffer, size_t size)
+    {
+      size = min(size, room());
+      if(size) memcpy(data + length, buffer, size);
+      length += size;
+      return(size);
+    }
+
+    void add(const char *text) { write((const uint8_t *)text, strlen(text)); }
+
+    void addf(const char *format, ...)
+    {
+      va_list args;
+
+      if(!room()) return;
+      va_start(args, format);
+      int size = vsnprintf(data + length, room() + 1, format, args);
+      va_end(args);
+      if(size > 0) length += min((size_t)size, room());
+    }
+
+    // Attribute value, with quotes escaped
+    void addValue(const char *text)
+    {
+      for( ; *text ; text++)
+        if(*text == '"') add("&quot;");
+        else if(*text == '\'') add("&apos;");
+        else write(*text);
+    }
+
+    // Space left, one byte is kept for vsnprintf()'s terminator
+    size_t room() const { return(data? WEB_PAGE_SIZE - 1 - length : 0); }
+
+    // Hand the block over, it is then up to the caller to arenaPut() it
+    char *release(size_t *size)
+    {
+      char *result = data;
+      *size = length;
+      data = NULL;
+      return(result);
+    }
+
+  private:
+    char *data;
+    size_t length;
+};
+
+typedef void (*WebPageFunc)(WebPage &page, AsyncWebServerRequest *request);
+
+static void webRadioPage(WebPage &page, AsyncWebServerRequest *request);
+static void webMemoryPage(WebPage &page, AsyncWebServerRequest *request);
+static void webChannelsPage(WebPage &page, AsyncWebServerRequest *request);
+static void webConfigPage(WebPage &page, AsyncWebServerRequest *request);
+static void webProfilePage(WebPage &page, AsyncWebServerRequest *request);
 
 //
 // Delayed WiFi connection
@@ -66,8 +141,34 @@ void netRequestConnect()
   itIsTimeToWiFi = true;
 }
 
-void netTickTime()
+//
+// Restart WiFi in the current mode, once netTickTime() runs on the
+// main loop after the boot task is done with WiFi
+//
+void netRequestInit()
 {
+  initPending = true;
+}
+
+bool netTickTime()
+{
+  // Apply settings changed from the web page
+  uint32_t pending = webApplyPending.exchange(0);
+  bool changed = pending != 0;
+
+  for(uint8_t i = 0 ; pending ; i++, pending >>= 1)
+  {
+    const Setting *s = settingsGet(i);
+    if((pending & 1) && s->apply) s->apply();
+  }
+
+  // Restart WiFi if its mode has changed remotely
+  if(initPending)
+  {
+    initPending = false;
+    netInit(wifiModeIdx);
+  }
+
   // Connect to WiFi if requested
   if(itIsTimeToWiFi && ((millis() - connectTime) > CONNECT_TIME))
   {
@@ -75,6 +176,8 @@ void netTickTime()
     connectTime = millis();
     itIsTimeToWiFi = false;
   }
+
+  return(changed);
 }
 
 //
@@ -134,6 +237,9 @@ void netInit(uint8_t netMode, bool showStatus)
   // Always disable WiFi first
   netStop();
 
+  // Keep track of the heap taken by WiFi and services
+  HeapMark mark = heapMark();
+
   switch(netMode)
   {
     case NET_OFF:
@@ -143,13 +249,13 @@ void netInit(uint8_t netMode, bool showStatus)
       // Start WiFi access point if requested
       WiFi.mode(WIFI_AP);
       // Let user see connection status if successful
-      if(wifiInitAP() && showStatus) delay(2000);
+      if(wifiInitAP(showStatus) && showStatus) delay(2000);
       break;
     case NET_AP_CONNECT:
       // Start WiFi access point if requested
       WiFi.mode(WIFI_AP_STA);
       // Let user see connection status if successful
-      if(wifiInitAP() && showStatus) delay(2000);
+      if(wifiInitAP(showStatus) && showStatus) delay(2000);
       break;
     default:
       // No access point
@@ -158,7 +264,7 @@ void netInit(uint8_t netMode, bool showStatus)
   }
 
   // Initialize WiFi and try connecting to a network
-  if(netMode>NET_AP_ONLY && wifiConnect())
+  if(netMode>NET_AP_ONLY && wifiConnect(showStatus))
   {
     // Let user see connection status if successful
     if(netMode!=NET_SYNC && showStatus) delay(2000);
@@ -188,6 +294,8 @@ void netInit(uint8_t netMode, bool showStatus)
     MDNS.begin("atsmini"); // Set the hostname to "atsmini.local"
     MDNS.addService("http", "tcp", 80);
   }
+
+  heapUsed(HEAP_WIFI, &mark);
 }
 
 //
@@ -220,7 +328,7 @@ bool ntpSyncTime()
 //
 // Initialize WiFi access point (AP)
 //
-static bool wifiInitAP()
+static bool wifiInitAP(bool showStatus)
 {
   // These are our own access point (AP) addresses
   IPAddress ip(10, 1, 1, 1);
@@ -231,10 +339,11 @@ static bool wifiInitAP()
   WiFi.softAP(apSSID, apPWD, apChannel, apHideMe, apClients);
   WiFi.softAPConfig(ip, gateway, subnet);
 
-  drawScreen(
-    ("Use Access Point " + String(apSSID)).c_str(),
-    ("IP : " + WiFi.softAPIP().toString() + " or atsmini.local").c_str()
-  );
+  if(showStatus)
+    drawScreen(
+      ("Use Access Point " + String(apSSID)).c_str(),
+      ("IP : " + WiFi.softAPIP().toString() + " or atsmini.local").c_str()
+    );
 
   ajaxInterval = 2500;
   return(true);
@@ -243,10 +352,13 @@ static bool wifiInitAP()
 //
 // Connect to a WiFi network
 //
-static bool wifiConnect()
+static bool wifiConnect(bool showStatus)
 {
   String status = "Connecting to WiFi network...";
 
+  // May run on the boot task, so do not share the global preferences
+  Preferences prefs;
+
   // Clean credentials
   wifiMulti.APlistClean();
 
@@ -272,47 +384,86 @@ static bool wifiConnect()
   // Done with preferences
   prefs.end();
 
-  drawScreen(status.c_str());
+  if(showStatus) drawScreen(status.c_str());
 
   // If failed connecting to WiFi network...
   if (wifiMulti.run() != WL_CONNECTED)
   {
     // WiFi connection failed
-    drawScreen(status.c_str(), "No WiFi connection");
+    if(showStatus) drawScreen(status.c_str(), "No WiFi connection");
     // Done
     return(false);
   }
   else
   {
     // WiFi connection succeeded
-    drawScreen(
-      ("Connected to WiFi network (" + WiFi.SSID() + ")").c_str(),
-      ("IP : " + WiFi.localIP().toString() + " or atsmini.local").c_str()
-    );
+    if(showStatus)
+      drawScreen(
+        ("Connected to WiFi network (" + WiFi.SSID() + ")").c_str(),
+        ("IP : " + WiFi.localIP().toString() + " or atsmini.local").c_str()
+      );
     // Done
     ajaxInterval = 1000;
     return(true);
   }
 }
 
+//
+// Build a page and send it straight from its arena block, which goes
+// back to the pool once the response is done with it. Pages stay off
+// the heap, keep track of what the requests still take from it.
+//
+static void webSend(AsyncWebServerRequest *request, WebPageFunc build, const char *type = "text/html")
+{
+  HeapMark mark = heapMark();
+  WebPage page;
+  size_t length;
+
+  build(page, request);
+  std::shared_ptr<char> data(page.release(&length), arenaPut);
+
+  if(!data)
+    request->send(503, "text/plain", "Out of memory");
+  else
+    request->send(request->beginResponse(type, length, [data, length](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+      size_t size = min(maxLen, length - index);
+      memcpy(buffer, data.get() + index, size);
+      return(size);
+    }));
+
+  heapUsed(HEAP_WEB, &mark, length);
+}
+
 //
 // Initialize internal web server
 //
 static void webInit()
 {
   server.on("/", HTTP_ANY, [] (AsyncWebServerRequest *request) {
-    request->send(200, "text/html", webRadioPage());
+    webSend(request, webRadioPage);
   });
 
   server.on("/memory", HTTP_ANY, [] (AsyncWebServerRequest *request) {
-    request->send(200, "text/html", webMemoryPage());
+    webSend(request, webMemoryPage);
+  });
+
+  server.on("/channels", HTTP_ANY, [] (AsyncWebServerRequest *request) {
+    webSend(request, webChannelsPage);
+  });
+
+  server.on("/profile", HTTP_ANY, [] (AsyncWebServerRequest *request) {
+    webSend(request, webProfilePage);
+  });
+
+  server.on("/heap", HTTP_ANY, [] (AsyncWebServerRequest *request) {
+    webSend(request, [](WebPage &page, AsyncWebServerRequest *) { heapDump(&page); }, "text/plain");
   });
 
   server.on("/config", HTTP_ANY, [] (AsyncWebServerRequest *request) {
     if(loginUsername != "" && loginPassword != "")
       if(!request->authenticate(loginUsername.c_str(), loginPassword.c_str()))
         return request->requestAuthentication();
-    request->send(200, "text/html", webConfigPage());
+    webSend(request, webConfigPage);
   });
 
   server.onNotFound([] (AsyncWebServerRequest *request) {
@@ -326,6 +477,15 @@ static void webInit()
   server.begin();
 }
 
+//
+// Change a setting from the web task, see netTickTime()
+//
+static void webSettingWrite(const Setting *s, int32_t value)
+{
+  uint8_t idx = s - settingsGet(0);
+  if(settingWrite(s, value)) webApplyPending |= 1UL << idx;
+}
+
 void webSetConfig(AsyncWebServerRequest *request)
 {
   uint32_t prefsSave = 0;
@@ -366,8 +526,7 @@ void webSetConfig(AsyncWebServerRequest *request)
   if(request->hasParam("utcoffset", true))
   {
     String utcOffset = request->getParam("utcoffset", true)->value();
-    utcOffsetIdx = utcOffset.toInt();
-    clockRefreshTime();
+    webSettingWrite(settingsFind("UTCOffset"), utcOffset.toInt());
     prefsSave |= SAVE_SETTINGS;
   }
 
@@ -375,13 +534,23 @@ void webSetConfig(AsyncWebServerRequest *request)
   if(request->hasParam("theme", true))
   {
     String theme = request->getParam("theme", true)->value();
-    themeIdx = theme.toInt();
+    webSettingWrite(settingsFind("Theme"), theme.toInt());
     prefsSave |= SAVE_SETTINGS;
   }
 
-  // Save scroll direction and menu zoom
-  scrollDirection = request->hasParam("scroll", true)? -1 : 1;
-  zoomMenu        = request->hasParam("zoom", true);
+  // Save settings from the generated form fields, unchecked
+  // checkboxes are not sent at all
+  for(uint8_t i = 0 ; i < settingsCount() ; i++)
+  {
+    const Setting *s = settingsGet(i);
+
+    if(!(s->flags & SET_WEB))
+      continue;
+    else if(s->type == SET_BOOL || s->type == SET_DIR)
+      webSettingWrite(s, request->hasParam(s->key, true));
+    else if(request->hasParam(s->key, true))
+      webSettingWrite(s, request->getParam(s->key, true)->value().toInt());
+  }
   prefsSave |= SAVE_SETTINGS;
 
   // Done with the preferences
@@ -399,22 +568,23 @@ void webSetConfig(AsyncWebServerRequest *request)
     netRequestConnect();
 }
 
-static const String webInputField(const String &name, const String &value, bool pass)
+static void webInputField(WebPage &page, const char *name, const char *value, bool pass = false)
 {
-  String newValue(value);
-
-  newValue.replace("\"", "&quot;");
-  newValue.replace("'", "&apos;");
-
-  return(
-    "<INPUT TYPE='" + String(pass? "PASSWORD":"TEXT") + "' NAME='" +
-    name + "' VALUE='" + newValue + "'>"
-  );
+  page.addf("<INPUT TYPE='%s' NAME='%s' VALUE='", pass? "PASSWORD":"TEXT", name);
+  page.addValue(value);
+  page.add("'>");
 }
 
-static const String webStyleSheet()
+//
+// Saved network setting, empty if not there
+//
+static void webPrefsString(const char *key, char *value, size_t size)
 {
-  return
+  value[0] = '\0';
+  if(prefs.isKey(key)) prefs.getString(key, value, size);
+}
+
+static const char webStyleSheet[] =
 "BODY"
 "{"
   "margin: 0;"
@@ -461,166 +631,343 @@ static const String webStyleSheet()
   "text-align: center;"
 "}"
 ;
-}
 
-static const String webPage(const String &body)
+static void webPageBegin(WebPage &page)
 {
-  return
+  page.add(
 "<!DOCTYPE HTML>"
 "<HTML>"
 "<HEAD>"
   "<META CHARSET='UTF-8'>"
   "<META NAME='viewport' CONTENT='width=device-width, initial-scale=1.0'>"
   "<TITLE>ATS-Mini Config</TITLE>"
-  "<STYLE>" + webStyleSheet() + "</STYLE>"
+  "<STYLE>"
+  );
+  page.add(webStyleSheet);
+  page.add(
+  "</STYLE>"
 "</HEAD>"
-"<BODY STYLE='font-family: sans-serif;'>" + body + "</BODY>"
-"</HTML>"
-;
+"<BODY STYLE='font-family: sans-serif;'>"
+  );
 }
 
-static const String webUtcOffsetSelector()
+static void webPageEnd(WebPage &page)
 {
-  String result = "";
+  page.add("</BODY></HTML>");
+}
 
+static void webUtcOffsetSelector(WebPage &page)
+{
   for(int i=0 ; i<getTotalUTCOffsets(); i++)
-  {
-    char text[64];
-
-    sprintf(text,
+    page.addf(
       "<OPTION VALUE='%d'%s>%s</OPTION>",
       i, utcOffsetIdx==i? " SELECTED":"",
       utcOffsets[i].desc
     );
-
-    result += text;
-  }
-
-  return(result);
 }
 
-static const String webThemeSelector()
+static void webThemeSelector(WebPage &page)
 {
-  String result = "";
-
   for(int i=0 ; i<getTotalThemes(); i++)
-  {
-    char text[64];
-
-    sprintf(text,
+    page.addf(
       "<OPTION VALUE='%d'%s>%s</OPTION>",
        i, themeIdx==i? " SELECTED":"", theme[i].name
     );
+}
+
+//
+// Form fields for the settings marked for the web page
+//
+static void webSettingFields(WebPage &page)
+{
+  for(uint8_t i = 0 ; i < settingsCount() ; i++)
+  {
+    const Setting *s = settingsGet(i);
+
+    if(!(s->flags & SET_WEB)) continue;
 
-    result += text;
+    if(s->type == SET_BOOL || s->type == SET_DIR)
+      page.addf(
+        "<TR><TD CLASS='LABEL'>%s</TD><TD><INPUT TYPE='CHECKBOX' NAME='%s' VALUE='on'%s></TD></TR>",
+        s->label, s->key, settingRead(s)? " CHECKED" : ""
+      );
+    else
+      page.addf(
+        "<TR><TD CLASS='LABEL'>%s</TD><TD><INPUT TYPE='NUMBER' NAME='%s' VALUE='%ld' MIN='%d' MAX='%ld'></TD></TR>",
+        s->label, s->key, settingRead(s), s->min, settingMax(s)
+      );
   }
+}
 
-  return(result);
+//
+// Frequency in Hz, as shown on the web pages
+//
+static void webFrequency(WebPage &page, uint32_t freq, uint8_t mode)
+{
+  if(mode == FM)
+    page.addf("%.2fMHz %s", freq / 1000000.0, bandModeDesc[mode]);
+  else
+    page.addf("%.2fkHz %s", freq / 1000.0, bandModeDesc[mode]);
 }
 
-static const String webRadioPage()
+static void webRadioPage(WebPage &page, AsyncWebServerRequest *request)
 {
-  String ip = "";
-  String ssid = "";
-  String freq = currentMode == FM?
-    String(currentFrequency / 100.0) + "MHz "
-  : String(currentFrequency + currentBFO / 1000.0) + "kHz ";
+  IPAddress ip;
+  char ssid[33];
 
   if(WiFi.status()==WL_CONNECTED)
   {
-    ip = WiFi.localIP().toString();
-    ssid = WiFi.SSID();
+    wifi_ap_record_t info;
+    ip = WiFi.localIP();
+    ssid[0] = '\0';
+    if(esp_wifi_sta_get_ap_info(&info) == ESP_OK)
+      snprintf(ssid, sizeof(ssid), "%s", (const char *)info.ssid);
   }
   else
   {
-    ip = WiFi.softAPIP().toString();
-    ssid = String(apSSID);
+    ip = WiFi.softAPIP();
+    snprintf(ssid, sizeof(ssid), "%s", apSSID);
   }
 
-  return webPage(
+  webPageBegin(page);
+  page.addf(
 "<H1>ATS-Mini Pocket Receiver</H1>"
 "<P ALIGN='CENTER'>"
-  "<A HREF='/memory'>Memory</A>&nbsp;|&nbsp;<A HREF='/config'>Config</A>"
+  "<A HREF='/memory'>Memory</A>&nbsp;|&nbsp;<A HREF='/config'>Config</A>&nbsp;|&nbsp;<A HREF='/profile'>Profile</A>&nbsp;|&nbsp;<A HREF='/heap'>Heap</A>"
 "</P>"
 "<TABLE COLUMNS=2>"
 "<TR>"
   "<TD CLASS='LABEL'>IP Address</TD>"
-  "<TD><A HREF='http://" + ip + "'>" + ip + "</A> (" + ssid + ")</TD>"
+  "<TD><A HREF='http://%u.%u.%u.%u'>%u.%u.%u.%u</A> (%s)</TD>"
 "</TR>"
 "<TR>"
   "<TD CLASS='LABEL'>MAC Address</TD>"
-  "<TD>" + String(getMACAddress()) + "</TD>"
+  "<TD>%s</TD>"
 "</TR>"
 "<TR>"
   "<TD CLASS='LABEL'>Firmware</TD>"
-  "<TD>" + String(getVersion(true)) + "</TD>"
+  "<TD>%s</TD>"
 "</TR>"
 "<TR>"
   "<TD CLASS='LABEL'>Band</TD>"
-  "<TD>" + String(getCurrentBand()->bandName) + "</TD>"
+  "<TD>%s</TD>"
 "</TR>"
 "<TR>"
   "<TD CLASS='LABEL'>Frequency</TD>"
-  "<TD>" + freq + String(bandModeDesc[currentMode]) + "</TD>"
+  "<TD>",
+    ip[0], ip[1], ip[2], ip[3], ip[0], ip[1], ip[2], ip[3], ssid,
+    getMACAddress(), getVersion(true), getCurrentBand()->bandName
+  );
+
+  // FM frequencies are kept in 10kHz units, others in kHz plus BFO (Hz)
+  if(currentMode == FM)
+    webFrequency(page, currentFrequency * 10000UL, currentMode);
+  else
+    webFrequency(page, currentFrequency * 1000UL + currentBFO, currentMode);
+
+  page.addf(
+  "</TD>"
 "</TR>"
 "<TR>"
   "<TD CLASS='LABEL'>Signal Strength</TD>"
-  "<TD>" + String(rssi) + "dBuV</TD>"
+  "<TD>%ddBuV</TD>"
 "</TR>"
 "<TR>"
   "<TD CLASS='LABEL'>Signal to Noise</TD>"
-  "<TD>" + String(snr) + "dB</TD>"
+  "<TD>%ddB</TD>"
 "</TR>"
 "<TR>"
   "<TD CLASS='LABEL'>Battery Voltage</TD>"
-  "<TD>" + String(batteryMonitor()) + "V</TD>"
+  "<TD>%.2fV</TD>"
 "</TR>"
-"</TABLE>"
-);
+"</TABLE>",
+    rssi, snr, batteryMonitor()
+  );
+  webPageEnd(page);
 }
 
-static const String webMemoryPage()
+static void webMemoryPage(WebPage &page, AsyncWebServerRequest *request)
 {
-  String items = "";
+  webPageBegin(page);
+  page.add(
+"<H1>ATS-Mini Pocket Receiver Memory</H1>"
+"<P ALIGN='CENTER'>"
+  "<A HREF='/'>Status</A>&nbsp;|&nbsp;<A HREF='/channels'>Channels</A>&nbsp;|&nbsp;<A HREF='/config'>Config</A>"
+"</P>"
+"<TABLE COLUMNS=2>"
+  );
 
   for(int j=0 ; j<MEMORY_COUNT ; j++)
   {
-    char text[64];
-    sprintf(text, "<TR><TD CLASS='LABEL' WIDTH='10%%'>%02d</TD><TD>", j+1);
-    items += text;
+    page.addf("<TR><TD CLASS='LABEL' WIDTH='10%%'>%02d</TD><TD>", j+1);
 
     if(!memories[j].freq)
-      items += "&nbsp;---&nbsp;</TD></TR>";
+      page.add("&nbsp;---&nbsp;");
     else
-    {
-      String freq = memories[j].mode == FM?
-        String(memories[j].freq / 1000000.0) + "MHz "
-      : String(memories[j].freq / 1000.0) + "kHz ";
-      items += freq + bandModeDesc[memories[j].mode] + "</TD></TR>";
-    }
+      webFrequency(page, memories[j].freq, memories[j].mode);
+
+    page.add("</TD></TR>");
   }
 
-  return webPage(
-"<H1>ATS-Mini Pocket Receiver Memory</H1>"
+  page.add("</TABLE>");
+  webPageEnd(page);
+}
+
+//
+// Memory bank channels in a frequency range (from, to in kHz), at most
+// WEB_CHANNELS of them, optionally only of one group. The bank may
+// change while the page is generated, it then shows a mix of both.
+// Rows stop early when the page block runs short.
+//
+static void webChannelsPage(WebPage &page, AsyncWebServerRequest *request)
+{
+  uint32_t from = request->hasParam("from")? request->getParam("from")->value().toInt() * 1000 : 0;
+  uint32_t to   = request->hasParam("to")? request->getParam("to")->value().toInt() * 1000 : 0xFFFFFFFF;
+  uint8_t group = request->hasParam("group")? request->getParam("group")->value().toInt() : BANK_ANY;
+  uint16_t rows = 0;
+
+  webPageBegin(page);
+  page.add(
+"<H1>ATS-Mini Pocket Receiver Channels</H1>"
 "<P ALIGN='CENTER'>"
-  "<A HREF='/'>Status</A>&nbsp;|&nbsp;<A HREF='/config'>Config</A>"
+  "<A HREF='/'>Status</A>&nbsp;|&nbsp;<A HREF='/memory'>Memory</A>"
 "</P>"
-"<TABLE COLUMNS=2>" + items + "</TABLE>"
-);
+"<P ALIGN='CENTER'><A HREF='/channels'>All</A>"
+  );
+
+  for(uint8_t i = 0 ; i < BANK_GROUPS ; i++)
+    if(*bankGroupName(i))
+      page.addf("&nbsp;|&nbsp;<A HREF='/channels?group=%u'>%s</A>", i, bankGroupName(i));
+
+  page.add(
+"</P>"
+"<TABLE COLUMNS=4>"
+"<TR><TH>Frequency</TH><TH>Name</TH><TH>Group</TH><TH>Tags</TH></TR>"
+  );
+
+  // The main loop may change the bank meanwhile, bankGet() returns
+  // NULL past its end
+  const Channel *ch;
+  for(uint16_t pos = bankFindFreq(from) ; rows < WEB_CHANNELS && page.room() > WEB_ROW_SIZE && (ch = bankGet(BANK_BY_FREQ, pos)) ; pos++)
+  {
+    if(ch->freq > to) break;
+    if(group != BANK_ANY && ch->group != group) continue;
+
+    page.add("<TR><TD CLASS='LABEL'>");
+    webFrequency(page, ch->freq, ch->mode);
+    page.addf("</TD><TD>%s</TD><TD>%s</TD><TD>", ch->name, bankGroupName(ch->group));
+
+    for(uint8_t i = 0 ; i < BANK_TAGS ; i++)
+      if(ch->tags & (1 << i)) page.addf("%s ", bankTagName(i));
+
+    page.add("</TD></TR>");
+    rows++;
+  }
+
+  page.add("</TABLE>");
+  webPageEnd(page);
+}
+
+//
+// Main loop timing, statistics are read while the loop keeps updating
+// them, so numbers may be off by a sample
+//
+static void webProfilePage(WebPage &page, AsyncWebServerRequest *request)
+{
+  webPageBegin(page);
+  page.add(
+"<H1>ATS-Mini Pocket Receiver Profile</H1>"
+"<P ALIGN='CENTER'>"
+  "<A HREF='/'>Status</A>&nbsp;|&nbsp;<A HREF='/memory'>Memory</A>"
+"</P>"
+"<TABLE COLUMNS=5>"
+"<TR><TH>Phase</TH><TH>Count</TH><TH>Min (us)</TH><TH>Mean (us)</TH><TH>Max (us)</TH></TR>"
+  );
+
+  for(uint8_t i = 0 ; i < PROF_PHASES ; i++)
+  {
+    const ProfPhase *p = profGetPhase(i);
+
+    if(!p->count) continue;
+
+    page.addf("<TR><TD CLASS='LABEL'>%s</TD><TD>%lu</TD><TD>%lu</TD><TD>%lu</TD><TD>%lu</TD></TR>",
+              profPhaseName(i), p->count, p->min, (uint32_t)(p->sum / p->count), p->max);
+  }
+
+  page.add(
+"</TABLE>"
+"<H2>Histogram</H2>"
+"<TABLE COLUMNS=2>"
+  );
+
+  for(uint8_t i = 0 ; i < PROF_PHASES ; i++)
+  {
+    const ProfPhase *p = profGetPhase(i);
+
+    if(!p->count) continue;
+
+    page.addf("<TR><TD CLASS='LABEL'>%s</TD><TD>", profPhaseName(i));
+    for(uint8_t j = 0 ; j < PROF_BUCKETS ; j++)
+      if(p->hist[j]) page.addf("%luus:&nbsp;%lu ", 1UL << j, p->hist[j]);
+    page.add("</TD></TR>");
+  }
+
+  page.add(
+"</TABLE>"
+"<H2>Worst Stalls</H2>"
+"<TABLE COLUMNS=4>"
+"<TR><TH>Time (ms)</TH><TH>Loop (us)</TH><TH>Longest Phase</TH><TH>Phase (us)</TH></TR>"
+  );
+
+  for(uint8_t i = 0 ; i < PROF_STALLS ; i++)
+  {
+    const ProfStall *s = profGetStall(i);
+
+    if(!s) continue;
+
+    page.addf("<TR><TD CLASS='LABEL'>%lu</TD><TD>%lu</TD><TD>%s</TD><TD>%lu</TD></TR>",
+              s->time, s->duration, profPhaseName(s->phase), s->phaseTime);
+  }
+
+  page.add(
+"</TABLE>"
+"<H2>CPU Clock</H2>"
+"<TABLE COLUMNS=2>"
+  );
+
+  const CpuStats *cpu = cpuGetStats();
+
+  for(uint8_t i = 0 ; i < CPU_LEVELS ; i++)
+    page.addf("<TR><TD CLASS='LABEL'>%uMHz</TD><TD>%lus</TD></TR>", cpuLevelFreq(i), (uint32_t)(cpu->time[i] / 1000));
+
+  page.addf(
+"<TR><TD CLASS='LABEL'>Switches</TD><TD>%lu</TD></TR>"
+"</TABLE>"
+"<H2>Boot Timeline</H2>"
+"<TABLE COLUMNS=2>"
+"<TR><TH>Step</TH><TH>Done (ms)</TH></TR>",
+    (uint32_t)cpu->switches
+  );
+
+  for(uint8_t i = 0 ; const ProfMark *m = profGetMark(i) ; i++)
+    page.addf("<TR><TD CLASS='LABEL'>%s</TD><TD>%lu</TD></TR>", m->name, (uint32_t)(m->time / 1000));
+
+  page.add("</TABLE>");
+  webPageEnd(page);
 }
 
-const String webConfigPage()
+static void webConfigPage(WebPage &page, AsyncWebServerRequest *request)
 {
+  static const char *const keys[] = { "wifissid1", "wifipass1", "wifissid2", "wifipass2", "wifissid3", "wifipass3" };
+  char values[6][65];
+
   prefs.begin("network", true, STORAGE_PARTITION);
-  String ssid1 = prefs.getString("wifissid1", "");
-  String pass1 = prefs.getString("wifipass1", "");
-  String ssid2 = prefs.getString("wifissid2", "");
-  String pass2 = prefs.getString("wifipass2", "");
-  String ssid3 = prefs.getString("wifissid3", "");
-  String pass3 = prefs.getString("wifipass3", "");
+  for(uint8_t i = 0 ; i < 6 ; i++)
+    webPrefsString(keys[i], values[i], sizeof(values[i]));
   prefs.end();
 
-  return webPage(
+  webPageBegin(page);
+  page.add(
 "<H1>ATS-Mini Config</H1>"
 "<P ALIGN='CENTER'>"
   "<A HREF='/'>Status</A>"
@@ -628,69 +975,78 @@ const String webConfigPage()
 "</P>"
 "<FORM ACTION='/setconfig' METHOD='POST'>"
   "<TABLE COLUMNS=2>"
-  "<TR><TH COLSPAN=2 CLASS='HEADING'>WiFi Network 1</TH></TR>"
-  "<TR>"
-    "<TD CLASS='LABEL'>SSID</TD>"
-    "<TD>" + webInputField("wifissid1", ssid1) + "</TD>"
-  "</TR>"
-  "<TR>"
-    "<TD CLASS='LABEL'>Password</TD>"
-    "<TD>" + webInputField("wifipass1", pass1, true) + "</TD>"
-  "</TR>"
-  "<TR><TH COLSPAN=2 CLASS='HEADING'>WiFi Network 2</TH></TR>"
-  "<TR>"
-    "<TD CLASS='LABEL'>SSID</TD>"
-    "<TD>" + webInputField("wifissid2", ssid2) + "</TD>"
-  "</TR>"
-  "<TR>"
-    "<TD CLASS='LABEL'>Password</TD>"
-    "<TD>" + webInputField("wifipass2", pass2, true) + "</TD>"
-  "</TR>"
-  "<TR><TH COLSPAN=2 CLASS='HEADING'>WiFi Network 3</TH></TR>"
+  );
+
+  for(uint8_t i = 0 ; i < 3 ; i++)
+  {
+    page.addf(
+  "<TR><TH COLSPAN=2 CLASS='HEADING'>WiFi Network %u</TH></TR>"
   "<TR>"
     "<TD CLASS='LABEL'>SSID</TD>"
-    "<TD>" + webInputField("wifissid3", ssid3) + "</TD>"
+    "<TD>", i + 1
+    );
+    webInputField(page, keys[i * 2], values[i * 2]);
+    page.add(
+    "</TD>"
   "</TR>"
   "<TR>"
     "<TD CLASS='LABEL'>Password</TD>"
-    "<TD>" + webInputField("wifipass3", pass3, true) + "</TD>"
+    "<TD>"
+    );
+    webInputField(page, keys[i * 2 + 1], values[i * 2 + 1], true);
+    page.add(
+    "</TD>"
   "</TR>"
+    );
+  }
+
+  page.add(
   "<TR><TH COLSPAN=2 CLASS='HEADING'>This Web UI Login Credentials</TH></TR>"
   "<TR>"
     "<TD CLASS='LABEL'>Username</TD>"
-    "<TD>" + webInputField("username", loginUsername) + "</TD>"
+    "<TD>"
+  );
+  webInputField(page, "username", loginUsername.c_str());
+  page.add(
+    "</TD>"
   "</TR>"
   "<TR>"
     "<TD CLASS='LABEL'>Password</TD>"
-    "<TD>" + webInputField("password", loginPassword, true) + "</TD>"
+    "<TD>"
+  );
+  webInputField(page, "password", loginPassword.c_str(), true);
+  page.add(
+    "</TD>"
   "</TR>"
   "<TR><TH COLSPAN=2 CLASS='HEADING'>Settings</TH></TR>"
   "<TR>"
     "<TD CLASS='LABEL'>Time Zone</TD>"
     "<TD>"
-      "<SELECT NAME='utcoffset'>" + webUtcOffsetSelector() + "</SELECT>"
+      "<SELECT NAME='utcoffset'>"
+  );
+  webUtcOffsetSelector(page);
+  page.add(
+      "</SELECT>"
     "</TD>"
   "</TR>"
   "<TR>"
     "<TD CLASS='LABEL'>Theme</TD>"
     "<TD>"
-      "<SELECT NAME='theme'>" + webThemeSelector() + "</SELECT>"
+      "<SELECT NAME='theme'>"
+  );
+  webThemeSelector(page);
+  page.add(
+      "</SELECT>"
     "</TD>"
   "</TR>"
-  "<TR>"
-    "<TD CLASS='LABEL'>Reverse Scrolling</TD>"
-    "<TD><INPUT TYPE='CHECKBOX' NAME='scroll' VALUE='on'" +
-    (scrollDirection<0? " CHECKED ":"") + "></TD>"
-  "</TR>"
-   "<TR>"
-    "<TD CLASS='LABEL'>Zoomed Menu</TD>"
-    "<TD><INPUT TYPE='CHECKBOX' NAME='zoom' VALUE='on'" +
-    (zoomMenu? " CHECKED ":"") + "></TD>"
-  "</TR>"
+  );
+  webSettingFields(page);
+  page.add(
   "<TR><TH COLSPAN=2 CLASS='HEADING'>"
     "<INPUT TYPE='SUBMIT' VALUE='Save'>"
   "</TH></TR>"
   "</TABLE>"
 "</FORM>"
-);
+  );
+  webPageEnd(page);
 }
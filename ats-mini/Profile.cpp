@@ -0,0 +1,137 @@
+#include "Common.h"
+#include "Profile.h"
+#include <atomic>
+
+//
+// Main loop profiler. Keeps running statistics and a log2 histogram
+// of the time spent in each phase, plus the worst loop stalls along
+// with the phase that took the longest in them. Recording a sample is
+// a couple of additions, cheap enough to keep in production builds.
+//
+
+static const char *phaseNames[PROF_PHASES] =
+{
+  "loop", "input", "remote", "rssi", "rds", "schedule",
+  "ntp", "prefs", "draw", "jobs", "latency"
+};
+
+static ProfPhase phases[PROF_PHASES];
+static ProfStall stalls[PROF_STALLS];
+
+// Boot timeline, marked from setup() and the boot task
+static ProfMark marks[PROF_MARKS];
+static std::atomic<uint8_t> markCount(0);
+
+// Longest phase in the current loop pass
+static uint8_t passPhase = PROF_LOOP;
+static uint32_t passTime = 0;
+
+uint32_t profStart()
+{
+  return(micros());
+}
+
+//
+// Record time spent in a phase started at profStart()
+//
+void profEnd(uint8_t phase, uint32_t start)
+{
+  profAdd(phase, micros() - start);
+}
+
+//
+// Record given time (us) for a phase
+//
+void profAdd(uint8_t phase, uint32_t time)
+{
+  if(phase >= PROF_PHASES) return;
+
+  ProfPhase *p = &phases[phase];
+  uint8_t bucket = time? 31 - __builtin_clz(time) : 0;
+
+  p->min = p->count? min(p->min, time) : time;
+  p->max = max(p->max, time);
+  p->sum += time;
+  p->count++;
+  p->hist[min(bucket, (uint8_t)(PROF_BUCKETS - 1))]++;
+
+  // Latency spans several passes, do not blame it for a stall
+  if(phase != PROF_LOOP && phase != PROF_LATENCY && time > passTime)
+  {
+    passPhase = phase;
+    passTime = time;
+  }
+}
+
+//
+// Record the whole loop pass started at profStart(), keeping it if it
+// is one of the worst stalls
+//
+void profLoopEnd(uint32_t start)
+{
+  uint32_t time = micros() - start;
+  profAdd(PROF_LOOP, time);
+
+  if(time >= PROF_STALL_MIN)
+  {
+    // Replace the shortest stall recorded
+    uint8_t j = 0;
+    for(uint8_t i = 1 ; i < PROF_STALLS ; i++)
+      if(stalls[i].duration < stalls[j].duration) j = i;
+
+    if(time > stalls[j].duration)
+    {
+      stalls[j].time      = millis();
+      stalls[j].duration  = time;
+      stalls[j].phaseTime = passTime;
+      stalls[j].phase     = passPhase;
+    }
+  }
+
+  passPhase = PROF_LOOP;
+  passTime = 0;
+}
+
+void profReset()
+{
+  memset(phases, 0, sizeof(phases));
+  memset(stalls, 0, sizeof(stalls));
+}
+
+const ProfPhase *profGetPhase(uint8_t phase)
+{
+  return(phase < PROF_PHASES? &phases[phase] : 0);
+}
+
+//
+// Get recorded stall, returns NULL for empty slots
+//
+const ProfStall *profGetStall(uint8_t idx)
+{
+  return(idx < PROF_STALLS && stalls[idx].duration? &stalls[idx] : 0);
+}
+
+const char *profPhaseName(uint8_t phase)
+{
+  return(phase < PROF_PHASES? phaseNames[phase] : "?");
+}
+
+//
+// Mark completion of a boot step, may be called from any task
+//
+void profMark(const char *name)
+{
+  uint8_t idx = markCount.fetch_add(1);
+  if(idx >= PROF_MARKS) return;
+
+  marks[idx].time = micros();
+  marks[idx].name = name;
+}
+
+//
+// Get boot timeline mark, returns NULL past the last one
+//
+const ProfMark *profGetMark(uint8_t idx)
+{
+  return(idx < min(markCount.load(), (uint8_t)PROF_MARKS) && marks[idx].name? &marks[idx] : NULL);
+}
@@ -0,0 +1,59 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+// Profiled phases of the main loop
+#define PROF_LOOP      0  // Whole loop pass, excluding sleep
+#define PROF_INPUT     1  // Encoder, button and input event handling
+#define PROF_REMOTE    2  // Serial and BLE remote commands
+#define PROF_RSSI      3  // Signal quality and squelch check
+#define PROF_RDS       4  // RDS data check
+#define PROF_SCHEDULE  5  // Station schedule lookup
+#define PROF_NTP       6  // NTP time refresh
+#define PROF_PREFS     7  // Delayed preferences save
+#define PROF_DRAW      8  // Screen drawing
+#define PROF_JOBS      9  // Other periodic jobs
+#define PROF_LATENCY  10  // Input event until the screen shows it
+#define PROF_PHASES   11
+
+#define PROF_BUCKETS  20     // Histogram buckets, bucket N counts times of 2^N..2^(N+1)-1 us
+#define PROF_STALLS    8     // Number of worst loop stalls kept
+#define PROF_STALL_MIN 20000 // Minimal loop pass time counted as a stall (us)
+#define PROF_MARKS    24     // Boot timeline marks kept
+
+typedef struct
+{
+  uint32_t count;               // Number of samples
+  uint32_t min;                 // Shortest time (us)
+  uint32_t max;                 // Longest time (us)
+  uint64_t sum;                 // Total time (us)
+  uint32_t hist[PROF_BUCKETS];  // Log2 histogram of times
+} ProfPhase;
+
+typedef struct
+{
+  uint32_t time;      // When the stall happened (ms since boot)
+  uint32_t duration;  // Loop pass time (us)
+  uint32_t phaseTime; // Time of the longest phase in that pass (us)
+  uint8_t  phase;     // Longest phase in that pass
+} ProfStall;
+
+typedef struct
+{
+  const char *name;   // Boot step
+  uint32_t time;      // When the step completed (us since reset)
+} ProfMark;
+
+uint32_t profStart();
+void profEnd(uint8_t phase, uint32_t start);
+void profAdd(uint8_t phase, uint32_t time);
+void profLoopEnd(uint32_t start);
+void profReset();
+const ProfPhase *profGetPhase(uint8_t phase);
+const ProfStall *profGetStall(uint8_t idx);
+const char *profPhaseName(uint8_t phase);
+void profMark(const char *name);
+const ProfMark *profGetMark(uint8_t idx);
+
+#endif // PROFILE_H
@@ -0,0 +1,425 @@
+#include "Common.h"
+#include "Radio.h"
+#include "Trace.h"
+#include <atomic>
+
+// Tuning delays after rx.setFrequency()
+#define TUNE_DELAY_DEFAULT 30
+#define TUNE_DELAY_FM      60
+#define TUNE_DELAY_AM_SSB  80
+
+//
+// Radio task. It owns the SI4732 receiver and runs all I2C transactions
+// on the core that does not draw the screen. The main loop sends tuning
+// and property changes through a command queue and reads signal quality
+// and RDS data from a snapshot, so it never waits for the receiver.
+//
+
+typedef struct
+{
+  RadioFunc fn;              // Function to call on the radio task
+  int32_t a, b;              // Function arguments
+  uint8_t flags;             // RADIO_* flags
+} RadioCmd;
+
+static TaskHandle_t radioTask = NULL;
+static QueueHandle_t radioQueue = NULL;
+
+// Number of commands sent to the radio task
+static std::atomic<uint32_t> radioPosted(0);
+
+// Published status, guarded by a sequence counter that is odd
+// while the radio task is writing it (seqlock)
+static RadioStatus radioStatus;
+static std::atomic<uint32_t> radioSeq(0);
+
+// Radio task own copy of the status
+static RadioStatus taskStatus;
+
+// Latest tuning target, frequency in low and BFO in high 16 bits. The
+// radio task only tunes to the target that is current when it gets to
+// it, skipping any targets set while it was busy.
+static std::atomic<uint32_t> tuneTarget(0);
+static std::atomic<bool> tuneForce(false);
+static std::atomic<bool> tuneQueued(false);
+static uint32_t tunePosted = 0;
+
+// Seek start and last poll times
+static uint32_t seekStart = 0;
+static uint32_t seekTime = 0;
+
+// Scan results, and the flag the main loop sets to stop a scan
+static RadioScanPoint *scanPoints = NULL;
+static std::atomic<bool> scanStop(false);
+
+// Receiver mode and AGC as set by commands, the radio task does not
+// look at the main loop copies
+static uint8_t taskMode = FM;
+static uint8_t taskAgcDisable = 0;
+static uint8_t taskAgcIdx = 0;
+
+static bool onRadioTask()
+{
+  return(radioTask && xTaskGetCurrentTaskHandle() == radioTask);
+}
+
+static void radioPublish()
+{
+  radioSeq.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(&radioStatus, &taskStatus, sizeof(radioStatus));
+  std::atomic_thread_fence(std::memory_order_release);
+  radioSeq.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void radioClearRds()
+{
+  taskStatus.rdsGroups = 0;
+  taskStatus.rdsTimes  = 0;
+  taskStatus.rdsFields = 0;
+  taskStatus.rdsPi     = 0;
+  taskStatus.rdsPty    = 0;
+  taskStatus.rdsPs[0]  = '\0';
+  taskStatus.rdsRt[0]  = '\0';
+  taskStatus.rdsCt[0]  = '\0';
+}
+
+//
+// Read signal quality and pending RDS group
+//
+static void radioPoll()
+{
+  rx.getCurrentReceivedSignalQuality();
+  taskStatus.rssi  = rx.getCurrentRSSI();
+  taskStatus.snr   = rx.getCurrentSNR();
+  taskStatus.pilot = rx.getCurrentPilot();
+
+  // Use rx.getFrequency to force read of capacitor value from SI4732/5
+  rx.getFrequency();
+  taskStatus.capacitor = rx.getAntennaTuningCapacitor();
+
+  // Only decode RDS on a decent FM signal
+  if(taskMode == FM && taskStatus.snr >= 12)
+  {
+    rx.getRdsStatus();
+
+    if(rx.getRdsReceived() && rx.getRdsSync() && rx.getRdsSyncFound())
+    {
+      // Each group carries only some of the fields, keep the last
+      // received value of each one until the station changes
+      const char *ps = rx.getRdsStationName();
+      const char *rt = rx.getRdsProgramInformation();
+      const char *ct = rx.getRdsTime();
+      uint16_t pi = rx.getRdsPI();
+
+      if(ps)
+      {
+        strncpy(taskStatus.rdsPs, ps, sizeof(taskStatus.rdsPs) - 1);
+        taskStatus.rdsFields |= RDS_PS;
+      }
+      if(rt)
+      {
+        strncpy(taskStatus.rdsRt, rt, sizeof(taskStatus.rdsRt) - 1);
+        taskStatus.rdsFields |= RDS_RT;
+      }
+      if(ct)
+      {
+        strncpy(taskStatus.rdsCt, ct, sizeof(taskStatus.rdsCt) - 1);
+        taskStatus.rdsFields |= RDS_CT;
+        taskStatus.rdsTimes++;
+      }
+      if(pi)
+      {
+        taskStatus.rdsPi = pi;
+        taskStatus.rdsFields |= RDS_PI;
+      }
+
+      taskStatus.rdsPty = rx.getRdsProgramTypeX();
+      taskStatus.rdsFields |= RDS_PT;
+      taskStatus.rdsGroups++;
+    }
+  }
+
+  radioPublish();
+}
+
+//
+// Tune to the latest target
+//
+static void radioTuneRun(int32_t, int32_t)
+{
+  // Targets set from now on need another command
+  tuneQueued = false;
+
+  uint32_t target = tuneTarget;
+  bool force = tuneForce.exchange(false);
+  uint16_t freq = target & 0xFFFF;
+  int16_t bfo = target >> 16;
+
+  if(force || freq != rx.getCurrentFrequency())
+  {
+    TRACE_SCOPE(TRACE_TUNE, freq);
+    rx.setFrequency(freq);
+    // Re-apply AGC to remove noise in SSB modes
+    if(bfo != RADIO_NO_BFO) rx.setAutomaticGainControl(taskAgcDisable, taskAgcIdx);
+  }
+
+  if(bfo != RADIO_NO_BFO) rx.setSSBBfo(bfo);
+}
+
+//
+// Start seeking, radioSeekPoll() follows it
+//
+static void radioSeekRun(int32_t up, int32_t)
+{
+  // Seek command does not work for SSB
+  if(taskMode == LSB || taskMode == USB) return;
+
+  rx.seekStation(up, 0);
+  seekStart = seekTime = millis();
+  taskStatus.seekFreq = rx.getCurrentFrequency();
+  taskStatus.seeking = true;
+}
+
+static void radioSeekStopRun(int32_t, int32_t)
+{
+  // Receiver keeps seeking until the main loop tunes to the final
+  // frequency, no more progress reports though
+  taskStatus.seeking = false;
+}
+
+static void radioSeekPoll()
+{
+  bool more = rx.seekStationPoll();
+
+  taskStatus.seekFreq = rx.getCurrentFrequency();
+  taskStatus.seeking = more && (millis() - seekStart < RADIO_SEEK_TIMEOUT);
+  seekTime = millis();
+  radioPublish();
+}
+
+//
+// Measure signal quality at count frequencies, step apart, starting
+// with freq. Progress is published as the scan goes, and the receiver
+// is tuned back to where it was once it is over.
+//
+static void radioScanRun(int32_t a, int32_t b)
+{
+  uint16_t freq  = a & 0xFFFF;
+  uint16_t step  = a >> 16;
+  uint16_t count = b & 0xFFFF;
+  uint16_t curFreq = rx.getFrequency();
+
+  rx.setMaxDelaySetFrequency((b >> 16)? TUNE_DELAY_FM : TUNE_DELAY_AM_SSB);
+  taskStatus.scanning  = true;
+  taskStatus.scanCount = 0;
+  radioPublish();
+
+  for(uint16_t i = 0 ; i < count && !scanStop ; i++, freq += step)
+  {
+    TRACE_MARK(TRACE_TUNE, freq);
+    rx.setFrequency(freq); // Implies tuning delay
+
+    // Wait for the tuning to complete
+    for(rx.getStatus(0, 0) ; !rx.getTuneCompleteTriggered() && !scanStop ; rx.getStatus(0, 0))
+      delay(RADIO_SCAN_TIME);
+    if(scanStop) break;
+
+    rx.getCurrentReceivedSignalQuality();
+    scanPoints[i].rssi = rx.getCurrentRSSI();
+    scanPoints[i].snr  = rx.getCurrentSNR();
+
+    // Points are written before the count that covers them
+    taskStatus.scanCount = i + 1;
+    radioPublish();
+  }
+
+  rx.setFrequency(curFreq);
+  rx.setMaxDelaySetFrequency(TUNE_DELAY_DEFAULT);
+  taskStatus.scanning = false;
+}
+
+//
+// Run a single command
+//
+static void radioRun(const RadioCmd *cmd)
+{
+  // Any other station change ends a seek
+  if((cmd->flags & RADIO_RETUNE) && cmd->fn != radioSeekRun)
+    taskStatus.seeking = false;
+
+  cmd->fn(cmd->a, cmd->b);
+  if(cmd->flags & RADIO_RETUNE) radioClearRds();
+
+  taskStatus.commands++;
+  radioPublish();
+}
+
+static void radioTaskMain(void *)
+{
+  uint32_t pollTime = millis();
+
+  for(;;)
+  {
+    uint32_t elapsed = millis() - pollTime;
+    uint32_t wait = elapsed < RADIO_POLL_TIME? RADIO_POLL_TIME - elapsed : 0;
+    RadioCmd cmd;
+
+    if(taskStatus.seeking)
+    {
+      elapsed = millis() - seekTime;
+      wait = min(wait, elapsed < RADIO_SEEK_TIME? RADIO_SEEK_TIME - elapsed : 0);
+    }
+
+    // Run commands as they come, poll the receiver in between
+    if(xQueueReceive(radioQueue, &cmd, pdMS_TO_TICKS(wait)) == pdTRUE)
+      radioRun(&cmd);
+
+    if(taskStatus.seeking && millis() - seekTime >= RADIO_SEEK_TIME)
+      radioSeekPoll();
+
+    if(millis() - pollTime >= RADIO_POLL_TIME)
+    {
+      radioPoll();
+      pollTime = millis();
+    }
+  }
+}
+
+//
+// Start the radio task, call this from setup() once the receiver has
+// been initialized. Until then, commands run on the calling task.
+//
+void radioInit()
+{
+  radioQueue = xQueueCreate(RADIO_QUEUE_SIZE, sizeof(RadioCmd));
+  xTaskCreatePinnedToCore(radioTaskMain, "radio", RADIO_STACK_SIZE, NULL, 2, &radioTask, RADIO_CORE);
+}
+
+//
+// Queue a command for the radio task and return immediately
+//
+void radioPost(RadioFunc fn, int32_t a, int32_t b, uint8_t flags)
+{
+  // Before the radio task starts, or on the radio task itself,
+  // just call the function
+  if(!radioTask || onRadioTask())
+  {
+    fn(a, b);
+    return;
+  }
+
+  RadioCmd cmd = { fn, a, b, flags };
+  radioPosted++;
+  xQueueSend(radioQueue, &cmd, portMAX_DELAY);
+}
+
+//
+// Tune to given frequency and SSB BFO offset. Unless force is set, the
+// frequency is only set if it differs from the current one. While the
+// radio task is busy, new targets replace the queued one, so a fast
+// spinning encoder does not pile up tuning commands.
+//
+void radioTune(uint16_t freq, int16_t bfo, bool force)
+{
+  if(force) tuneForce = true;
+  tuneTarget = freq | ((uint32_t)(uint16_t)bfo << 16);
+
+  // Queued tuning command will pick the new target, as long as
+  // nothing else has been sent after it
+  if(tuneQueued && tunePosted == radioPosted) return;
+
+  tuneQueued = true;
+  radioPost(radioTuneRun, 0, 0, RADIO_RETUNE);
+  tunePosted = radioPosted;
+}
+
+//
+// Tell the radio task the mode the receiver is being set to, post this
+// along with the band setup
+//
+void radioSetMode(uint8_t mode)
+{
+  radioPost([](int32_t mode, int32_t) { taskMode = mode; }, mode);
+}
+
+//
+// Set AGC (disable = 0) or attenuation (disable = 1, idx > 0), it is
+// applied again after SSB tuning
+//
+void radioSetAgc(uint8_t disable, uint8_t idx)
+{
+  radioPost([](int32_t disable, int32_t idx) {
+    taskAgcDisable = disable;
+    taskAgcIdx = idx;
+    rx.setAutomaticGainControl(disable, idx);
+  }, disable, idx);
+}
+
+//
+// Seek up or down in the background, seek progress and result are
+// published in RadioStatus
+//
+void radioSeek(bool up)
+{
+  radioPost(radioSeekRun, up, 0, RADIO_RETUNE);
+}
+
+void radioSeekStop()
+{
+  radioPost(radioSeekStopRun);
+}
+
+//
+// Scan in the background, measuring signal quality into given points.
+// Scan progress is published in RadioStatus, and the points are valid
+// up to scanCount. Points must stay untouched until the scan is over.
+//
+void radioScan(RadioScanPoint *points, uint16_t freq, uint16_t step, uint16_t count, bool fm)
+{
+  scanPoints = points;
+  scanStop = false;
+  radioPost(radioScanRun, freq | ((uint32_t)step << 16), count | ((uint32_t)fm << 16), RADIO_RETUNE);
+}
+
+//
+// Stop scan in progress, the points measured so far stay valid
+//
+void radioScanStop()
+{
+  scanStop = true;
+}
+
+//
+// Returns TRUE if the radio task has not run all commands yet, so the
+// published RDS data may belong to the previous station
+//
+bool radioBusy()
+{
+  RadioStatus status;
+  radioGetStatus(&status);
+  return(status.commands != radioPosted);
+}
+
+//
+// Get a consistent copy of the published status
+//
+void radioGetStatus(RadioStatus *status)
+{
+  uint32_t seq;
+
+  do
+  {
+    seq = radioSeq.load(std::memory_order_acquire);
+    memcpy(status, &radioStatus, sizeof(*status));
+    std::atomic_thread_fence(std::memory_order_acquire);
+  }
+  while((seq & 1) || seq != radioSeq.load(std::memory_order_relaxed));
+}
+
+bool radioPilot()
+{
+  RadioStatus status;
+  radioGetStatus(&status);
+  return(status.pilot);
+}
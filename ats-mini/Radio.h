@@ -0,0 +1,65 @@
+#ifndef RADIO_H
+#define RADIO_H
+
+#include <stdint.h>
+
+#define RADIO_POLL_TIME      50 // Signal quality and RDS polling period (ms)
+#define RADIO_QUEUE_SIZE     32 // Maximal number of queued commands
+#define RADIO_STACK_SIZE   8192 // Radio task stack size (bytes)
+#define RADIO_CORE            0 // Radio task core, main loop runs on core 1
+#define RADIO_SEEK_TIME      30 // Seek progress polling period (ms)
+#define RADIO_SEEK_TIMEOUT 600000 // Max seek time (ms)
+#define RADIO_SCAN_TIME      10 // Scan tuning status polling period (ms)
+
+// No BFO change when tuning, i.e. in AM and FM modes
+#define RADIO_NO_BFO (-32768)
+
+// Command flags
+#define RADIO_RETUNE 0x01 // Command changes station, drop stale RDS data
+
+// Command function, runs on the radio task
+typedef void (*RadioFunc)(int32_t a, int32_t b);
+
+// Signal quality measured at a scanned frequency
+typedef struct
+{
+  uint8_t rssi;
+  uint8_t snr;
+} RadioScanPoint;
+
+// Signal and RDS data published by the radio task
+typedef struct
+{
+  uint32_t commands;   // Number of commands completed so far
+  uint16_t capacitor;  // Antenna tuning capacitor
+  uint8_t  rssi;       // Signal strength (dBuV)
+  uint8_t  snr;        // Signal to noise ratio (dB)
+  bool     pilot;      // FM stereo pilot present
+  bool     seeking;    // Seek in progress
+  uint16_t seekFreq;   // Current seek frequency
+  bool     scanning;   // Scan in progress
+  uint16_t scanCount;  // Number of frequencies measured by the scan
+  uint32_t rdsGroups;  // Number of RDS groups received since tuning
+  uint32_t rdsTimes;   // Number of RDS time groups received since tuning
+  uint8_t  rdsFields;  // RDS_* fields received since tuning
+  uint8_t  rdsPty;     // RDS program type
+  uint16_t rdsPi;      // RDS PI code
+  char     rdsPs[9];   // RDS station name
+  char     rdsRt[65];  // RDS radio text
+  char     rdsCt[32];  // RDS time
+} RadioStatus;
+
+void radioInit();
+void radioPost(RadioFunc fn, int32_t a = 0, int32_t b = 0, uint8_t flags = 0);
+void radioTune(uint16_t freq, int16_t bfo = RADIO_NO_BFO, bool force = true);
+void radioSetMode(uint8_t mode);
+void radioSetAgc(uint8_t disable, uint8_t idx);
+void radioSeek(bool up);
+void radioSeekStop();
+void radioScan(RadioScanPoint *points, uint16_t freq, uint16_t step, uint16_t count, bool fm);
+void radioScanStop();
+bool radioBusy();
+void radioGetStatus(RadioStatus *status);
+bool radioPilot();
+
+#endif // RADIO_H
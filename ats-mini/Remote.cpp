@@ -4,7 +4,21 @@
 #include "Menu.h"
 #include "Draw.h"
 #include "Remote.h"
+#include "Storage.h"
+#include "Radio.h"
+#include "Input.h"
+#include "Profile.h"
+#include "Trace.h"
+#include "Cpu.h"
+#include "Journal.h"
+#include "Disk.h"
+#include "Arena.h"
+#include "Heap.h"
+#include "Bank.h"
+#include "Settings.h"
 
+// Commands queued as input events, see remoteApplyCommand()
+#define REMOTE_QUEUED "RreBbMmSsWwAaVvLlOoIi<>"
 
 static uint8_t char2nibble(char key)
 {
@@ -56,6 +70,339 @@ static void remoteCaptureScreen(Stream* stream)
   }
 }
 
+//
+// Binary screen capture: a 16 byte header, RLE compressed pixels and
+// a CRC32 of the compressed pixels. See tools/capture.py for a decoder.
+//
+#define CAPTURE_MAGIC    "ATSC"
+#define CAPTURE_VERSION  1
+#define CAPTURE_RLE565   1   // RLE packets of big-endian RGB565 pixels
+#define CAPTURE_MAX_RUN  128 // Maximal number of pixels in a packet
+
+// Screen mirror updates use the same format, with tile numbers before
+// each tile's packets and tile size in the last two header bytes
+#define MIRROR_MAGIC      "ATSM"
+#define MIRROR_MAX_FPS    30
+#define MIRROR_MIN_BUDGET 512
+#define MIRROR_DEF_BUDGET 4096
+
+typedef struct
+{
+  Stream *stream;   // Destination stream or NULL to only measure output
+  uint8_t *mem;     // Destination memory or NULL, instead of the stream
+  uint32_t length;  // Total number of bytes produced
+  uint32_t crc;     // CRC32 of produced bytes, when measuring
+  uint16_t used;    // Number of bytes in buffer
+  uint8_t buf[512]; // Output buffer, so that BLE sends full MTU chunks
+} CaptureSink;
+
+static CaptureSink captureSink;
+
+static uint32_t crc32Update(uint32_t crc, const uint8_t *data, size_t size)
+{
+  static const uint32_t table[16] =
+  {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+  };
+
+  crc = ~crc;
+  while(size--)
+  {
+    crc = table[(crc ^ *data) & 0x0F] ^ (crc >> 4);
+    crc = table[(crc ^ (*data++ >> 4)) & 0x0F] ^ (crc >> 4);
+  }
+  return(~crc);
+}
+
+static void captureFlush(CaptureSink *sink)
+{
+  if(!sink->used) return;
+  if(sink->stream)
+    sink->stream->write(sink->buf, sink->used);
+  else
+    sink->crc = crc32Update(sink->crc, sink->buf, sink->used);
+  sink->used = 0;
+}
+
+static void captureWrite(CaptureSink *sink, const uint8_t *data, size_t size)
+{
+  // Memory holds at most MIRROR_BUF_SIZE bytes, the length keeps counting
+  if(sink->mem)
+  {
+    if(sink->length + size <= MIRROR_BUF_SIZE) memcpy(sink->mem + sink->length, data, size);
+    sink->length += size;
+    return;
+  }
+
+  sink->length += size;
+  while(size)
+  {
+    size_t n = min(size, sizeof(sink->buf) - sink->used);
+    memcpy(sink->buf + sink->used, data, n);
+    sink->used += n;
+    data += n;
+    size -= n;
+    if(sink->used == sizeof(sink->buf)) captureFlush(sink);
+  }
+}
+
+//
+// Compress pixels into packets. Control byte 0..127 is followed by
+// 1..128 literal pixels, 128..255 by a single pixel repeated 1..128
+// times. Pixels are copied as they are stored in the sprite, which
+// keeps them byte swapped, i.e. big-endian.
+//
+static void captureEncode(CaptureSink *sink, const uint16_t *pixels, uint32_t count)
+{
+  uint32_t i = 0;
+
+  while(i < count)
+  {
+    uint32_t n = 1;
+    uint8_t ctl;
+
+    // Count repeated pixels
+    while(i + n < count && n < CAPTURE_MAX_RUN && pixels[i + n] == pixels[i]) n++;
+
+    if(n > 1)
+    {
+      ctl = 0x80 | (n - 1);
+      captureWrite(sink, &ctl, 1);
+      captureWrite(sink, (const uint8_t *)(pixels + i), 2);
+    }
+    else
+    {
+      // Count literal pixels, up to the start of the next run
+      while(i + n < count && n < CAPTURE_MAX_RUN &&
+            (i + n + 1 >= count || pixels[i + n] != pixels[i + n + 1])) n++;
+
+      ctl = n - 1;
+      captureWrite(sink, &ctl, 1);
+      captureWrite(sink, (const uint8_t *)(pixels + i), n * 2);
+    }
+
+    i += n;
+  }
+}
+
+//
+// Send capture header: magic, version, format, width, height, payload
+// length and two format specific bytes
+//
+static void captureSendHeader(Stream* stream, const char *magic, uint32_t length, uint8_t extra1 = 0, uint8_t extra2 = 0)
+{
+  uint16_t width  = spr.width();
+  uint16_t height = spr.height();
+
+  uint8_t header[16] =
+  {
+    (uint8_t)magic[0], (uint8_t)magic[1], (uint8_t)magic[2], (uint8_t)magic[3],
+    CAPTURE_VERSION, CAPTURE_RLE565,
+    (uint8_t)width, (uint8_t)(width >> 8),
+    (uint8_t)height, (uint8_t)(height >> 8),
+    (uint8_t)length, (uint8_t)(length >> 8), (uint8_t)(length >> 16), (uint8_t)(length >> 24),
+    extra1, extra2
+  };
+  stream->write(header, sizeof(header));
+}
+
+//
+// Send capture trailer: CRC32 of the payload
+//
+static void captureSendTrailer(Stream* stream, uint32_t crc)
+{
+  uint8_t trailer[4] = { (uint8_t)crc, (uint8_t)(crc >> 8), (uint8_t)(crc >> 16), (uint8_t)(crc >> 24) };
+  stream->write(trailer, sizeof(trailer));
+  stream->flush();
+}
+
+//
+// Capture current screen image to the remote, in binary form
+//
+static void remoteCaptureScreenBinary(Stream* stream)
+{
+  const uint16_t *pixels = (const uint16_t *)spr.getPointer();
+  uint32_t count = (uint32_t)spr.width() * spr.height();
+
+  if(!pixels || spr.getColorDepth() != 16) return;
+
+  // First pass: measure compressed size and compute CRC
+  captureSink.stream = NULL;
+  captureSink.length = captureSink.crc = captureSink.used = 0;
+  captureEncode(&captureSink, pixels, count);
+  captureFlush(&captureSink);
+  uint32_t crc = captureSink.crc;
+
+  captureSendHeader(stream, CAPTURE_MAGIC, captureSink.length);
+
+  // Second pass: send compressed pixels, followed by CRC
+  captureSink.stream = stream;
+  captureSink.length = captureSink.used = 0;
+  captureEncode(&captureSink, pixels, count);
+  captureFlush(&captureSink);
+
+  captureSendTrailer(stream, crc);
+}
+
+// Remote status and mirror job, only running while a remote logs status
+// or mirrors the screen
+static uint8_t remoteJob = SCHED_MAX_JOBS;
+static uint8_t remotesActive = 0;
+
+//
+// Register the job printing status and mirroring the screen to the
+// remotes, it is started once a remote asks for either
+//
+void remoteInit(SchedJob job)
+{
+  remoteJob = schedAdd(job, SCHED_REMOTE_TIME, false, PROF_REMOTE);
+}
+
+//
+// Start or stop the remote job after a remote has turned status log or
+// screen mirror on or off
+//
+static void remoteUpdateJob(RemoteState* state)
+{
+  bool active = state->remoteLogOn || state->mirrorTime;
+
+  if(active == state->jobActive) return;
+  state->jobActive = active;
+
+  if(active && !remotesActive++) schedStart(remoteJob, 0);
+  else if(!active && !--remotesActive) schedStop(remoteJob);
+}
+
+// Mirror buffers, allocated from the arena when mirroring starts
+static uint16_t *tileBuf = NULL;
+static uint8_t *mirrorBuf = NULL;
+
+//
+// Encode a single screen tile, prefixed with its number
+//
+static void captureEncodeTile(CaptureSink *sink, uint8_t tile)
+{
+  const uint16_t *pixels = (const uint16_t *)spr.getPointer();
+  int width = spr.width();
+
+  // Make tile pixels contiguous, so that runs span tile rows
+  pixels += (tile / DRAW_TILES_X) * DRAW_TILE_H * width + (tile % DRAW_TILES_X) * DRAW_TILE_W;
+  for(int y = 0 ; y < DRAW_TILE_H ; y++, pixels += width)
+    memcpy(tileBuf + y * DRAW_TILE_W, pixels, DRAW_TILE_W * 2);
+
+  captureWrite(sink, &tile, 1);
+  captureEncode(sink, tileBuf, DRAW_TILE_W * DRAW_TILE_H);
+}
+
+//
+// Start (fps > 0) or stop (fps = 0) mirroring the screen to the remote.
+// Each update carries at most budget bytes of compressed tiles.
+//
+static void remoteMirrorStart(Stream* stream, RemoteState* state, long int fps, long int budget)
+{
+  bool wasOn = !!state->mirrorTime;
+
+  // Buffers are allocated once, mirroring does not start without them
+  if(fps > 0 && (!tileBuf || !mirrorBuf))
+  {
+    if(!tileBuf) tileBuf = (uint16_t *)arenaAlloc(ARENA_DISPLAY, DRAW_TILE_W * DRAW_TILE_H * sizeof(uint16_t));
+    if(!mirrorBuf) mirrorBuf = (uint8_t *)arenaAlloc(ARENA_DISPLAY, MIRROR_BUF_SIZE);
+    if(!tileBuf || !mirrorBuf)
+    {
+      stream->println("\r\nMirror: out of memory");
+      return;
+    }
+  }
+
+  if(fps > 0 && spr.getPointer() && spr.getColorDepth() == 16)
+  {
+    state->mirrorTime   = 1000 / min(fps, (long int)MIRROR_MAX_FPS);
+    state->mirrorBudget = min(max(budget, (long int)MIRROR_MIN_BUDGET), (long int)MIRROR_MAX_BUDGET);
+    state->mirrorTimer  = millis() - state->mirrorTime;
+    state->mirrorNextTile = 0;
+
+    // Make every tile look stale, to send the whole screen first
+    for(int t = 0 ; t < DRAW_TILES ; t++)
+      state->mirrorSent[t] = drawTileGeneration(t) - 1;
+
+    if(!wasOn) drawTrackTiles(true);
+    stream->printf("\r\nMirror: %u ms, %u bytes\r\n", state->mirrorTime, state->mirrorBudget);
+  }
+  else
+  {
+    state->mirrorTime = 0;
+    if(wasOn) drawTrackTiles(false);
+    stream->println("\r\nMirror: off");
+  }
+}
+
+//
+// Send tiles that have changed since the last update, starting where
+// the previous update stopped. Tiles that do not fit into the budget
+// are left for the next update, so slow transports get a lower frame
+// rate rather than a growing backlog.
+//
+static void remoteMirrorTickTime(Stream* stream, RemoteState* state)
+{
+  static uint8_t tiles[DRAW_TILES];
+  static uint16_t gens[DRAW_TILES];
+  uint8_t count = 0;
+
+  if(!state->mirrorTime || (millis() - state->mirrorTimer < state->mirrorTime))
+    return;
+
+  // Do not queue data if the transport is still busy with the last update
+  if(stream->availableForWrite() < 64) return;
+
+  state->mirrorTimer = millis();
+  cpuBoost(CPU_FREQ_MAX);
+
+  // Encode changed tiles that fit into the budget, once, into memory
+  captureSink.stream = NULL;
+  captureSink.mem = mirrorBuf;
+  captureSink.length = captureSink.used = 0;
+  for(int i = 0 ; i < DRAW_TILES ; i++)
+  {
+    uint8_t t = (state->mirrorNextTile + i) % DRAW_TILES;
+    uint16_t gen = drawTileGeneration(t);
+    uint32_t length = captureSink.length;
+
+    if(gen == state->mirrorSent[t]) continue;
+
+    captureEncodeTile(&captureSink, t);
+    if(count && captureSink.length > state->mirrorBudget)
+    {
+      // Tile does not fit, drop it and continue from it next time
+      captureSink.length = length;
+      state->mirrorNextTile = t;
+      break;
+    }
+
+    tiles[count] = t;
+    gens[count++] = gen;
+  }
+
+  uint32_t length = captureSink.length;
+  captureSink.mem = NULL;
+  if(!count) return;
+
+  // Send picked tiles, followed by CRC
+  uint32_t crc = crc32Update(0, mirrorBuf, length);
+  captureSendHeader(stream, MIRROR_MAGIC, length, DRAW_TILE_W, DRAW_TILE_H);
+
+  captureSink.stream = stream;
+  captureSink.length = captureSink.used = 0;
+  captureWrite(&captureSink, mirrorBuf, length);
+  captureFlush(&captureSink);
+
+  for(int i = 0 ; i < count ; i++) state->mirrorSent[tiles[i]] = gens[i];
+
+  captureSendTrailer(stream, crc);
+}
+
 char remoteReadChar(Stream* stream)
 {
   char key;
@@ -123,6 +470,25 @@ static bool remoteShowError(Stream* stream, const char *message)
   return false;
 }
 
+static bool remoteSetMirror(Stream* stream, RemoteState* state)
+{
+  long int budget = MIRROR_DEF_BUDGET;
+
+  stream->print('D');
+  long int fps = remoteReadInteger(stream);
+  if (stream->peek() == ',')
+  {
+    remoteReadChar(stream);
+    budget = remoteReadInteger(stream);
+  }
+  if (!expectNewline(stream))
+    return remoteShowError(stream, "Expected newline");
+
+  state->remoteLogOn = false;
+  remoteMirrorStart(stream, state, fps, budget);
+  return true;
+}
+
 static void remoteGetMemories(Stream* stream)
 {
   for (uint8_t i = 0; i < getTotalMemories(); i++) {
@@ -204,6 +570,200 @@ static bool remoteSetMemory(Stream* stream)
   return true;
 }
 
+//
+// Add channels to the memory bank: group,freq,mode,name[,tag...], or
+// clear a group with: group,0
+//
+static bool remoteAddChannel(Stream* stream)
+{
+  stream->print('&');
+  Channel ch;
+  char group[BANK_NAME_LEN];
+  char tags[BANK_TAGS][BANK_NAME_LEN];
+  uint8_t tagCount = 0;
+
+  memset(&ch, 0, sizeof(ch));
+
+  // Names are only added once the whole line checks out, so a failed
+  // command does not use up group and tag slots
+  remoteReadString(stream, group, BANK_NAME_LEN);
+  if (remoteReadChar(stream) != ',')
+    return remoteShowError(stream, "Expected ','");
+  if (!*group)
+    return remoteShowError(stream, "Expected group");
+
+  ch.freq = remoteReadInteger(stream);
+  if (!ch.freq) {
+    if (!expectNewline(stream))
+      return remoteShowError(stream, "Expected newline");
+    stream->println();
+    int found = bankFindGroup(group);
+    if (found > 0) bankClearGroup(found);
+    return true;
+  }
+  if (remoteReadChar(stream) != ',')
+    return remoteShowError(stream, "Expected ','");
+
+  char mode[4];
+  remoteReadString(stream, mode, 4);
+  if (remoteReadChar(stream) != ',')
+    return remoteShowError(stream, "Expected ','");
+  ch.mode = 15;
+  for (int i = 0; i < getTotalModes(); i++) {
+    if (strcmp(bandModeDesc[i], mode) == 0) {
+      ch.mode = i;
+      break;
+    }
+  }
+  if (ch.mode == 15)
+    return remoteShowError(stream, "No such mode");
+
+  remoteReadString(stream, ch.name, sizeof(ch.name));
+
+  while (stream->peek() == ',') {
+    remoteReadChar(stream);
+    if (tagCount >= BANK_TAGS)
+      return remoteShowError(stream, "No more tags");
+    remoteReadString(stream, tags[tagCount], BANK_NAME_LEN);
+    if (!*tags[tagCount])
+      return remoteShowError(stream, "Expected tag");
+    tagCount++;
+  }
+
+  if (!expectNewline(stream))
+    return remoteShowError(stream, "Expected newline");
+  stream->println();
+
+  // Count names to be added, skipping repeated tags
+  uint8_t newGroups = bankFindGroup(group) < 0;
+  uint8_t newTags = 0;
+  for (uint8_t i = 0; i < tagCount; i++) {
+    bool repeated = false;
+    for (uint8_t j = 0; j < i && !repeated; j++)
+      repeated = !strncasecmp(tags[i], tags[j], BANK_NAME_LEN - 1);
+    if (!repeated && bankFindTag(tags[i]) < 0) newTags++;
+  }
+
+  if (!bankHasRoom(0, 0))
+    return remoteShowError(stream, "Memory bank full");
+  if (!bankHasRoom(newGroups, 0))
+    return remoteShowError(stream, "No more groups");
+  if (!bankHasRoom(0, newTags))
+    return remoteShowError(stream, "No more tags");
+
+  ch.group = bankAddGroup(group);
+  for (uint8_t i = 0; i < tagCount; i++)
+    ch.tags |= 1 << bankAddTag(tags[i]);
+
+  bankAdd(&ch);
+  return true;
+}
+
+static void remotePrintChannel(Stream* stream, const Channel *ch)
+{
+  stream->printf("%%%s,%lu,%s,%s", bankGroupName(ch->group), ch->freq, bandModeDesc[ch->mode], ch->name);
+  for (uint8_t i = 0; i < BANK_TAGS; i++)
+    if (ch->tags & (1 << i)) stream->printf(",%s", bankTagName(i));
+  stream->print("\r\n");
+}
+
+//
+// List memory bank channels by frequency: all of them, a range of
+// frequencies (from,to in Hz) or names starting with given text
+//
+static bool remoteListChannels(Stream* stream)
+{
+  const Channel *ch;
+  uint16_t pos = 0;
+
+  if (isdigit(stream->peek())) {
+    uint32_t from = remoteReadInteger(stream);
+    uint32_t to = from;
+    if (stream->peek() == ',') {
+      remoteReadChar(stream);
+      to = remoteReadInteger(stream);
+    }
+    if (!expectNewline(stream))
+      return remoteShowError(stream, "Expected newline");
+    stream->println();
+
+    uint16_t last = bankFindFreq(to + 1);
+    for (pos = bankFindFreq(from); pos < last && (ch = bankGet(BANK_BY_FREQ, pos)); pos++)
+      remotePrintChannel(stream, ch);
+  } else if (stream->peek() != '\r') {
+    char name[sizeof(Channel::name) + 1];
+    remoteReadString(stream, name, sizeof(name));
+    if (!expectNewline(stream))
+      return remoteShowError(stream, "Expected newline");
+    stream->println();
+
+    size_t length = strlen(name);
+    for (pos = bankFindName(name); (ch = bankGet(BANK_BY_NAME, pos)) && !strncasecmp(ch->name, name, length); pos++)
+      remotePrintChannel(stream, ch);
+  } else {
+    expectNewline(stream);
+    stream->println();
+
+    for (pos = 0; (ch = bankGet(BANK_BY_FREQ, pos)); pos++)
+      remotePrintChannel(stream, ch);
+  }
+
+  return true;
+}
+
+//
+// Tune to the next memory bank channel up or down from the current
+// frequency
+//
+static bool remoteTuneChannel(bool up)
+{
+  uint32_t freq = freqToHz(currentFrequency, currentMode) + currentBFO;
+  const Channel *ch = up? bankNext(freq) : bankPrev(freq);
+  Memory mem;
+
+  return(ch && bankToMemory(ch, &mem) && tuneToMemory(&mem));
+}
+
+//
+// Print all remotely accessible settings: key,value,min,max
+//
+static void remoteGetSettings(Stream* stream)
+{
+  for (uint8_t i = 0; i < settingsCount(); i++) {
+    const Setting *s = settingsGet(i);
+    if (s->flags & SET_REMOTE)
+      stream->printf("?%s,%ld,%d,%ld\r\n", s->key, settingRead(s), s->min, settingMax(s));
+  }
+}
+
+//
+// Change a setting: key,value
+//
+static bool remoteSetSetting(Stream* stream)
+{
+  stream->print('=');
+  char key[16];
+
+  remoteReadString(stream, key, sizeof(key));
+  if (remoteReadChar(stream) != ',')
+    return remoteShowError(stream, "Expected ','");
+
+  bool negative = stream->peek() == '-';
+  if (negative) remoteReadChar(stream);
+  long int value = remoteReadInteger(stream);
+  if (!expectNewline(stream))
+    return remoteShowError(stream, "Expected newline");
+  stream->println();
+
+  const Setting *s = settingsFind(key);
+  if (!s || !(s->flags & SET_REMOTE))
+    return remoteShowError(stream, "No such setting");
+  if (!settingWrite(s, negative? -value : value, true))
+    return remoteShowError(stream, "Value out of range");
+
+  return true;
+}
+
 //
 // Set current color theme from the remote
 //
@@ -253,6 +813,63 @@ static void remoteGetColorTheme(Stream* stream)
   stream->println();
 }
 
+//
+// Print main loop profile to the remote: per phase statistics and log2
+// histogram (us), followed by the worst stalls
+//
+static void remotePrintProfile(Stream* stream)
+{
+  for(uint8_t i = 0 ; i < PROF_PHASES ; i++)
+  {
+    const ProfPhase *p = profGetPhase(i);
+    if(!p->count) continue;
+
+    stream->printf("%s,%lu,%lu,%lu,%lu,", profPhaseName(i), p->count,
+                   p->min, (uint32_t)(p->sum / p->count), p->max);
+    for(uint8_t j = 0 ; j < PROF_BUCKETS ; j++)
+      stream->printf(j < PROF_BUCKETS - 1 ? "%lu:" : "%lu\r\n", p->hist[j]);
+  }
+
+  for(uint8_t i = 0 ; i < PROF_STALLS ; i++)
+  {
+    const ProfStall *s = profGetStall(i);
+    if(s) stream->printf("!%lu,%lu,%s,%lu\r\n", s->time, s->duration, profPhaseName(s->phase), s->phaseTime);
+  }
+
+  // Time spent at each CPU clock (ms)
+  const CpuStats *cpu = cpuGetStats();
+  stream->print("cpu");
+  for(uint8_t i = 0 ; i < CPU_LEVELS ; i++)
+    stream->printf(",%uMHz:%lu", cpuLevelFreq(i), cpu->time[i]);
+  stream->printf(",%lu\r\n", cpu->switches);
+
+  // Last preferences save and load times (us)
+  const PrefsStats *prefsStats = prefsGetStats();
+  stream->printf("prefs,%lu,%lu,%lu,%lu\r\n", prefsStats->saveTime, prefsStats->loadTime, prefsStats->saves, prefsStats->chunks);
+
+  // Settings journal commit and boot replay times (us)
+  const JournalStats *journal = journalGetStats();
+  stream->printf("journal,%lu,%lu,%lu,%lu,%lu,%lu\r\n", journal->appendTime, journal->replayTime, journal->records, journal->size, journal->compactions, journal->failures);
+
+  // File system access through the cache
+  const DiskStats *disk = diskGetStats();
+  stream->printf("disk,%lu,%lu,%lu,%lu,%lu\r\n", disk->opens, disk->reads, disk->seeks, disk->hits, disk->misses);
+
+  // PSRAM arena regions (bytes, blocks)
+  for(uint8_t i = 0 ; i < ARENA_REGIONS ; i++)
+  {
+    const ArenaStats *arena = arenaGetStats(i);
+    stream->printf("arena,%s,%lu,%lu,%u,%u,%u,%lu\r\n", arena->name, arena->used, arena->size,
+                   arena->inUse, arena->peak, arena->blocks, arena->fallbacks);
+  }
+
+  // Boot timeline (ms since reset)
+  stream->print("boot");
+  for(uint8_t i = 0 ; const ProfMark *m = profGetMark(i) ; i++)
+    stream->printf(",%s:%lu", m->name, m->time / 1000);
+  stream->println();
+}
+
 //
 // Print current status to the remote
 //
@@ -262,13 +879,12 @@ void remotePrintStatus(Stream* stream, RemoteState* state)
   float remoteVoltage = batteryMonitor();
 
   // S-Meter conditional on compile option
-  rx.getCurrentReceivedSignalQuality();
-  uint8_t remoteRssi = rx.getCurrentRSSI();
-  uint8_t remoteSnr = rx.getCurrentSNR();
+  RadioStatus status;
+  radioGetStatus(&status);
+  uint8_t remoteRssi = status.rssi;
+  uint8_t remoteSnr = status.snr;
 
-  // Use rx.getFrequency to force read of capacitor value from SI4732/5
-  rx.getFrequency();
-  uint16_t tuningCapacitor = rx.getAntennaTuningCapacitor();
+  uint16_t tuningCapacitor = status.capacitor;
 
   // Remote serial
   stream->printf("%u,%u,%d,%d,%s,%s,%s,%s,%hu,%hu,%hu,%hu,%hu,%.2f,%hu\r\n",
@@ -304,28 +920,21 @@ void remoteTickTime(Stream* stream, RemoteState* state)
     // Show status
     remotePrintStatus(stream, state);
   }
+
+  remoteMirrorTickTime(stream, state);
 }
 
 //
-// Recognize and execute given remote command
+// Apply a remote command changing the receiver state, called from the
+// input event handler so commands take effect in the order they came
+// in, along with rotations and clicks. Returns REMOTE_* flags.
 //
-int remoteDoCommand(Stream* stream, RemoteState* state, char key)
+int remoteApplyCommand(char key)
 {
   int event = 0;
 
   switch(key)
   {
-    case 'R': // Rotate Encoder Clockwise
-      event |= 1 << REMOTE_DIRECTION;
-      event |= REMOTE_PREFS;
-      break;
-    case 'r': // Rotate Encoder Counterclockwise
-      event |= -1 << REMOTE_DIRECTION;
-      event |= REMOTE_PREFS;
-      break;
-    case 'e': // Encoder Push Button
-      event |= REMOTE_CLICK;
-      break;
     case 'B': // Band Up
       doBand(1);
       event |= REMOTE_PREFS;
@@ -396,10 +1005,74 @@ int remoteDoCommand(Stream* stream, RemoteState* state, char key)
       doCal(-1);
       event |= REMOTE_PREFS;
       break;
+    case '>':
+      if (remoteTuneChannel(true))
+        event |= REMOTE_PREFS;
+      break;
+    case '<':
+      if (remoteTuneChannel(false))
+        event |= REMOTE_PREFS;
+      break;
+
+    default:
+      // Not a queued command
+      return(event);
+  }
+
+  return(event | REMOTE_CHANGED);
+}
+
+//
+// Recognize and execute given remote command
+//
+int remoteDoCommand(Stream* stream, RemoteState* state, char key, uint8_t source)
+{
+  // Dump the trace outside of the command scope, so the dump does not
+  // end with a begin record missing its end
+  if(key == 'X')
+  {
+    traceDump(stream);
+    return(0);
+  }
+
+  TRACE_SCOPE(TRACE_REMOTE, key);
+  int event = 0;
+
+  switch(key)
+  {
+    case 'R': // Rotate Encoder Clockwise
+      inputPost(INPUT_ROTATE, source, 1, 1);
+      event |= REMOTE_PREFS;
+      break;
+    case 'r': // Rotate Encoder Counterclockwise
+      inputPost(INPUT_ROTATE, source, -1, -1);
+      event |= REMOTE_PREFS;
+      break;
+    case 'e': // Encoder Push Button
+      inputPost(INPUT_CLICK, source);
+      break;
+    case 'B': case 'b': case 'M': case 'm': case 'S': case 's':
+    case 'W': case 'w': case 'A': case 'a': case 'V': case 'v':
+    case 'L': case 'l': case 'O': case 'o': case 'I': case 'i':
+    case '>': case '<':
+      // Run later by remoteApplyCommand(), in order with other input
+      break;
     case 'C':
       state->remoteLogOn = false;
+      cpuBoost(CPU_FREQ_MAX);
       remoteCaptureScreen(stream);
       break;
+    case 'c':
+      state->remoteLogOn = false;
+      cpuBoost(CPU_FREQ_MAX);
+      remoteCaptureScreenBinary(stream);
+      break;
+    case 'D':
+      remoteSetMirror(stream, state);
+      break;
+    case 'd':
+      remoteMirrorStart(stream, state, 0, 0);
+      break;
     case 't':
       state->remoteLogOn = !state->remoteLogOn;
       break;
@@ -409,9 +1082,37 @@ int remoteDoCommand(Stream* stream, RemoteState* state, char key)
       break;
     case '#':
       if (remoteSetMemory(stream))
+      {
+        bankSyncMemories();
+        event |= REMOTE_PREFS;
+      }
+      break;
+    case '&':
+      remoteAddChannel(stream);
+      break;
+    case '%':
+      remoteListChannels(stream);
+      break;
+
+    case '?':
+      remoteGetSettings(stream);
+      break;
+    case '=':
+      if (remoteSetSetting(stream))
         event |= REMOTE_PREFS;
       break;
 
+    case 'P':
+      remotePrintProfile(stream);
+      break;
+    case 'p':
+      profReset();
+      break;
+
+    case 'H':
+      heapDump(stream);
+      break;
+
     case 'T':
       stream->println(switchThemeEditor(!switchThemeEditor()) ? "Theme editor enabled" : "Theme editor disabled");
       break;
@@ -431,13 +1132,35 @@ int remoteDoCommand(Stream* stream, RemoteState* state, char key)
   return(event | REMOTE_CHANGED);
 }
 
-int serialDoCommand(Stream* stream, RemoteState* state, uint8_t usbMode)
+//
+// Execute pending remote commands, posting them as input events. Up to
+// INPUT_BATCH commands are handled per call, and none while the input
+// queue has no room for the events they may post.
+//
+void remoteDoCommands(Stream* stream, RemoteState* state, uint8_t source)
 {
-  if(usbMode == USB_OFF) return 0;
+  bool queued = false;
+
+  for(int i = 0 ; i < INPUT_BATCH && inputHasRoom(INPUT_REMOTE_MAX) && stream->available() ; i++)
+  {
+    // Commands run right away have to wait until queued ones are done
+    char key = stream->peek();
+    bool deferred = key && strchr(REMOTE_QUEUED, key);
+    if(queued && !deferred) break;
+    queued |= deferred;
+
+    int event = remoteDoCommand(stream, state, stream->read(), source);
+    if(event) inputPost(INPUT_COMMAND, source, key, event);
+  }
+
+  remoteUpdateJob(state);
+}
+
+void serialDoCommand(Stream* stream, RemoteState* state, uint8_t usbMode)
+{
+  if(usbMode == USB_OFF) return;
 
-  if (Serial.available())
-    return remoteDoCommand(stream, state, Serial.read());
-  return 0;
+  remoteDoCommands(stream, state, INPUT_SERIAL);
 }
 
 void serialTickTime(Stream* stream, RemoteState* state, uint8_t usbMode)
@@ -1,15 +1,31 @@
 #ifndef REMOTE_H
 #define REMOTE_H
 
+#include "Draw.h"
+#include "Scheduler.h"
+
+#define MIRROR_MAX_BUDGET 32768 // Maximal bytes per mirror update
+#define MIRROR_TILE_MAX   (1 + DRAW_TILE_W * DRAW_TILE_H * 3) // Worst case encoded tile
+#define MIRROR_BUF_SIZE   (MIRROR_MAX_BUDGET + MIRROR_TILE_MAX) // Mirror update buffer
+
 typedef struct {
   uint32_t remoteTimer = millis();
   uint8_t remoteSeqnum = 0;
   bool remoteLogOn = false;
+  uint16_t mirrorTime = 0;              // Screen mirror update period (ms), 0 = off
+  uint16_t mirrorBudget = 0;            // Maximal bytes per mirror update
+  uint32_t mirrorTimer = 0;             // Time of the last mirror update
+  uint8_t mirrorNextTile = 0;           // Tile to start next mirror update from
+  uint16_t mirrorSent[DRAW_TILES] = {}; // Tile generations sent to remote
+  bool jobActive = false;               // Keeping the remote job running
 } RemoteState;
 
+void remoteInit(SchedJob job);
 void remoteTickTime(Stream* stream, RemoteState* state);
-int remoteDoCommand(Stream* stream, RemoteState* state, char key);
-int serialDoCommand(Stream* stream, RemoteState* state, uint8_t usbMode);
+int remoteApplyCommand(char key);
+int remoteDoCommand(Stream* stream, RemoteState* state, char key, uint8_t source);
+void remoteDoCommands(Stream* stream, RemoteState* state, uint8_t source);
+void serialDoCommand(Stream* stream, RemoteState* state, uint8_t usbMode);
 void serialTickTime(Stream* stream, RemoteState* state, uint8_t usbMode);
 
 #endif
@@ -1,27 +1,23 @@
 #include "Common.h"
 #include "Utils.h"
 #include "Menu.h"
+#include "Radio.h"
+#include "Cpu.h"
+#include "Arena.h"
+#include "Scheduler.h"
 
-// Tuning delays after rx.setFrequency()
-#define TUNE_DELAY_DEFAULT 30
-#define TUNE_DELAY_FM      60
-#define TUNE_DELAY_AM_SSB  80
-
-#define SCAN_POLL_TIME    10 // Tuning status polling interval (msecs)
 #define SCAN_POINTS      200 // Number of frequencies to scan
 
 #define SCAN_OFF    0   // Scanner off, no data
-#define SCAN_RUN    1   // Scanner running
+#define SCAN_RUN    1   // Scanner running, scanCount points so far
 #define SCAN_DONE   2   // Scanner done, valid data in scanData[]
 
-static struct
-{
-  uint8_t rssi;
-  uint8_t snr;
-} scanData[SCAN_POINTS];
+// Allocated from the arena on the first scan, written by the radio
+// task while the scan runs
+static RadioScanPoint *scanData = NULL;
 
-static uint32_t scanTime = millis();
 static uint8_t  scanStatus = SCAN_OFF;
+static uint8_t  scanJob = SCHED_MAX_JOBS;
 
 static uint16_t scanStartFreq;
 static uint16_t scanStep;
@@ -36,13 +32,13 @@ static inline uint8_t max(uint8_t a, uint8_t b) { return(a>b? a:b); }
 
 bool scanHasData(void)
 {
-  return(scanStatus == SCAN_DONE);
+  return(scanStatus == SCAN_DONE || (scanStatus == SCAN_RUN && scanCount));
 }
 
 float scanGetRSSI(uint16_t freq)
 {
   // Input frequency must be in range of existing data
-  if((scanStatus!=SCAN_DONE) || (freq<scanStartFreq) || (freq>=scanStartFreq+scanStep*scanCount))
+  if(!scanHasData() || (freq<scanStartFreq) || (freq>=scanStartFreq+scanStep*scanCount))
     return(0.0);
 
   uint8_t result = scanData[(freq - scanStartFreq) / scanStep].rssi;
@@ -52,15 +48,67 @@ float scanGetRSSI(uint16_t freq)
 float scanGetSNR(uint16_t freq)
 {
   // Input frequency must be in range of existing data
-  if((scanStatus!=SCAN_DONE) || (freq<scanStartFreq) || (freq>=scanStartFreq+scanStep*scanCount))
+  if(!scanHasData() || (freq<scanStartFreq) || (freq>=scanStartFreq+scanStep*scanCount))
     return(0.0);
 
   uint8_t result = scanData[(freq - scanStartFreq) / scanStep].snr;
   return((result - scanMinSNR) / (float)(scanMaxSNR - scanMinSNR + 1));
 }
 
-static void scanInit(uint16_t centerFreq, uint16_t step)
+//
+// Follow scan progress on the radio task, runs while scanning. Points
+// measured so far are shown as they come in.
+//
+static bool scanTickTime()
 {
+  RadioStatus status;
+  bool busy = radioBusy();
+
+  radioGetStatus(&status);
+
+  // Until the radio task picks up the scan, the count is a stale one
+  if(busy && !status.scanning) return(false);
+
+  bool changed = status.scanCount != scanCount;
+
+  // Measure range of values
+  for( ; scanCount < status.scanCount ; scanCount++)
+  {
+    scanMinRSSI = min(scanData[scanCount].rssi, scanMinRSSI);
+    scanMaxRSSI = max(scanData[scanCount].rssi, scanMaxRSSI);
+    scanMinSNR  = min(scanData[scanCount].snr, scanMinSNR);
+    scanMaxSNR  = max(scanData[scanCount].snr, scanMaxSNR);
+  }
+
+  if(busy) return(changed);
+
+  // Scan is over, keep whatever it has measured
+  schedStop(scanJob);
+  scanStatus = scanCount? SCAN_DONE : SCAN_OFF;
+  muteOn(MUTE_TEMP, false);
+  return(true);
+}
+
+//
+// Register the job following scans, call this from setup()
+//
+void scanInit()
+{
+  scanJob = schedAdd(scanTickTime, SCHED_SCAN_TIME, false);
+}
+
+//
+// Scan around centerFreq in the background, within the current band.
+// The radio task does the measuring, scanTickTime() collects results.
+//
+void scanRun(uint16_t centerFreq, uint16_t step)
+{
+  // One scan at a time
+  if(scanStatus == SCAN_RUN) return;
+
+  if(!scanData) scanData = (RadioScanPoint *)arenaAlloc(ARENA_SCAN, SCAN_POINTS * sizeof(RadioScanPoint));
+  if(!scanData) return;
+
   scanStep    = step;
   scanCount   = 0;
   scanMinRSSI = 255;
@@ -68,7 +116,6 @@ static void scanInit(uint16_t centerFreq, uint16_t step)
   scanMinSNR  = 255;
   scanMaxSNR  = 0;
   scanStatus  = SCAN_RUN;
-  scanTime    = millis();
 
   const Band *band = getCurrentBand();
   int freq = scanStep * (centerFreq / scanStep - SCAN_POINTS / 2);
@@ -80,83 +127,30 @@ static void scanInit(uint16_t centerFreq, uint16_t step)
     freq = band->minimumFreq;
   scanStartFreq = freq;
 
-  // Clear scan data
-  memset(scanData, 0, sizeof(scanData));
-}
-
-static bool scanTickTime()
-{
-  // Scan must be on
-  if((scanStatus!=SCAN_RUN) || (scanCount>=SCAN_POINTS)) return(false);
-
-  // Wait for the right time
-  if(millis() - scanTime < SCAN_POLL_TIME) return(true);
-
-  // This is our current frequency to scan
-  uint16_t freq = scanStartFreq + scanStep * scanCount;
-
-  // Poll for the tuning status
-  rx.getStatus(0, 0);
-  if(!rx.getTuneCompleteTriggered())
-  {
-    scanTime = millis();
-    return(true);
-  }
-
-  // If frequency not yet set, set it and wait until next call to measure
-  if(rx.getCurrentFrequency() != freq)
-  {
-    rx.setFrequency(freq); // Implies tuning delay
-    scanTime = millis() - SCAN_POLL_TIME;
-    return(true);
-  }
-
-  // Measure RSSI/SNR values
-  rx.getCurrentReceivedSignalQuality();
-  scanData[scanCount].rssi = rx.getCurrentRSSI();
-  scanData[scanCount].snr  = rx.getCurrentSNR();
-
-  // Measure range of values
-  scanMinRSSI = min(scanData[scanCount].rssi, scanMinRSSI);
-  scanMaxRSSI = max(scanData[scanCount].rssi, scanMaxRSSI);
-  scanMinSNR  = min(scanData[scanCount].snr, scanMinSNR);
-  scanMaxSNR  = max(scanData[scanCount].snr, scanMaxSNR);
+  // Stop at the band end
+  uint16_t count = (band->maximumFreq - scanStartFreq) / scanStep + 1;
+  if(count > SCAN_POINTS) count = SCAN_POINTS;
 
-  // Next frequency to scan
-  freq += scanStep;
+  // Clear scan data
+  memset(scanData, 0, SCAN_POINTS * sizeof(RadioScanPoint));
 
-  // Set next frequency to scan or expire scan
-  if((++scanCount >= SCAN_POINTS) || !isFreqInBand(getCurrentBand(), freq) || checkStopSeeking())
-    scanStatus = SCAN_DONE;
-  else
-    rx.setFrequency(freq); // Implies tuning delay
+  // Full speed while measuring, mute the audio until the scan is over
+  cpuBoost(CPU_FREQ_MAX);
+  muteOn(MUTE_TEMP, true);
 
-  // Save last scan time
-  scanTime = millis() - SCAN_POLL_TIME;
+  radioScan(scanData, scanStartFreq, scanStep, count, currentMode == FM);
+  schedStart(scanJob, SCHED_SCAN_TIME);
 
-  // Return current scan status
-  return(scanStatus==SCAN_RUN);
+  // Before the radio task starts, the scan is over by now
+  scanTickTime();
 }
 
 //
-// Run entire scan once
+// Stop scan in progress, returns TRUE if there was one
 //
-void scanRun(uint16_t centerFreq, uint16_t step)
+bool scanCancel()
 {
-  // Set tuning delay
-  rx.setMaxDelaySetFrequency(currentMode == FM ? TUNE_DELAY_FM : TUNE_DELAY_AM_SSB);
-  // Mute the audio
-  muteOn(MUTE_TEMP, true);
-  // Flag is set by rotary encoder and cleared on seek/scan entry
-  seekStop = false;
-  // Save current frequency
-  uint16_t curFreq = rx.getFrequency();
-  // Scan the whole range
-  for(scanInit(centerFreq, step) ; scanTickTime(););
-  // Restore current frequency
-  rx.setFrequency(curFreq);
-  // Unmute the audio
-  muteOn(MUTE_TEMP, false);
-  // Restore tuning delay
-  rx.setMaxDelaySetFrequency(TUNE_DELAY_DEFAULT);
+  if(scanStatus != SCAN_RUN) return(false);
+  radioScanStop();
+  return(true);
 }
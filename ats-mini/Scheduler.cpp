@@ -0,0 +1,142 @@
+#include "Common.h"
+#include "Scheduler.h"
+
+//
+// Cooperative scheduler for the main loop. Every subsystem registers
+// a job with a period, the loop runs jobs that are due and then sleeps
+// until the earliest deadline or an input event, whichever comes first.
+//
+
+typedef struct
+{
+  SchedJob job;     // Function to call
+  uint32_t period;  // Period (ms), 0 for one-shot jobs
+  uint32_t due;     // Time when the job is due next
+  bool active;      // TRUE: job is waiting for its deadline
+  uint8_t phase;    // Profiled phase the job time counts to
+} SchedEntry;
+
+static SchedEntry jobs[SCHED_MAX_JOBS];
+static uint8_t jobCount = 0;
+
+// Main loop task, woken up by input events
+static TaskHandle_t loopTask = NULL;
+
+//
+// Remember the calling task as the one to wake up on input events,
+// call this from setup()
+//
+void schedInit()
+{
+  loopTask = xTaskGetCurrentTaskHandle();
+}
+
+//
+// Register a job running every period ms (period = 0 for a one-shot
+// job). The time the job takes is profiled as given phase. Returns
+// job ID, to be used with schedStart() and schedStop().
+//
+uint8_t schedAdd(SchedJob job, uint32_t period, bool start, uint8_t phase)
+{
+  if(jobCount >= SCHED_MAX_JOBS) return(SCHED_MAX_JOBS);
+
+  jobs[jobCount].job    = job;
+  jobs[jobCount].period = period;
+  jobs[jobCount].due    = millis() + period;
+  jobs[jobCount].active = start;
+  jobs[jobCount].phase  = phase;
+  return(jobCount++);
+}
+
+//
+// (Re)start given job, running it after delay ms
+//
+void schedStart(uint8_t id, uint32_t delay)
+{
+  if(id >= jobCount) return;
+
+  jobs[id].due = millis() + delay;
+  jobs[id].active = true;
+}
+
+//
+// Stop given job until it is started again
+//
+void schedStop(uint8_t id)
+{
+  if(id < jobCount) jobs[id].active = false;
+}
+
+//
+// Run all jobs that are due. Returns TRUE if any of them needs the
+// screen refreshed.
+//
+bool schedRun()
+{
+  bool needRefresh = false;
+
+  for(int i = 0 ; i < jobCount ; i++)
+  {
+    uint32_t now = millis();
+
+    if(!jobs[i].active || (int32_t)(now - jobs[i].due) < 0) continue;
+
+    if(!jobs[i].period)
+      jobs[i].active = false;
+    else
+    {
+      // Keep the cadence, unless the job has fallen behind
+      jobs[i].due += jobs[i].period;
+      if((int32_t)(now - jobs[i].due) >= 0) jobs[i].due = now + jobs[i].period;
+    }
+
+    uint32_t start = profStart();
+    needRefresh |= jobs[i].job();
+    profEnd(jobs[i].phase, start);
+  }
+
+  return(needRefresh);
+}
+
+//
+// Sleep until the next job is due, an input event arrives, or maxTime
+// ms pass, whichever comes first
+//
+void schedWait(uint32_t maxTime)
+{
+  uint32_t now = millis();
+  uint32_t wait = maxTime;
+
+  for(int i = 0 ; i < jobCount && wait ; i++)
+    if(jobs[i].active)
+      wait = (int32_t)(jobs[i].due - now) <= 0? 0 : min(wait, jobs[i].due - now);
+
+  if(!wait) return;
+
+  if(loopTask)
+    ulTaskNotifyTake(pdTRUE, wait == SCHED_FOREVER? portMAX_DELAY : pdMS_TO_TICKS(wait));
+  else
+    delay(min(wait, (uint32_t)SCHED_BUTTON_TIME));
+}
+
+//
+// Wake up the main loop on an input event
+//
+void schedWake()
+{
+  if(loopTask) xTaskNotifyGive(loopTask);
+}
+
+//
+// Wake up the main loop on an input event, from an interrupt handler
+//
+void IRAM_ATTR schedWakeFromISR()
+{
+  BaseType_t woken = pdFALSE;
+
+  if(loopTask)
+  {
+    vTaskNotifyGiveFromISR(loopTask, &woken);
+    if(woken) portYIELD_FROM_ISR();
+  }
+}
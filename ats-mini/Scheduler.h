@@ -0,0 +1,42 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include "Profile.h"
+
+// Periods of the main loop jobs (ms)
+#define SCHED_RSSI_TIME        200  // Signal quality and squelch check
+#define SCHED_RDS_TIME         250  // RDS data check
+#define SCHED_SCHEDULE_TIME   2000  // Identify current frequency again
+#define SCHED_NTP_TIME       60000  // NTP time refresh
+#define SCHED_CLOCK_TIME       250  // Wall clock update
+#define SCHED_TIMEOUT_TIME     100  // Command and display sleep timeouts
+#define SCHED_PREFS_TIME       500  // Delayed preferences save
+#define SCHED_NET_TIME         500  // Delayed WiFi connection
+#define SCHED_REMOTE_TIME       33  // Remote status log and screen mirror
+#define SCHED_BLE_TIME          20  // Bluetooth notifications, one chunk each
+#define SCHED_BACKGROUND_TIME 5000  // Screen refresh when nothing else triggers it
+#define SCHED_BUTTON_TIME       10  // Button polling while it is pressed
+#define SCHED_IDENTIFY_TIME    300  // Station lookup once the tuning knob settles
+#define SCHED_SEEK_TIME         33  // Seek progress display, once per frame
+#define SCHED_SCAN_TIME        100  // Scan progress display
+#define SCHED_SETTLE_TIME      300  // Band change once the menu selection settles
+#define SCHED_CPU_TIME        1000  // CPU clock governor
+#define SCHED_HEAP_TIME      60000  // Heap usage sample
+
+#define SCHED_MAX_JOBS   20         // Maximal number of jobs
+#define SCHED_FOREVER    0xFFFFFFFF // No deadline
+
+// Job function, returns TRUE if the screen needs a refresh
+typedef bool (*SchedJob)();
+
+void schedInit();
+uint8_t schedAdd(SchedJob job, uint32_t period, bool start = true, uint8_t phase = PROF_JOBS);
+void schedStart(uint8_t id, uint32_t delay);
+void schedStop(uint8_t id);
+bool schedRun();
+void schedWait(uint32_t maxTime = SCHED_FOREVER);
+void schedWake();
+void schedWakeFromISR();
+
+#endif // SCHEDULER_H
@@ -0,0 +1,166 @@
+#include "Common.h"
+#include "Settings.h"
+#include "Themes.h"
+#include "Utils.h"
+#include "Menu.h"
+#include "Ble.h"
+
+//
+// Settings registry. Each saved setting is described here once: saving,
+// loading, the remote get/set commands and the web configuration form
+// are all driven by this table. Settings are saved in table order, so
+// new settings go to the end, with VER_SETTINGS bumped if the saved
+// size changes.
+//
+
+static constexpr Setting settings[] =
+{
+  { "Brightness",  "Brightness",      SET_U16,  SET_REMOTE|SET_WEB, &currentBrt,      10, 255, DEFAULT_BRIGHTNESS, NULL, [] { doBrt(0); } },
+  { "Sleep",       "Sleep Timeout",   SET_U16,  SET_REMOTE|SET_WEB, &currentSleep,     0, 255, DEFAULT_SLEEP, NULL, NULL },
+  { "Volume",      "Volume",          SET_U8,   SET_REMOTE|SET_WEB, &volume,           0,  63, DEFAULT_VOLUME, NULL, [] { doVolume(0); } },
+  { "Band",        "Band",            SET_INT,  0,                  &bandIdx,          0,   0, 0, getTotalBands, NULL },
+  { "WiFiMode",    "WiFi Mode",       SET_U8,   SET_REMOTE,         &wifiModeIdx,      0,   0, NET_OFF, getTotalWiFiModes, netRequestInit },
+  { "FmAGC",       "FM AGC/ATTN",     SET_I8,   SET_REMOTE,         &FmAgcIdx,         0,  27, 0, NULL, [] { doAgc(0); } },
+  { "AmAGC",       "AM AGC/ATTN",     SET_I8,   SET_REMOTE,         &AmAgcIdx,         0,  37, 0, NULL, [] { doAgc(0); } },
+  { "SsbAGC",      "SSB AGC/ATTN",    SET_I8,   SET_REMOTE,         &SsbAgcIdx,        0,   1, 0, NULL, [] { doAgc(0); } },
+  { "AmAVC",       "AM AVC",          SET_I8,   SET_REMOTE,         &AmAvcIdx,        12,  90, 48, NULL, [] { doAvc(0); } },
+  { "SsbAVC",      "SSB AVC",         SET_I8,   SET_REMOTE,         &SsbAvcIdx,       12,  90, 48, NULL, [] { doAvc(0); } },
+  { "AmSoftMute",  "AM Soft Mute",    SET_I8,   SET_REMOTE,         &AmSoftMuteIdx,    0,  32, 4, NULL, [] { doSoftMute(0); } },
+  { "SsbSoftMute", "SSB Soft Mute",   SET_I8,   SET_REMOTE,         &SsbSoftMuteIdx,   0,  32, 4, NULL, [] { doSoftMute(0); } },
+  { "Theme",       "Theme",           SET_U8,   SET_REMOTE,         &themeIdx,         0,   0, 0, getTotalThemes, NULL },
+  { "RDSMode",     "RDS Mode",        SET_U8,   SET_REMOTE,         &rdsModeIdx,       0,   0, 0, getTotalRDSModes, [] { if(!(getRDSMode() & RDS_CT)) clockReset(); } },
+  { "SleepMode",   "Sleep Mode",      SET_U8,   SET_REMOTE,         &sleepModeIdx,     0,   0, SLEEP_LOCKED, getTotalSleepModes, NULL },
+  { "ZoomMenu",    "Zoomed Menu",     SET_BOOL, SET_REMOTE|SET_WEB, &zoomMenu,         0,   1, 0, NULL, NULL },
+  { "ScrollDir",   "Reverse Scrolling", SET_DIR, SET_REMOTE|SET_WEB, &scrollDirection, 0,   1, 0, NULL, NULL },
+  { "UTCOffset",   "Time Zone",       SET_U8,   SET_REMOTE,         &utcOffsetIdx,     0,   0, 8, getTotalUTCOffsets, clockRefreshTime },
+  { "Squelch",     "Squelch",         SET_U8,   SET_REMOTE|SET_WEB, &currentSquelch,   0, 127, 0, NULL, NULL },
+  { "FmRegion",    "FM Region",       SET_U8,   SET_REMOTE,         &FmRegionIdx,      0,   0, 0, getTotalFmRegions, [] { doFmRegion(0); } },
+  { "UILayout",    "UI Layout",       SET_U8,   SET_REMOTE,         &uiLayoutIdx,      0,   0, UI_DEFAULT, getTotalUILayouts, NULL },
+  { "BLEMode",     "Bluetooth Mode",  SET_U8,   SET_REMOTE,         &bleModeIdx,       0,   0, BLE_OFF, getTotalBleModes, [] { bleRequestInit(); } },
+  { "USBMode",     "USB Mode",        SET_U8,   SET_REMOTE,         &usbModeIdx,       0,   0, USB_OFF, getTotalUSBModes, NULL },
+};
+
+static constexpr size_t settingSize(uint8_t type)
+{
+  return(type == SET_U16? 2 : 1);
+}
+
+static constexpr size_t settingsBytes()
+{
+  size_t size = 0;
+  for(const Setting &s : settings) size += settingSize(s.type);
+  return(size);
+}
+
+static_assert(settingsBytes() <= SETTINGS_MAX_SIZE, "Settings do not fit into a chunk");
+static_assert(ITEM_COUNT(settings) <= 32, "Settings do not fit into the web apply mask");
+
+uint8_t settingsCount()
+{
+  return(ITEM_COUNT(settings));
+}
+
+const Setting *settingsGet(uint8_t idx)
+{
+  return(idx < ITEM_COUNT(settings)? &settings[idx] : NULL);
+}
+
+const Setting *settingsFind(const char *key)
+{
+  for(const Setting &s : settings)
+    if(!strcasecmp(s.key, key)) return(&s);
+
+  return(NULL);
+}
+
+int32_t settingMax(const Setting *s)
+{
+  return(s->count? s->count() - 1 : s->max);
+}
+
+int32_t settingRead(const Setting *s)
+{
+  switch(s->type)
+  {
+    case SET_U8:   return(*(uint8_t *)s->value);
+    case SET_I8:   return(*(int8_t *)s->value);
+    case SET_U16:  return(*(uint16_t *)s->value);
+    case SET_BOOL: return(*(bool *)s->value);
+    case SET_INT:  return(*(int *)s->value);
+    case SET_DIR:  return(*(int8_t *)s->value < 0);
+  }
+
+  return(0);
+}
+
+//
+// Change a setting, returns FALSE if the value is out of bounds. With
+// apply set, the new value is also put into effect.
+//
+bool settingWrite(const Setting *s, int32_t value, bool apply)
+{
+  if(value < s->min || value > settingMax(s)) return(false);
+
+  switch(s->type)
+  {
+    case SET_U8:   *(uint8_t *)s->value  = value;      break;
+    case SET_I8:   *(int8_t *)s->value   = value;      break;
+    case SET_U16:  *(uint16_t *)s->value = value;      break;
+    case SET_BOOL: *(bool *)s->value     = value;      break;
+    case SET_INT:  *(int *)s->value      = value;      break;
+    case SET_DIR:  *(int8_t *)s->value   = value? -1 : 1; break;
+  }
+
+  if(apply && s->apply) s->apply();
+  return(true);
+}
+
+//
+// Give all settings their default values. The globals holding settings
+// are not initialized anywhere else, defaults are only kept here.
+//
+void settingsDefaults()
+{
+  for(const Setting &s : settings) settingWrite(&s, s.def);
+}
+
+//
+// Size of all settings, as saved by settingsPack()
+//
+size_t settingsSize()
+{
+  return(settingsBytes());
+}
+
+//
+// Save all settings to a buffer of settingsSize() bytes
+//
+size_t settingsPack(uint8_t *buf)
+{
+  uint8_t *p = buf;
+
+  for(const Setting &s : settings)
+  {
+    int32_t value = settingRead(&s);
+    *p++ = value;
+    if(settingSize(s.type) > 1) *p++ = value >> 8;
+  }
+
+  return(p - buf);
+}
+
+//
+// Load all settings from a buffer filled by settingsPack(), settings out
+// of bounds get their default values
+//
+void settingsUnpack(const uint8_t *buf)
+{
+  for(const Setting &s : settings)
+  {
+    int32_t value = s.type == SET_I8? (int8_t)*buf : *buf;
+    if(settingSize(s.type) > 1) value |= buf[1] << 8;
+    buf += settingSize(s.type);
+
+    if(!settingWrite(&s, value)) settingWrite(&s, s.def);
+  }
+}
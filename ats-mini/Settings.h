@@ -0,0 +1,46 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SETTINGS_MAX_SIZE 30 // Maximal size of all saved settings (bytes)
+
+// Storage types
+#define SET_U8     0 // uint8_t
+#define SET_I8     1 // int8_t
+#define SET_U16    2 // uint16_t, saved as two bytes
+#define SET_BOOL   3 // bool
+#define SET_INT    4 // int, saved as one byte
+#define SET_DIR    5 // int8_t direction (1 or -1), saved as TRUE if -1
+
+// Flags
+#define SET_REMOTE 0x01 // Can be read and changed remotely
+#define SET_WEB    0x02 // Shown on the web configuration page
+
+typedef struct
+{
+  const char *key;        // Preferences key, remote and web form name
+  const char *label;      // Human readable name
+  uint8_t type;           // SET_U8, SET_I8, ...
+  uint8_t flags;          // SET_REMOTE, SET_WEB, ...
+  void *value;            // Global variable holding the setting
+  int16_t min;            // Minimal value
+  int16_t max;            // Maximal value, unless count is set
+  int16_t def;            // Default, replaces saved values out of bounds
+  int (*count)();         // Number of choices, for settings picked from a list
+  void (*apply)();        // Puts a changed value into effect, may be NULL
+} Setting;
+
+uint8_t settingsCount();
+const Setting *settingsGet(uint8_t idx);
+const Setting *settingsFind(const char *key);
+int32_t settingMax(const Setting *s);
+int32_t settingRead(const Setting *s);
+bool settingWrite(const Setting *s, int32_t value, bool apply = false);
+void settingsDefaults();
+size_t settingsSize();
+size_t settingsPack(uint8_t *buf);
+void settingsUnpack(const uint8_t *buf);
+
+#endif // SETTINGS_H
@@ -0,0 +1,230 @@
+#ifndef SPRITE_H
+#define SPRITE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <TFT_eSPI.h>
+
+// Recorded drawing calls
+#define SPRITE_FILL          1
+#define SPRITE_PIXEL         2
+#define SPRITE_LINE          3
+#define SPRITE_FILL_RECT     4
+#define SPRITE_ROUND_RECT    5
+#define SPRITE_FILL_ROUND    6
+#define SPRITE_CIRCLE        7
+#define SPRITE_FILL_CIRCLE   8
+#define SPRITE_TRIANGLE      9
+#define SPRITE_FILL_TRIANGLE 10
+#define SPRITE_SMOOTH_FILL   11
+#define SPRITE_SMOOTH_RECT   12
+#define SPRITE_SMOOTH_ARC    13
+#define SPRITE_IMAGE         14
+#define SPRITE_TEXT          15
+
+#define SPRITE_MAX_ARGS      10    // Most arguments recorded per call
+
+bool drawTracking();
+void drawRecord(const int32_t *args, uint8_t count, int32_t x0, int32_t y0, int32_t x1, int32_t y1, const char *text = 0);
+
+//
+// Screen sprite. Drawing calls are passed on to TFT_eSprite and, while
+// screen tiles are tracked, also recorded by drawRecord() along with
+// the area they cover, so that changed tiles are known from the calls
+// made rather than from the pixels. Calls the library makes to itself
+// are not recorded, and text calls record the text style in effect.
+// Images are recorded by their address, they are not expected to
+// change once drawn.
+//
+class DrawSprite : public TFT_eSprite
+{
+  public:
+    DrawSprite(TFT_eSPI *tft) : TFT_eSprite(tft) {}
+
+    void fillSprite(uint32_t color)
+    {
+      int32_t a[] = { SPRITE_FILL, (int32_t)color };
+      record(a, 2, 0, 0, width() - 1, height() - 1);
+      nested++; TFT_eSprite::fillSprite(color); nested--;
+    }
+
+    void drawPixel(int32_t x, int32_t y, uint32_t color)
+    {
+      int32_t a[] = { SPRITE_PIXEL, x, y, (int32_t)color };
+      record(a, 4, x, y, x, y);
+      nested++; TFT_eSprite::drawPixel(x, y, color); nested--;
+    }
+
+    void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color)
+    {
+      int32_t a[] = { SPRITE_LINE, x0, y0, x1, y1, (int32_t)color };
+      record(a, 6, min(x0, x1), min(y0, y1), max(x0, x1), max(y0, y1));
+      nested++; TFT_eSprite::drawLine(x0, y0, x1, y1, color); nested--;
+    }
+
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color)
+    {
+      int32_t a[] = { SPRITE_FILL_RECT, x, y, w, h, (int32_t)color };
+      record(a, 6, x, y, x + w - 1, y + h - 1);
+      nested++; TFT_eSprite::fillRect(x, y, w, h, color); nested--;
+    }
+
+    void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color)
+    {
+      int32_t a[] = { SPRITE_ROUND_RECT, x, y, w, h, r, (int32_t)color };
+      record(a, 7, x, y, x + w - 1, y + h - 1);
+      nested++; TFT_eSprite::drawRoundRect(x, y, w, h, r, color); nested--;
+    }
+
+    void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color)
+    {
+      int32_t a[] = { SPRITE_FILL_ROUND, x, y, w, h, r, (int32_t)color };
+      record(a, 7, x, y, x + w - 1, y + h - 1);
+      nested++; TFT_eSprite::fillRoundRect(x, y, w, h, r, color); nested--;
+    }
+
+    void drawCircle(int32_t x, int32_t y, int32_t r, uint32_t color)
+    {
+      int32_t a[] = { SPRITE_CIRCLE, x, y, r, (int32_t)color };
+      record(a, 5, x - r, y - r, x + r, y + r);
+      nested++; TFT_eSprite::drawCircle(x, y, r, color); nested--;
+    }
+
+    void fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color)
+    {
+      int32_t a[] = { SPRITE_FILL_CIRCLE, x, y, r, (int32_t)color };
+      record(a, 5, x - r, y - r, x + r, y + r);
+      nested++; TFT_eSprite::fillCircle(x, y, r, color); nested--;
+    }
+
+    void drawTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color)
+    {
+      int32_t a[] = { SPRITE_TRIANGLE, x0, y0, x1, y1, x2, y2, (int32_t)color };
+      record(a, 8, min(x0, min(x1, x2)), min(y0, min(y1, y2)), max(x0, max(x1, x2)), max(y0, max(y1, y2)));
+      nested++; TFT_eSprite::drawTriangle(x0, y0, x1, y1, x2, y2, color); nested--;
+    }
+
+    void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color)
+    {
+      int32_t a[] = { SPRITE_FILL_TRIANGLE, x0, y0, x1, y1, x2, y2, (int32_t)color };
+      record(a, 8, min(x0, min(x1, x2)), min(y0, min(y1, y2)), max(x0, max(x1, x2)), max(y0, max(y1, y2)));
+      nested++; TFT_eSprite::fillTriangle(x0, y0, x1, y1, x2, y2, color); nested--;
+    }
+
+    // Anti-aliased shapes may spill a pixel outside their bounds
+    void fillSmoothRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color, uint32_t bg = 0x00FFFFFF)
+    {
+      int32_t a[] = { SPRITE_SMOOTH_FILL, x, y, w, h, r, (int32_t)color, (int32_t)bg };
+      record(a, 8, x - 1, y - 1, x + w, y + h);
+      nested++; TFT_eSprite::fillSmoothRoundRect(x, y, w, h, r, color, bg); nested--;
+    }
+
+    void drawSmoothRoundRect(int32_t x, int32_t y, int32_t r, int32_t ir, int32_t w, int32_t h, uint32_t fg, uint32_t bg = 0x00FFFFFF, uint8_t quadrants = 0xF)
+    {
+      int32_t a[] = { SPRITE_SMOOTH_RECT, x, y, r, ir, w, h, (int32_t)fg, (int32_t)bg, quadrants };
+      record(a, 10, x - 1, y - 1, x + w + 2 * r + 1, y + h + 2 * r + 1);
+      nested++; TFT_eSprite::drawSmoothRoundRect(x, y, r, ir, w, h, fg, bg, quadrants); nested--;
+    }
+
+    void drawSmoothArc(int32_t x, int32_t y, int32_t r, int32_t ir, uint32_t startAngle, uint32_t endAngle, uint32_t fg, uint32_t bg, bool roundEnds = false)
+    {
+      int32_t a[] = { SPRITE_SMOOTH_ARC, x, y, r, ir, (int32_t)startAngle, (int32_t)endAngle, (int32_t)fg, (int32_t)bg, roundEnds };
+      record(a, 10, x - r - 1, y - r - 1, x + r + 1, y + r + 1);
+      nested++; TFT_eSprite::drawSmoothArc(x, y, r, ir, startAngle, endAngle, fg, bg, roundEnds); nested--;
+    }
+
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data)
+    {
+      int32_t a[] = { SPRITE_IMAGE, x, y, w, h, (int32_t)(intptr_t)data };
+      record(a, 6, x, y, x + w - 1, y + h - 1);
+      nested++; TFT_eSprite::pushImage(x, y, w, h, data); nested--;
+    }
+
+    void setTextDatum(uint8_t d)
+    {
+      textDatum = d;
+      TFT_eSprite::setTextDatum(d);
+    }
+
+    void setTextColor(uint16_t c)
+    {
+      textFg = textBg = c;
+      textFill = false;
+      TFT_eSprite::setTextColor(c);
+    }
+
+    void setTextColor(uint16_t c, uint16_t b, bool bgfill = false)
+    {
+      textFg = c;
+      textBg = b;
+      textFill = bgfill;
+      TFT_eSprite::setTextColor(c, b, bgfill);
+    }
+
+    void setTextFont(uint8_t f)
+    {
+      textFont = f;
+      textFreeFont = 0;
+      TFT_eSprite::setTextFont(f);
+    }
+
+    void setFreeFont(const GFXfont *f = 0)
+    {
+      textFont = 1;
+      textFreeFont = f;
+      TFT_eSprite::setFreeFont(f);
+    }
+
+    int16_t drawString(const char *s, int32_t x, int32_t y, uint8_t font)
+    {
+      if(!nested && drawTracking())
+        recordText(s, x, y, font, textWidth(s, font), fontHeight(font));
+
+      nested++;
+      int16_t width = TFT_eSprite::drawString(s, x, y, font);
+      nested--;
+      return(width);
+    }
+
+    int16_t drawString(const char *s, int32_t x, int32_t y)
+    {
+      if(!nested && drawTracking())
+        recordText(s, x, y, 0xFF, textWidth(s), fontHeight());
+
+      nested++;
+      int16_t width = TFT_eSprite::drawString(s, x, y);
+      nested--;
+      return(width);
+    }
+
+    int16_t drawNumber(long n, int32_t x, int32_t y, uint8_t font);
+    int16_t drawNumber(long n, int32_t x, int32_t y);
+
+  private:
+    uint8_t nested = 0;              // Calls made by the library itself
+    uint8_t textDatum = TL_DATUM;    // Text style, as last set
+    uint8_t textFont = 1;
+    bool textFill = false;
+    uint16_t textFg = 0xFFFF;
+    uint16_t textBg = 0x0000;
+    const GFXfont *textFreeFont = 0;
+
+    void record(const int32_t *args, uint8_t count, int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+    {
+      if(!nested) drawRecord(args, count, x0, y0, x1, y1);
+    }
+
+    // Text is placed around (x, y) according to the datum, glyphs
+    // may spill a little outside the text width and font height
+    void recordText(const char *s, int32_t x, int32_t y, uint8_t font, int32_t w, int32_t h)
+    {
+      int32_t a[] = { SPRITE_TEXT, x, y, font, textDatum, textFont, textFill, textFg, textBg, (int32_t)(intptr_t)textFreeFont };
+      uint8_t col = textDatum < 9? textDatum % 3 : textDatum - 9;
+      int32_t x0 = x - col * w / 2;
+      int32_t y0 = textDatum < 9? y - textDatum / 3 * h / 2 : y - h;
+      int32_t y1 = textDatum < 9? y0 + h : y + h;
+      drawRecord(a, 10, x0 - 2, y0 - 2, x0 + w + 2, y1 + 2, s);
+    }
+};
+
+#endif // SPRITE_H
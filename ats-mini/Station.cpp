@@ -3,6 +3,7 @@
 #include "Utils.h"
 #include "Menu.h"
 #include "EIBI.h"
+#include "Radio.h"
 
 // CB frequency range
 #define MIN_CB_FREQUENCY 26060
@@ -225,18 +226,31 @@ static bool showRdsTime(const char *rdsTime)
 
 bool checkRds()
 {
+  static uint32_t lastGroups = 0;
+  static uint32_t lastTimes = 0;
   bool needRedraw = false;
   uint8_t mode = getRDSMode();
+  RadioStatus status;
 
-  rx.getRdsStatus();
+  // Radio task decodes RDS, wait until it has tuned to the current station
+  if(radioBusy()) return(false);
+  radioGetStatus(&status);
 
-  if(rx.getRdsReceived() && rx.getRdsSync() && rx.getRdsSyncFound())
+  if(status.rdsGroups != lastGroups)
   {
-    needRedraw |= (mode & RDS_PS) && showStationName(rx.getRdsStationName());
-    needRedraw |= (mode & RDS_RT) && showRadioText(rx.getRdsVersionCode()? rx.getRdsText2B() : rx.getRdsText2A());
-    needRedraw |= (mode & RDS_PI) && showRdsPiCode(rx.getRdsPI());
-    needRedraw |= (mode & RDS_CT) && showRdsTime(rx.getRdsTime());
-    needRedraw |= (mode & RDS_PT) && showRdsProgramType(rx.getRdsProgramTypeX(), !!(mode & RDS_RBDS));
+    uint8_t fields = status.rdsFields & mode;
+
+    needRedraw |= (fields & RDS_PS) && showStationName(status.rdsPs);
+    needRedraw |= (fields & RDS_RT) && showRadioText(status.rdsRt);
+    needRedraw |= (fields & RDS_PI) && showRdsPiCode(status.rdsPi);
+    needRedraw |= (fields & RDS_PT) && showRdsProgramType(status.rdsPty, !!(mode & RDS_RBDS));
+
+    // Only set the clock once per received time
+    if((fields & RDS_CT) && status.rdsTimes != lastTimes)
+      needRedraw |= showRdsTime(status.rdsCt);
+
+    lastGroups = status.rdsGroups;
+    lastTimes = status.rdsTimes;
   }
 
   // Return TRUE if any RDS information changes
@@ -2,12 +2,31 @@
 #include "Storage.h"
 #include "Themes.h"
 #include "Menu.h"
+#include "Trace.h"
+#include "Disk.h"
 #include <LittleFS.h>
 #include "nvs_flash.h"
+#include "esp_rom_crc.h"
+#include "Journal.h"
+#include "Settings.h"
+#include "Bands.h"
 
 // Time of inactivity to start writing preferences
 #define STORE_TIME    10000
 
+#define PREFS_CHUNK       8   // Items per chunk
+#define PREFS_MAX_CHUNKS 16   // Chunks per section
+#define PREFS_MAX_ITEM   32   // Maximal item size (bytes)
+
+// Settings follow the application version, padded to an even size
+#define SETTINGS_SIZE(n) ((sizeof(uint16_t) + (n) + 1) & ~1)
+
+#define SECTION_SETTINGS 0
+#define SECTION_BANDS    1
+#define SECTION_MEMORIES 2
+#define SECTION_BAND_STORE 3
+#define SECTION_COUNT    4
+
 // Preferences saved here
 Preferences prefs;
 
@@ -15,6 +34,10 @@ static uint32_t itIsTimeToSave = 0;       // Preferences to save, or 0 for none
 static bool savingPrefsFlag    = false;   // TRUE: Saving preferences
 static uint32_t storeTime      = millis();
 
+// CRC of each preferences chunk as stored in NVS
+static uint32_t storedCrc[SECTION_COUNT][PREFS_MAX_CHUNKS];
+static bool storedValid[SECTION_COUNT][PREFS_MAX_CHUNKS];
+
 // To store any change to preferences, we need at least STORE_TIME
 // milliseconds of inactivity.
 void prefsRequestSave(uint32_t what, bool now)
@@ -47,7 +70,7 @@ bool prefsAreWritten()
 void prefsInvalidate()
 {
   static const char *sections[] =
-  { "settings", "memories", "bands", "network", 0 };
+  { "settings", "memories", "bands", "bandstore", "network", 0 };
 
   // Clear all applicable sections
   for(int j = 0 ; sections[j] ; ++j)
@@ -56,8 +79,14 @@ void prefsInvalidate()
     prefs.clear();
     prefs.end();
   }
+
+  // Nothing is stored now
+  journalClear();
+  bandsClear();
+  memset(storedValid, 0, sizeof(storedValid));
 }
 
+// Bands as saved by older firmware, now they are in the band store
 struct SavedBand
 {
   uint8_t bandMode;       // Band mode (FM, AM, LSB, or USB)
@@ -68,38 +97,139 @@ struct SavedBand
   int16_t lsbCal;         // LSB calibration value
 };
 
-void prefsSaveBand(uint8_t idx, bool openPrefs)
+//
+// Each section is saved as a few NVS entries (chunks), each holding a
+// header followed by up to PREFS_CHUNK items. A chunk is only written
+// when its contents differ from what has last been saved or loaded, so
+// changing the volume rewrites one small settings entry, and editing a
+// memory slot rewrites one chunk of memories.
+//
+struct BlobHeader
 {
-  SavedBand value;
-  char name[32];
+  uint8_t version;        // Section version (VER_SETTINGS, VER_BANDS, ...)
+  uint8_t count;          // Number of items
+  uint16_t size;          // Item size
+  uint32_t crc;           // CRC32 of the items
+};
 
-  // Will be saving to bands
-  if(openPrefs) prefs.begin("bands", false, STORAGE_PARTITION);
+#define BLOB_OK      0    // Section loaded
+#define BLOB_MISSING 1    // No chunks, section saved by an older firmware
+#define BLOB_INVALID 2    // Chunk damaged or of a different version
 
-  // Compose preference name and value
-  sprintf(name, "Band-%d", idx);
-  value.currentFreq    = bands[idx].currentFreq;     // Frequency
-  value.bandMode       = bands[idx].bandMode;        // Modulation
-  value.currentStepIdx = bands[idx].currentStepIdx;  // Step
-  value.bandwidthIdx   = bands[idx].bandwidthIdx;    // Bandwidth
-  value.usbCal         = bands[idx].usbCal;          // USB Calibration
-  value.lsbCal         = bands[idx].lsbCal;          // LSB Calibration
-
-  // Write a preference
-  prefs.putBytes(name, &value, sizeof(value));
-
-  // Done with band preferences
-  if(openPrefs) prefs.end();
+static const char *sectionNames[SECTION_COUNT] = { "settings", "bands", "memories", "bandstore" };
+
+static PrefsStats stats;
+
+static_assert(SETTINGS_SIZE(SETTINGS_MAX_SIZE) <= PREFS_MAX_ITEM, "Settings do not fit into a chunk");
+static_assert(sizeof(Memory) <= PREFS_MAX_ITEM, "Memory does not fit into a chunk");
+static_assert(sizeof(BandRecord) <= PREFS_MAX_ITEM, "Band record does not fit into a chunk");
+static_assert(BANDS_MAX <= PREFS_CHUNK * PREFS_MAX_CHUNKS, "Band records do not fit into a section");
+static_assert(SECTION_COUNT <= JOURNAL_SECTIONS, "Sections do not fit into the journal");
+
+//
+// Save changed chunks of a section, returns the number of chunks written
+//
+static int sectionSave(uint8_t section, uint8_t version, const void *items, uint16_t count, uint16_t size)
+{
+  uint8_t buf[sizeof(BlobHeader) + PREFS_CHUNK * PREFS_MAX_ITEM];
+  BlobHeader *header = (BlobHeader *)buf;
+  bool opened = false;
+  int written = 0;
+
+  if(size > PREFS_MAX_ITEM) return(0);
+
+  for(uint8_t i = 0 ; i < PREFS_MAX_CHUNKS && i * PREFS_CHUNK < count ; i++)
+  {
+    const uint8_t *data = (const uint8_t *)items + i * PREFS_CHUNK * size;
+    uint8_t n = min(count - i * PREFS_CHUNK, PREFS_CHUNK);
+    uint32_t crc = esp_rom_crc32_le(0, data, n * size);
+
+    // Skip chunks that have not changed
+    if(storedValid[section][i] && storedCrc[section][i] == crc) continue;
+
+    // Without the journal, write directly to NVS
+    if(!opened && !journalAvailable())
+    {
+      prefs.begin(sectionNames[section], false, STORAGE_PARTITION);
+      // Drop per-key entries left by older firmware
+      if(prefs.isKey("Version")) prefs.clear();
+      opened = true;
+    }
+
+    char name[16];
+    size_t length = sizeof(BlobHeader) + n * size;
+    sprintf(name, "Blob-%d", i);
+    header->version = version;
+    header->count   = n;
+    header->size    = size;
+    header->crc     = crc;
+    memcpy(buf + sizeof(BlobHeader), data, n * size);
+
+    storedValid[section][i] = journalAvailable()?
+      journalWrite(section, i, buf, length) : prefs.putBytes(name, buf, length) == length;
+    storedCrc[section][i] = crc;
+    written++;
+  }
+
+  if(opened) prefs.end();
+  stats.chunks += written;
+  return(written);
+}
+
+//
+// Load all chunks of a section, from the journal if there, or from NVS
+//
+static uint8_t sectionLoad(uint8_t section, uint8_t version, void *items, uint16_t count, uint16_t size)
+{
+  uint8_t buf[sizeof(BlobHeader) + PREFS_CHUNK * PREFS_MAX_ITEM];
+  const BlobHeader *header = (const BlobHeader *)buf;
+  uint8_t result = BLOB_OK;
+
+  if(size > PREFS_MAX_ITEM) return(BLOB_INVALID);
+
+  prefs.begin(sectionNames[section], true, STORAGE_PARTITION);
+
+  for(uint8_t i = 0 ; i < PREFS_MAX_CHUNKS && i * PREFS_CHUNK < count && result == BLOB_OK ; i++)
+  {
+    uint8_t *data = (uint8_t *)items + i * PREFS_CHUNK * size;
+    uint8_t n = min(count - i * PREFS_CHUNK, PREFS_CHUNK);
+    size_t length = sizeof(BlobHeader) + n * size;
+    char name[16];
+
+    sprintf(name, "Blob-%d", i);
+    storedValid[section][i] = false;
+
+    size_t got = journalRead(section, i, buf, sizeof(buf));
+    bool inJournal = got > 0;
+    if(!got && prefs.isKey(name)) got = prefs.getBytes(name, buf, sizeof(buf));
+
+    if(!got)
+      result = i? BLOB_INVALID : BLOB_MISSING;
+    else if(got != length || header->version != version || header->count != n || header->size != size ||
+            header->crc != esp_rom_crc32_le(0, buf + sizeof(BlobHeader), n * size))
+      result = BLOB_INVALID;
+    else
+    {
+      memcpy(data, buf + sizeof(BlobHeader), n * size);
+      storedCrc[section][i] = header->crc;
+      // Chunks still in NVS move to the journal on the next save
+      storedValid[section][i] = inJournal || !journalAvailable();
+    }
+  }
+
+  prefs.end();
+  return(result);
 }
 
-bool prefsLoadBand(uint8_t idx, bool openPrefs)
+//
+// Per-key loaders, for preferences saved by older firmware
+//
+
+static bool prefsLoadBand(uint8_t idx)
 {
   SavedBand value;
   char name[32];
 
-  // Will be loading from bands
-  if(openPrefs) prefs.begin("bands", true, STORAGE_PARTITION);
-
   // Compose preference name
   sprintf(name, "Band-%d", idx);
 
@@ -115,122 +245,22 @@ bool prefsLoadBand(uint8_t idx, bool openPrefs)
     bands[idx].lsbCal         = value.lsbCal;         // LSB Calibration
   }
 
-  // Done with band preferences
-  if(openPrefs) prefs.end();
-
   // Done
   return(result);
 }
 
-void prefsSaveMemory(uint8_t idx, bool openPrefs)
-{
-  char name[32];
-
-  // Will be saving to memories
-  if(openPrefs) prefs.begin("memories", false, STORAGE_PARTITION);
-
-  // Compose preference name
-  sprintf(name, "Memory-%d", idx);
-
-  // Write a preference
-  prefs.putBytes(name, &memories[idx], sizeof(memories[idx]));
-
-  // Done with memory preferences
-  if(openPrefs) prefs.end();
-}
-
-bool prefsLoadMemory(uint8_t idx, bool openPrefs)
+static bool prefsLoadMemory(uint8_t idx)
 {
   char name[32];
 
-  // Will be loading from memories
-  if(openPrefs) prefs.begin("memories", true, STORAGE_PARTITION);
-
   // Compose preference name
   sprintf(name, "Memory-%d", idx);
 
-  // Write a preference
-  bool result = !!prefs.getBytes(name, &memories[idx], sizeof(memories[idx]));
-
-  // Done with memory preferences
-  if(openPrefs) prefs.end();
-
-  // Done
-  return(result);
-}
-
-void prefsSave(uint32_t items)
-{
-  if(items & SAVE_SETTINGS)
-  {
-    // Will be saving to settings
-    prefs.begin("settings", false, STORAGE_PARTITION);
-
-    // Save main global settings
-    prefs.putUChar("Version",  VER_SETTINGS);      // Settings version
-    prefs.putUShort("App",     VER_APP);           // Application version
-    prefs.putUChar("Volume",   volume);            // Current volume
-    prefs.putUChar("Band",     bandIdx);           // Current band
-    prefs.putUChar("WiFiMode", wifiModeIdx);       // WiFi connection mode
-
-    // Save additional global settings
-    prefs.putUShort("Brightness", currentBrt);     // Brightness
-    prefs.putUChar("FmAGC",       FmAgcIdx);       // FM AGC/ATTN
-    prefs.putUChar("AmAGC",       AmAgcIdx);       // AM AGC/ATTN
-    prefs.putUChar("SsbAGC",      SsbAgcIdx);      // SSB AGC/ATTN
-    prefs.putUChar("AmAVC",       AmAvcIdx);       // AM AVC
-    prefs.putUChar("SsbAVC",      SsbAvcIdx);      // SSB AVC
-    prefs.putUChar("AmSoftMute",  AmSoftMuteIdx);  // AM soft mute
-    prefs.putUChar("SsbSoftMute", SsbSoftMuteIdx); // SSB soft mute
-    prefs.putUShort("Sleep",      currentSleep);   // Sleep delay
-    prefs.putUChar("Theme",       themeIdx);       // Color theme
-    prefs.putUChar("RDSMode",     rdsModeIdx);     // RDS mode
-    prefs.putUChar("SleepMode",   sleepModeIdx);   // Sleep mode
-    prefs.putUChar("ZoomMenu",    zoomMenu);       // TRUE: Zoom menu
-    prefs.putBool("ScrollDir", scrollDirection<0); // TRUE: Reverse scroll
-    prefs.putUChar("UTCOffset",   utcOffsetIdx);   // UTC Offset
-    prefs.putUChar("Squelch",     currentSquelch); // Squelch
-    prefs.putUChar("FmRegion",    FmRegionIdx);    // FM region
-    prefs.putUChar("UILayout",    uiLayoutIdx);    // UI Layout
-    prefs.putUChar("BLEMode",     bleModeIdx);     // Bluetooth mode
-    prefs.putUChar("USBMode",     usbModeIdx);     // USB mode
-
-    // Done with global settings
-    prefs.end();
-  }
-
-  if(items & SAVE_BANDS)
-  {
-    // Will be saving to bands
-    prefs.begin("bands", false, STORAGE_PARTITION);
-    prefs.putUChar("Version", VER_BANDS);
-    // Save band settings
-    for(int i=0 ; i<getTotalBands() ; i++) prefsSaveBand(i, false);
-    // Done with bands
-    prefs.end();
-  }
-  else if(items & SAVE_CUR_BAND)
-  {
-    // Save current band only
-    prefsSaveBand(bandIdx);
-  }
-
-  if(items & SAVE_MEMORIES)
-  {
-    // Will be saving to memories
-    prefs.begin("memories", false, STORAGE_PARTITION);
-    prefs.putUChar("Version", VER_MEMORIES);
-    // Save current memories
-    for(int i=0 ; i<getTotalMemories() ; i++) prefsSaveMemory(i, false);
-    // Done with memories
-    prefs.end();
-  }
-
-  // Preferences have been saved
-  savingPrefsFlag = true;
+  // Read preference
+  return(!!prefs.getBytes(name, &memories[idx], sizeof(memories[idx])));
 }
 
-bool prefsLoad(uint32_t items)
+static bool prefsLoadLegacy(uint32_t items)
 {
   if(items & SAVE_SETTINGS)
   {
@@ -244,36 +274,27 @@ bool prefsLoad(uint32_t items)
       return(false);
     }
 
-    // Load main global settings
-    volume         = prefs.getUChar("Volume", volume);          // Current volume
-    bandIdx        = prefs.getUChar("Band", bandIdx);           // Current band
-    wifiModeIdx    = prefs.getUChar("WiFiMode", wifiModeIdx);   // WiFi connection mode
-    currentBrt     = prefs.getUShort("Brightness", currentBrt); // Brightness
-    FmAgcIdx       = prefs.getUChar("FmAGC", FmAgcIdx);         // FM AGC/ATTN
-    AmAgcIdx       = prefs.getUChar("AmAGC", AmAgcIdx);         // AM AGC/ATTN
-    SsbAgcIdx      = prefs.getUChar("SsbAGC", SsbAgcIdx);       // SSB AGC/ATTN
-    AmAvcIdx       = prefs.getUChar("AmAVC", AmAvcIdx);         // AM AVC
-    SsbAvcIdx      = prefs.getUChar("SsbAVC", SsbAvcIdx);       // SSB AVC
-    AmSoftMuteIdx  = prefs.getUChar("AmSoftMute", AmSoftMuteIdx);   // AM soft mute
-    SsbSoftMuteIdx = prefs.getUChar("SsbSoftMute", SsbSoftMuteIdx); // SSB soft mute
-    currentSleep   = prefs.getUShort("Sleep", currentSleep);    // Sleep delay
-    themeIdx       = prefs.getUChar("Theme", themeIdx);         // Color theme
-    rdsModeIdx     = prefs.getUChar("RDSMode", rdsModeIdx);     // RDS mode
-    sleepModeIdx   = prefs.getUChar("SleepMode", sleepModeIdx); // Sleep mode
-    zoomMenu       = prefs.getUChar("ZoomMenu", zoomMenu);      // TRUE: Zoom menu
-    scrollDirection = prefs.getBool("ScrollDir", scrollDirection<0)? -1:1; // TRUE: Reverse scroll
-    utcOffsetIdx   = prefs.getUChar("UTCOffset", utcOffsetIdx); // UTC Offset
-    currentSquelch = prefs.getUChar("Squelch", currentSquelch); // Squelch
-    FmRegionIdx    = prefs.getUChar("FmRegion", FmRegionIdx);   // FM region
-    uiLayoutIdx    = prefs.getUChar("UILayout", uiLayoutIdx);   // UI Layout
-    bleModeIdx     = prefs.getUChar("BLEMode", bleModeIdx);     // Bluetooth mode
-    usbModeIdx     = prefs.getUChar("USBMode", usbModeIdx);     // USB mode
+    // Load main global settings, each one from its own key
+    for(uint8_t i = 0 ; i < settingsCount() ; i++)
+    {
+      const Setting *setting = settingsGet(i);
+      int32_t value = settingRead(setting);
+
+      if(setting->type == SET_U16)
+        value = prefs.getUShort(setting->key, value);
+      else if(setting->type == SET_DIR)
+        value = prefs.getBool(setting->key, value);
+      else
+        value = prefs.getUChar(setting->key, value);
+
+      settingWrite(setting, value);
+    }
 
     // Done with global settings
     prefs.end();
   }
 
-  if(items & SAVE_BANDS)
+  if(items & (SAVE_BANDS|SAVE_CUR_BAND))
   {
     // Will be loading from bands
     prefs.begin("bands", true, STORAGE_PARTITION);
@@ -286,16 +307,14 @@ bool prefsLoad(uint32_t items)
     }
 
     // Read band settings
-    for(int i=0 ; i<getTotalBands() ; i++) prefsLoadBand(i, false);
+    if(items & SAVE_BANDS)
+      for(int i=0 ; i<getTotalBands() ; i++) prefsLoadBand(i);
+    else
+      prefsLoadBand(bandIdx);
 
     // Done with bands
     prefs.end();
   }
-  else if(items & SAVE_CUR_BAND)
-  {
-    // Load current band only
-    prefsLoadBand(bandIdx);
-  }
 
   if(items & SAVE_MEMORIES)
   {
@@ -310,7 +329,7 @@ bool prefsLoad(uint32_t items)
     }
 
     // Read all memories
-    for(int i=0 ; i<getTotalMemories() ; i++) prefsLoadMemory(i, false);
+    for(int i=0 ; i<getTotalMemories() ; i++) prefsLoadMemory(i);
 
     // Done with memories
     prefs.end();
@@ -319,8 +338,141 @@ bool prefsLoad(uint32_t items)
   return(true);
 }
 
+//
+// Write changed preferences, returns the number of chunks written
+//
+static int prefsWrite(uint32_t items)
+{
+  int written = 0;
+
+  if(items & SAVE_SETTINGS)
+  {
+    uint8_t value[SETTINGS_SIZE(SETTINGS_MAX_SIZE)];
+    size_t size = SETTINGS_SIZE(settingsSize());
+
+    // Save global settings, clearing padding for a stable CRC
+    memset(value, 0, sizeof(value));
+    value[0] = VER_APP & 0xFF;
+    value[1] = VER_APP >> 8;
+    settingsPack(value + sizeof(uint16_t));
+
+    written += sectionSave(SECTION_SETTINGS, VER_SETTINGS, value, 1, size);
+  }
+
+  // Only chunks holding changed bands get written anyway
+  if(items & (SAVE_BANDS|SAVE_CUR_BAND))
+  {
+    BandRecord records[BANDS_MAX];
+    bandsPack(records);
+    written += sectionSave(SECTION_BAND_STORE, BANDS_VERSION, records, BANDS_MAX, sizeof(BandRecord));
+  }
+
+  if(items & SAVE_MEMORIES)
+    written += sectionSave(SECTION_MEMORIES, VER_MEMORIES, memories, getTotalMemories(), sizeof(Memory));
+
+  return(written);
+}
+
+void prefsSave(uint32_t items)
+{
+  TRACE_SCOPE(TRACE_PREFS, items);
+  uint32_t start = micros();
+  int written = prefsWrite(items);
+
+  // If the journal has dropped the save, write all of it again, to NVS
+  // if the journal is off now
+  if(written && journalAvailable() && !journalCommit())
+  {
+    memset(storedValid, 0, sizeof(storedValid));
+    written = prefsWrite(items | SAVE_SETTINGS | SAVE_BANDS | SAVE_MEMORIES);
+    if(written && journalAvailable() && !journalCommit())
+      memset(storedValid, 0, sizeof(storedValid));
+  }
+
+  // Preferences have been saved, if anything changed
+  if(written)
+  {
+    savingPrefsFlag = true;
+    stats.saveTime = micros() - start;
+    stats.saves++;
+  }
+}
+
+bool prefsLoad(uint32_t items)
+{
+  uint32_t start = micros();
+  uint32_t legacy = items & SAVE_VERIFY;
+  uint8_t result;
+
+  if(items & SAVE_SETTINGS)
+  {
+    uint8_t value[SETTINGS_SIZE(SETTINGS_MAX_SIZE)];
+    result = sectionLoad(SECTION_SETTINGS, VER_SETTINGS, value, 1, SETTINGS_SIZE(settingsSize()));
+
+    // All settings at once, skipping the application version
+    if(result == BLOB_OK) settingsUnpack(value + sizeof(uint16_t));
+    else if(result == BLOB_MISSING) legacy |= SAVE_SETTINGS;
+    else if(items & SAVE_VERIFY) return(false);
+  }
+
+  // Bands come from the band store section, or from the stores of older
+  // firmware, until bands get saved
+  if(items & (SAVE_BANDS|SAVE_CUR_BAND))
+  {
+    BandRecord records[BANDS_MAX];
+    result = sectionLoad(SECTION_BAND_STORE, BANDS_VERSION, records, BANDS_MAX, sizeof(BandRecord));
+
+    if(result == BLOB_OK) bandsUnpack(records, BANDS_MAX, items & SAVE_BANDS);
+    else if(result != BLOB_MISSING && (items & SAVE_VERIFY)) return(false);
+  }
+
+  if((items & (SAVE_BANDS|SAVE_CUR_BAND)) && result != BLOB_OK && !bandsLoadFile(items & SAVE_BANDS))
+  {
+    SavedBand value[getTotalBands()];
+    result = sectionLoad(SECTION_BANDS, VER_BANDS, value, getTotalBands(), sizeof(SavedBand));
+
+    if(result == BLOB_OK)
+    {
+      for(int i=0 ; i<getTotalBands() ; i++)
+      {
+        if(!(items & SAVE_BANDS) && i!=bandIdx) continue;
+        bands[i].currentFreq    = value[i].currentFreq;    // Frequency
+        bands[i].bandMode       = value[i].bandMode;       // Modulation
+        bands[i].currentStepIdx = value[i].currentStepIdx; // Step
+        bands[i].bandwidthIdx   = value[i].bandwidthIdx;   // Bandwidth
+        bands[i].usbCal         = value[i].usbCal;         // USB Calibration
+        bands[i].lsbCal         = value[i].lsbCal;         // LSB Calibration
+      }
+    }
+    else if(result == BLOB_MISSING) legacy |= items & (SAVE_BANDS|SAVE_CUR_BAND);
+    else if(items & SAVE_VERIFY) return(false);
+  }
+
+  if(items & SAVE_MEMORIES)
+  {
+    result = sectionLoad(SECTION_MEMORIES, VER_MEMORIES, memories, getTotalMemories(), sizeof(Memory));
+
+    if(result == BLOB_MISSING) legacy |= SAVE_MEMORIES;
+    else if(result != BLOB_OK && (items & SAVE_VERIFY)) return(false);
+  }
+
+  // Sections without chunks may have been saved by older firmware
+  if((legacy & ~SAVE_VERIFY) && !prefsLoadLegacy(legacy)) return(false);
+
+  stats.loadTime = micros() - start;
+  return(true);
+}
+
+const PrefsStats *prefsGetStats()
+{
+  return(&stats);
+}
+
 bool diskInit(bool force)
 {
+  // Cached file handles and metadata do not survive a remount
+  diskInvalidate();
+
   if(force)
   {
     LittleFS.end();
@@ -349,11 +501,15 @@ bool diskInit(bool force)
   }
 
   // Serial.println("Mounted LittleFS!");
+
+  // Settings journal lives on LittleFS
+  journalInit();
   return(true);
 }
 
 bool nvsErase()
 {
+  memset(storedValid, 0, sizeof(storedValid));
   return(nvs_flash_erase() == ESP_OK &&
          nvs_flash_init() == ESP_OK &&
          nvs_flash_erase_partition(STORAGE_PARTITION) == ESP_OK &&
@@ -12,6 +12,14 @@
 #define SAVE_VERIFY   0x80
 #define SAVE_ALL      (SAVE_SETTINGS|SAVE_BANDS|SAVE_MEMORIES|SAVE_VERIFY)
 
+typedef struct
+{
+  uint32_t saveTime;  // Last save time (us)
+  uint32_t loadTime;  // Last load time (us)
+  uint32_t saves;     // Number of saves that wrote anything
+  uint32_t chunks;    // Number of chunks written
+} PrefsStats;
+
 extern Preferences prefs;
 
 void prefsTickTime();
@@ -24,9 +32,6 @@ bool diskInit(bool force = false);
 void prefsRequestSave(uint32_t what, bool now = false);
 void prefsSave(uint32_t items = SAVE_ALL);
 bool prefsLoad(uint32_t items = SAVE_ALL);
-void prefsSaveBand(uint8_t idx, bool openPrefs = true);
-bool prefsLoadBand(uint8_t idx, bool openPrefs = true);
-void prefsSaveMemory(uint8_t idx, bool openPrefs = true);
-bool prefsLoadMemory(uint8_t idx, bool openPrefs = true);
+const PrefsStats *prefsGetStats();
 
 #endif // STORAGE_H
@@ -437,7 +437,7 @@ ColorTheme theme[] =
   },
 };
 
-uint8_t themeIdx = 0;
+uint8_t themeIdx;
 int getTotalThemes() { return(ITEM_COUNT(theme)); }
 
 //
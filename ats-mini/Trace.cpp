@@ -0,0 +1,76 @@
+#include "Common.h"
+#include "Trace.h"
+
+//
+// Event trace. Traced functions record begin and end events into a RAM
+// ring buffer, the 'X' remote command prints them out and tools/trace.py
+// converts them to a Chrome / Perfetto trace. Only built with the TRACE
+// option, otherwise the trace macros compile to nothing.
+//
+
+#ifdef TRACE
+
+static const char *traceNames[TRACE_IDS] =
+{
+  "drawScreen", "setFrequency", "selectBand", "setBand",
+  "loadSSB", "prefsSave", "eibiLookup", "remote"
+};
+
+static TraceEvent events[TRACE_EVENTS];
+
+// Number of events recorded so far, both cores add events
+static uint32_t traceHead = 0;
+
+// Events are not recorded while dumping them
+static volatile bool tracePaused = false;
+
+void traceEvent(uint8_t type, uint8_t id, int32_t arg)
+{
+  if(tracePaused) return;
+
+  uint32_t idx = __atomic_fetch_add(&traceHead, 1, __ATOMIC_RELAXED);
+  TraceEvent *event = &events[idx & (TRACE_EVENTS - 1)];
+
+  event->time = micros();
+  event->arg  = arg;
+  event->type = type;
+  event->id   = id;
+  event->core = xPortGetCoreID();
+}
+
+//
+// Print recorded events, oldest first, as "time,core,type,name,arg"
+// lines between "TRACE count" and "END" lines, then clear them
+//
+void traceDump(Stream *stream)
+{
+  tracePaused = true;
+
+  uint32_t head = __atomic_load_n(&traceHead, __ATOMIC_RELAXED);
+  uint32_t count = min(head, (uint32_t)TRACE_EVENTS);
+
+  stream->printf("TRACE %lu\r\n", count);
+
+  for(uint32_t i = head - count ; i != head ; i++)
+  {
+    const TraceEvent *event = &events[i & (TRACE_EVENTS - 1)];
+    stream->printf("%lu,%u,%c,%s,%ld\r\n", event->time, event->core, event->type,
+                   event->id < TRACE_IDS? traceNames[event->id] : "?", event->arg);
+  }
+
+  stream->print("END\r\n");
+
+  traceHead = 0;
+  tracePaused = false;
+}
+
+#else
+
+void traceEvent(uint8_t, uint8_t, int32_t) {}
+
+void traceDump(Stream *stream)
+{
+  stream->print("Tracing disabled, rebuild with TRACE=1\r\n");
+}
+
+#endif // TRACE
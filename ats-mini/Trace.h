@@ -0,0 +1,61 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+class Stream;
+
+#define TRACE_EVENTS 1024 // Number of events kept, power of 2
+
+// Event types, same letters as the Chrome trace format phases
+#define TRACE_BEGIN   'B'
+#define TRACE_END     'E'
+#define TRACE_INSTANT 'i'
+
+// Traced functions
+#define TRACE_DRAW     0 // drawScreen()
+#define TRACE_TUNE     1 // rx.setFrequency(), arg = frequency
+#define TRACE_BAND     2 // selectBand(), arg = band index
+#define TRACE_SET_BAND 3 // Receiver band setup, arg = frequency
+#define TRACE_SSB      4 // SSB patch load, arg = bandwidth
+#define TRACE_PREFS    5 // prefsSave(), arg = SAVE_* items
+#define TRACE_EIBI     6 // EiBi schedule lookup, arg = frequency
+#define TRACE_REMOTE   7 // Remote command, arg = command key
+#define TRACE_IDS      8
+
+typedef struct
+{
+  uint32_t time;  // Time (us)
+  int32_t  arg;   // Event argument
+  uint8_t  type;  // TRACE_BEGIN, TRACE_END, TRACE_INSTANT
+  uint8_t  id;    // TRACE_DRAW, TRACE_TUNE, ...
+  uint8_t  core;  // CPU core the event happened on
+} TraceEvent;
+
+void traceEvent(uint8_t type, uint8_t id, int32_t arg = 0);
+void traceDump(Stream *stream);
+
+#ifdef TRACE
+
+// Traces the rest of the enclosing scope
+class TraceScope
+{
+  public:
+    TraceScope(uint8_t id, int32_t arg) : id(id) { traceEvent(TRACE_BEGIN, id, arg); }
+    ~TraceScope() { traceEvent(TRACE_END, id); }
+
+  private:
+    uint8_t id;
+};
+
+#define TRACE_SCOPE(id, arg) TraceScope traceScope((id), (arg))
+#define TRACE_MARK(id, arg)  traceEvent(TRACE_INSTANT, (id), (arg))
+
+#else
+
+#define TRACE_SCOPE(id, arg)
+#define TRACE_MARK(id, arg)
+
+#endif // TRACE
+
+#endif // TRACE_H
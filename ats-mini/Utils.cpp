@@ -5,6 +5,9 @@
 #include "Utils.h"
 #include "Menu.h"
 #include "Draw.h"
+#include "Format.h"
+#include "Radio.h"
+#include "Trace.h"
 
 // SSB patch for whole SSBRX initialization string
 #include "patch_init.h"
@@ -75,7 +78,11 @@ void loadSSB(uint8_t bandwidth, bool draw)
   if(!ssbLoaded)
   {
     if(draw) drawMessage("Loading SSB");
-    rx.loadPatch(ssb_patch_content, sizeof(ssb_patch_content), bandwidth);
+    // Band setup posted after this waits for the patch on the radio task
+    radioPost([](int32_t bandwidth, int32_t) {
+      TRACE_SCOPE(TRACE_SSB, bandwidth);
+      rx.loadPatch(ssb_patch_content, sizeof(ssb_patch_content), bandwidth);
+    }, bandwidth);
     ssbLoaded = true;
   }
 }
@@ -161,14 +168,14 @@ bool muteOn(uint8_t mode, int x)
     // Activate the mute circuit
     digitalWrite(AUDIO_MUTE, HIGH);
     delay(50);
-    rx.setAudioMute(true);
+    radioPost([](int32_t, int32_t) { rx.setAudioMute(true); });
   }
 
   if(unmute) {
     // Deactivate the mute circuit
     digitalWrite(AUDIO_MUTE, LOW);
     delay(50);
-    rx.setAudioMute(false);
+    radioPost([](int32_t, int32_t) { rx.setAudioMute(false); });
     // Enable audio amplifier to restore speaker output
     digitalWrite(PIN_AMP_EN, HIGH);
   }
@@ -205,8 +212,8 @@ bool sleepOn(int x)
 
     if(sleepModeIdx == SLEEP_LIGHT)
     {
-      // Disable WiFi
-      netStop();
+      // Disable WiFi, unless the boot task is still bringing it up
+      if(bootIsDone()) netStop();
 
       // Unmute squelch
       if(muteOn(MUTE_SQUELCH) && !muteOn(MUTE_MAIN)) muteOn(MUTE_FORCE, false);
@@ -243,7 +250,7 @@ bool sleepOn(int x)
       if(muteOn(MUTE_SQUELCH) && !muteOn(MUTE_MAIN)) muteOn(MUTE_FORCE, true);
       sleepOn(false);
       // Enable WiFi
-      netInit(wifiModeIdx, false);
+      if(bootIsDone()) netInit(wifiModeIdx, false);
     }
   }
   else if((x==0) && sleep_on)
@@ -303,7 +310,7 @@ static void formatClock(uint8_t hours, uint8_t minutes)
 {
   int t = (int)hours * 60 + minutes + getCurrentUTCOffset() * 15;
   t = t < 0? t + 24*60 : t;
-  sprintf(clockText, "%02d:%02d", (t / 60) % 24, t % 60);
+  fmtUInt(fmtStr(fmtUInt(clockText, (t / 60) % 24, 2), ":"), t % 60, 2);
 }
 
 void clockRefreshTime()
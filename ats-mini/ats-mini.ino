@@ -14,18 +14,25 @@
 #include "EIBI.h"
 #include "Remote.h"
 #include "Ble.h"
+#include "Scheduler.h"
+#include "Radio.h"
+#include "Input.h"
+#include "Profile.h"
+#include "Trace.h"
+#include "Cpu.h"
+#include "Bank.h"
+#include "Bands.h"
+#include "Arena.h"
+#include "Heap.h"
+#include "Settings.h"
+#include <atomic>
 
 // SI473/5 and UI
-#define MIN_ELAPSED_TIME         5  // 300
-#define MIN_ELAPSED_RSSI_TIME  200  // RSSI check uses IN_ELAPSED_RSSI_TIME * 6 = 1.2s
 #define ELAPSED_COMMAND      10000  // time to turn off the last command controlled by encoder. Time to goes back to the VFO control // G8PTN: Increased time and corrected comment
-#define DEFAULT_VOLUME          35  // change it for your favorite sound volume
-#define DEFAULT_SLEEP            0  // Default sleep interval, range = 0 (off) to 255 in steps of 5
-#define RDS_CHECK_TIME         250  // Increased from 90
-#define SEEK_TIMEOUT        600000  // Max seek timeout (ms)
-#define NTP_CHECK_TIME       60000  // NTP time refresh period (ms)
-#define SCHEDULE_CHECK_TIME   2000  // How often to identify the same frequency (ms)
-#define BACKGROUND_REFRESH_TIME 5000    // Background screen refresh time. Covers the situation where there are no other events causing a refresh
+#define ENCODER_EVENTS          64  // Encoder events buffered until the main loop runs, power of 2
+#define RADIO_POWER_TIME       100  // SI4732 power up time (ms)
+#define BOOT_STACK_SIZE       8192  // Boot task stack size (bytes)
+#define BOOT_CORE                0  // Boot task core, main loop runs on core 1
 
 // =================================
 // CONSTANTS AND VARIABLES
@@ -36,48 +43,66 @@ uint8_t disableAgc = 0;
 int8_t agcNdx = 0;
 int8_t softMuteMaxAttIdx = 4;
 
-bool seekStop = false;        // G8PTN: Added flag to abort seeking on rotary encoder detection
 bool pushAndRotate = false;   // Push and rotate is active, ignore the long press
 
-long elapsedRSSI = millis();
 long elapsedButton = millis();
 
-long lastStrengthCheck = millis();
-long lastRDSCheck = millis();
-long lastNTPCheck = millis();
-long lastScheduleCheck = millis();
-
 long elapsedCommand = millis();
-volatile int16_t encoderCount = 0;
-volatile int16_t encoderCountAccel = 0;
+
+// Encoder detents with their times, filled by rotaryEncoder() and
+// drained by postEncoderEvents(). Both run on the same core, the
+// interrupt only moves the head and the main loop only moves the tail,
+// so compiler barriers are enough and no locking is needed.
+static struct
+{
+  uint32_t time;
+  int8_t dir;
+} encoderEvents[ENCODER_EVENTS];
+static volatile uint32_t encoderHead = 0;
+static volatile uint32_t encoderTail = 0;
 uint16_t currentFrequency;
 
+//
+// Saved settings, their defaults are set from the settings table by
+// settingsDefaults(), see Settings.cpp
+//
+
 // AGC/ATTN index per mode (FM/AM/SSB)
-int8_t FmAgcIdx = 0;                    // Default FM  AGGON  : Range = 0 to 37, 0 = AGCON, 1 - 27 = ATTN 0 to 26
-int8_t AmAgcIdx = 0;                    // Default AM  AGCON  : Range = 0 to 37, 0 = AGCON, 1 - 37 = ATTN 0 to 36
-int8_t SsbAgcIdx = 0;                   // Default SSB AGCON  : Range = 0 to 1,  0 = AGCON,      1 = ATTN 0
+int8_t FmAgcIdx;                        // FM  : Range = 0 to 37, 0 = AGCON, 1 - 27 = ATTN 0 to 26
+int8_t AmAgcIdx;                        // AM  : Range = 0 to 37, 0 = AGCON, 1 - 37 = ATTN 0 to 36
+int8_t SsbAgcIdx;                       // SSB : Range = 0 to 1,  0 = AGCON,      1 = ATTN 0
 
 // AVC index per mode (AM/SSB)
-int8_t AmAvcIdx = 48;                   // Default AM  = 48 (as per AN332), range = 12 to 90 in steps of 2
-int8_t SsbAvcIdx = 48;                  // Default SSB = 48, range = 12 to 90 in steps of 2
+int8_t AmAvcIdx;                        // AM, range = 12 to 90 in steps of 2
+int8_t SsbAvcIdx;                       // SSB, range = 12 to 90 in steps of 2
 
 // SoftMute index per mode (AM/SSB)
-int8_t AmSoftMuteIdx = 4;               // Default AM  = 4, range = 0 to 32
-int8_t SsbSoftMuteIdx = 4;              // Default SSB = 4, range = 0 to 32
+int8_t AmSoftMuteIdx;                   // AM, range = 0 to 32
+int8_t SsbSoftMuteIdx;                  // SSB, range = 0 to 32
 
 // Menu options
-uint8_t volume = DEFAULT_VOLUME;        // Volume, range = 0 (muted) - 63
-uint8_t currentSquelch = 0;             // Squelch, range = 0 (disabled) - 127
-uint8_t FmRegionIdx = 0;                // FM Region
+uint8_t volume;                         // Volume, range = 0 (muted) - 63
+uint8_t currentSquelch;                 // Squelch, range = 0 (disabled) - 127
+uint8_t FmRegionIdx;                    // FM Region
 
-uint16_t currentBrt = 130;              // Display brightness, range = 10 to 255 in steps of 5
-uint16_t currentSleep = DEFAULT_SLEEP;  // Display sleep timeout, range = 0 to 255 in steps of 5
+uint16_t currentBrt;                    // Display brightness, range = 10 to 255 in steps of 5
+uint16_t currentSleep;                  // Display sleep timeout, range = 0 to 255 in steps of 5
 long elapsedSleep = millis();           // Display sleep timer
-bool zoomMenu = false;                  // Display zoomed menu item
-int8_t scrollDirection = 1;             // Menu scroll direction
-
-// Background screen refresh
-uint32_t background_timer = millis();   // Background screen refresh timer.
+bool zoomMenu;                          // Display zoomed menu item
+int8_t scrollDirection;                 // Menu scroll direction
+
+// Background screen refresh job, restarted by every screen update
+uint8_t backgroundJob;
+// Station lookup job, restarted by every tuning step
+uint8_t identifyJob;
+// Seek progress job, running while seeking
+uint8_t seekJob;
+bool seekActive = false;
+// Band and mode being seeked
+static uint8_t seekBandIdx = 0;
+static uint8_t seekModeIdx = 0;
+// Set by the boot task once Bluetooth and WiFi are up
+static std::atomic<bool> bootDone(false);
 
 //
 // Current parameters
@@ -101,10 +126,39 @@ RemoteState remoteBLEState;
 Rotary encoder  = Rotary(ENCODER_PIN_B, ENCODER_PIN_A);
 ButtonTracker pb1 = ButtonTracker();
 TFT_eSPI tft    = TFT_eSPI();
-TFT_eSprite spr = TFT_eSprite(&tft);
+DrawSprite spr = DrawSprite(&tft);
 SI4735_fixed rx;
 NordicUART BLESerial = NordicUART(RECEIVER_NAME);
 
+//
+// Boot task, brings up everything that is not needed to start playing:
+// the memory bank, Bluetooth and WiFi with its NTP sync. Until it is
+// done, the main loop leaves Bluetooth, WiFi and NTP alone.
+//
+static void bootTaskMain(void *)
+{
+  bankLoad();
+  profMark("bank");
+
+  bleInit(bleModeIdx);
+  profMark("ble");
+
+  netInit(wifiModeIdx, false);
+  profMark("net");
+
+  bootDone = true;
+  vTaskDelete(NULL);
+}
+
+//
+// Returns TRUE once the boot task is done. Until then, Bluetooth and
+// WiFi belong to it and mode changes are deferred.
+//
+bool bootIsDone()
+{
+  return(bootDone);
+}
+
 //
 // Hardware initialization and setup
 //
@@ -123,10 +177,12 @@ void setup()
   pinMode(PIN_AMP_EN, OUTPUT);
   digitalWrite(PIN_AMP_EN, LOW);
 
-  // Enable SI4732 VDD
+  // Enable SI4732 VDD, it then needs RADIO_POWER_TIME to come up, spent
+  // on setting up the display
   pinMode(PIN_POWER_ON, OUTPUT);
   digitalWrite(PIN_POWER_ON, HIGH);
-  delay(100);
+  uint32_t powerTime = millis();
+  profMark("power");
 
   // The line below may be necessary to setup I2C pins on ESP32
   Wire.begin(ESP32_I2C_SDA, ESP32_I2C_SCL);
@@ -167,6 +223,7 @@ void setup()
   spr.setSwapBytes(true);
   spr.setFreeFont(&Orbitron_Light_24);
   spr.setTextColor(TH.text, TH.bg);
+  profMark("display");
 
   // Press and hold Encoder button to force an preferences reset
   // Note: preferences reset is recommended after firmware updates
@@ -185,8 +242,15 @@ void setup()
     while(digitalRead(ENCODER_PUSH_BUTTON) == LOW) delay(100);
   }
 
-  // Initialize flash file system
+  // Initialize flash file system, settings are journaled there
   diskInit();
+  profMark("disk");
+
+  // Add user bands before the saved band index gets loaded
+  bandsLoadUser();
+
+  // Settings start with their defaults, saved ones replace them
+  settingsDefaults();
 
   if(!ESP.getPsramSize()) {
     ledcWrite(PIN_LCD_BL, 255);       // Default value 255 = 100%
@@ -201,6 +265,12 @@ void setup()
   while(1);
   }
 
+  // Large buffers live in the PSRAM arena
+  arenaInit();
+
+  // Wait for whatever is left of the SI4732 power up time
+  while(millis() - powerTime < RADIO_POWER_TIME) delay(1);
+
   // Check for SI4732 connected on I2C interface
   // If the SI4732 is not detected, then halt with no further processing
   rx.setI2CFastModeCustom(800000UL);
@@ -224,6 +294,7 @@ void setup()
 
   // Attached pin to allows SI4732 library to mute audio as required to minimise loud clicks
   rx.setAudioMuteMcuPin(AUDIO_MUTE);
+  profMark("receiver");
 
   // If loading preferences fails...
   if(!prefsLoad(SAVE_SETTINGS|SAVE_VERIFY))
@@ -239,25 +310,33 @@ void setup()
     while(digitalRead(ENCODER_PUSH_BUTTON)==LOW) delay(100);
   }
 
-  // If loading memories fails, save default memories
-  if(!prefsLoad(SAVE_MEMORIES|SAVE_VERIFY)) prefsSave(SAVE_MEMORIES);
-
   // If loading bands fails, save default bands
   if(!prefsLoad(SAVE_BANDS|SAVE_VERIFY)) prefsSave(SAVE_BANDS);
+  profMark("prefs");
 
   // Audio Amplifier Enable. G8PTN: Added
   // After the SI4732 has been setup, enable the audio amplifier
   digitalWrite(PIN_AMP_EN, HIGH);
 
+  // From now on, the radio task owns the receiver
+  radioInit();
+
   // SI4732 STARTUP!
   selectBand(bandIdx, false);
-  delay(50);
-  rx.setVolume(volume);
-  rx.setMaxSeekTime(SEEK_TIMEOUT);
+  radioPost([](int32_t vol, int32_t) {
+    delay(50);
+    rx.setVolume(vol);
+    profMark("audio");
+  }, volume);
+
+  // Memories are not needed for the audio, load them while it comes up
+  // If loading memories fails, save default memories
+  if(!prefsLoad(SAVE_MEMORIES|SAVE_VERIFY)) prefsSave(SAVE_MEMORIES);
 
   // Draw display for the first time
   drawScreen();
   ledcWrite(PIN_LCD_BL, currentBrt);
+  profMark("screen");
 
   // Interrupt actions for Rotary encoder
   // Note: Moved to end of setup to avoid inital interrupt actions
@@ -265,15 +344,52 @@ void setup()
   attachInterrupt(digitalPinToInterrupt(ENCODER_PIN_A), rotaryEncoder, CHANGE);
   attachInterrupt(digitalPinToInterrupt(ENCODER_PIN_B), rotaryEncoder, CHANGE);
 
-  // Connect WiFi, if necessary
-  netInit(wifiModeIdx);
-
-  // Start Bluetooth LE, if necessary
-  bleInit(bleModeIdx);
+  // Wake up the main loop on button presses and remote commands
+  attachInterrupt(digitalPinToInterrupt(ENCODER_PUSH_BUTTON), buttonWake, CHANGE);
+  Serial.onEvent(ARDUINO_HW_CDC_RX_EVENT, [](void *, esp_event_base_t, int32_t, void *) { schedWake(); });
+
+  // Register main loop jobs, see Scheduler.h for their periods
+  schedInit();
+  schedAdd([]() { return(processRssiSnr()); }, SCHED_RSSI_TIME, true, PROF_RSSI);
+  schedAdd([]() { return((currentMode == FM) && (snr >= 12) && checkRds()); }, SCHED_RDS_TIME, true, PROF_RDS);
+  schedAdd([]() { return(identifyFrequency(currentFrequency + currentBFO / 1000, true)); }, SCHED_SCHEDULE_TIME, true, PROF_SCHEDULE);
+  schedAdd([]() { return(bootDone && ntpSyncTime()); }, SCHED_NTP_TIME, true, PROF_NTP);
+  schedAdd([]() { return(clockTickTime()); }, SCHED_CLOCK_TIME);
+  schedAdd(checkTimeouts, SCHED_TIMEOUT_TIME);
+  schedAdd([]() { prefsTickTime(); return(false); }, SCHED_PREFS_TIME, true, PROF_PREFS);
+  schedAdd([]() {
+    // Apply Bluetooth and WiFi changes deferred while booting, and
+    // settings changed from the web page
+    if(!bootDone) return(false);
+    bleTickTime();
+    return(netTickTime());
+  }, SCHED_NET_TIME);
+  remoteInit([]() {
+    // Print status and mirror screen to remote interfaces
+    serialTickTime(&Serial, &remoteSerialState, usbModeIdx);
+    if(bootDone) remoteBLETickTime(&BLESerial, &remoteBLEState, bleModeIdx);
+    return(false);
+  });
+  backgroundJob = schedAdd([]() { return(currentCmd == CMD_NONE); }, SCHED_BACKGROUND_TIME);
+  identifyJob = schedAdd([]() { return(identifyFrequency(currentFrequency + currentBFO / 1000)); }, 0, false, PROF_SCHEDULE);
+  seekJob = schedAdd(seekTickTime, SCHED_SEEK_TIME, false);
+  schedAdd([]() { cpuTickTime(); return(false); }, SCHED_CPU_TIME);
+  schedAdd(heapTickTime, SCHED_HEAP_TIME);
+  menuInit();
+  scanInit();
+  bleQueueInit();
+
+  // Allocate the memory bank in PSRAM
+  bankInit();
+
+  // Load the memory bank, start Bluetooth and WiFi in the background
+  xTaskCreatePinnedToCore(bootTaskMain, "boot", BOOT_STACK_SIZE, NULL, 1, NULL, BOOT_CORE);
+  heapTickTime();
+  profMark("setup");
 }
 
 
-int16_t accelerateEncoder(int8_t dir)
+int16_t accelerateEncoder(int8_t dir, uint32_t currentTime)
 {
   const uint32_t speedThresholds[] = {350, 60, 45, 35, 25}; // ms between clicks
   const uint16_t accelFactors[] =      {1,  2,  4,  8, 16}; // corresponding multipliers
@@ -282,7 +398,6 @@ int16_t accelerateEncoder(int8_t dir)
   static uint16_t lastAccelFactor = accelFactors[0];
   static int8_t lastEncoderDir = 0;
 
-  uint32_t currentTime = millis();
   lastSpeed = ((currentTime - lastEncoderTime) * 7 + lastSpeed * 3) / 10;
 
   // Reset acceleration on timeout or direction change
@@ -318,47 +433,85 @@ ICACHE_RAM_ATTR void rotaryEncoder()
   uint8_t encoderStatus = encoder.process();
   if(encoderStatus)
   {
-    int8_t delta = encoderStatus==DIR_CW? 1 : -1;
-    int16_t accelDelta = accelerateEncoder(delta);
+    uint32_t head = encoderHead;
 
-    // Do not accumulate too many encoder steps if event loop doesn't consume them
-    if(abs(encoderCount) < 5)
+    // Record the detent, unless the main loop is hopelessly behind
+    if(head - encoderTail < ENCODER_EVENTS)
     {
-      encoderCount += delta;
-      encoderCountAccel += accelDelta;
+      encoderEvents[head & (ENCODER_EVENTS - 1)].time = millis();
+      encoderEvents[head & (ENCODER_EVENTS - 1)].dir  = encoderStatus==DIR_CW? 1 : -1;
+      // Publish the event only after it has been written
+      __atomic_signal_fence(__ATOMIC_RELEASE);
+      encoderHead = head + 1;
     }
 
-    // Reset the seek flag
-    seekStop = true;
+    // Handle rotation right away
+    schedWakeFromISR();
   }
 }
 
-uint32_t consumeEncoderCounts()
+//
+// Wakes up the main loop when the encoder button changes state
+//
+ICACHE_RAM_ATTR void buttonWake()
 {
-  int16_t encCount, encCountAccel;
-  noInterrupts();
-  encCount = encoderCount;
-  encCountAccel = encoderCountAccel;
-  encoderCount = 0;
-  encoderCountAccel = 0;
-  interrupts();
-  return ((uint32_t)encCountAccel << 16) | ((uint16_t)encCount & 0xFFFF);
+  schedWakeFromISR();
 }
 
 //
-// Switch radio to given band
+// Post encoder detents since the last call as a rotation event, with
+// both plain and accelerated counts. Acceleration uses the time of each
+// detent, so it does not depend on how often the main loop gets here.
 //
-void useBand(const Band *band)
+void postEncoderEvents()
 {
-  // Set current frequency and mode, reset BFO
-  currentFrequency = band->currentFreq;
-  currentMode = band->bandMode;
-  currentBFO = 0;
+  int16_t encCount = 0, encCountAccel = 0;
+  uint32_t head = encoderHead;
+  uint32_t time = 0;
+  __atomic_signal_fence(__ATOMIC_ACQUIRE);
+
+  for(uint32_t tail = encoderTail ; tail != head ; tail++)
+  {
+    int8_t dir = encoderEvents[tail & (ENCODER_EVENTS - 1)].dir;
+    if(!time) time = encoderEvents[tail & (ENCODER_EVENTS - 1)].time;
+    encCount += dir;
+    encCountAccel += accelerateEncoder(dir, encoderEvents[tail & (ENCODER_EVENTS - 1)].time);
+  }
+
+  encoderTail = head;
+  if(encCount) inputPost(INPUT_ROTATE, INPUT_KNOB, encCount, encCountAccel, time);
+}
+
+//
+// Receiver setup for a band, a copy taken by useBand(), so the radio
+// task does not read main loop state. There is a slot for each command
+// that can be queued, plus the one running.
+//
+typedef struct
+{
+  uint16_t minimumFreq;  // Band limits
+  uint16_t maximumFreq;
+  uint16_t step;         // Frequency step
+  int16_t  bfo;          // SSB BFO, i.e. calibration
+  uint8_t  bandMode;     // Band mode (FM, AM, LSB, or USB)
+  uint8_t  deEmphasis;   // FM de-emphasis
+} BandSetup;
+
+static BandSetup bandSetups[RADIO_QUEUE_SIZE + 1];
+static uint8_t bandSetupNext = 0;
+
+//
+// Configure receiver for given band setup, runs on the radio task
+//
+static void radioSetBand(int32_t slot, int32_t freq)
+{
+  TRACE_SCOPE(TRACE_SET_BAND, freq);
+  const BandSetup *band = &bandSetups[slot];
 
   if(band->bandMode==FM)
   {
     // rx.setMaxDelaySetFrequency(60);
-    rx.setFM(band->minimumFreq, band->maximumFreq, band->currentFreq, getCurrentStep()->step);
+    rx.setFM(band->minimumFreq, band->maximumFreq, freq, band->step);
     // rx.setTuneFrequencyAntennaCapacitor(0);
     rx.setSeekFmLimits(band->minimumFreq, band->maximumFreq);
 
@@ -367,7 +520,7 @@ void useBand(const Band *band)
     rx.setSeekFmRssiThreshold(5); // default is 20
     rx.setSeekFmSNRThreshold(2); // default is 3
 
-    rx.setFMDeEmphasis(fmRegions[FmRegionIdx].value);
+    rx.setFMDeEmphasis(band->deEmphasis);
     rx.RdsInit();
     rx.setRdsConfig(1, 2, 2, 2, 2);
     rx.setGpioCtl(1, 0, 0);   // G8PTN: Enable GPIO1 as output
@@ -378,7 +531,7 @@ void useBand(const Band *band)
     // rx.setMaxDelaySetFrequency(80);
     if(band->bandMode==AM)
     {
-      rx.setAM(band->minimumFreq, band->maximumFreq, band->currentFreq, getCurrentStep()->step);
+      rx.setAM(band->minimumFreq, band->maximumFreq, freq, band->step);
       // More sensitive seek thresholds
       // https://github.com/pu2clr/SI4735/issues/7#issuecomment-810963604
       rx.setSeekAmRssiThreshold(10); // default is 25
@@ -387,18 +540,13 @@ void useBand(const Band *band)
     else
     {
       // Configure SI4732 for SSB (SI4732 step not used, set to 0)
-      rx.setSSB(band->minimumFreq, band->maximumFreq, band->currentFreq, 0, currentMode);
+      rx.setSSB(band->minimumFreq, band->maximumFreq, freq, 0, band->bandMode);
       // G8PTN: Always enabled
       rx.setSSBAutomaticVolumeControl(1);
       // G8PTN: Commented out
       //rx.setSsbSoftMuteMaxAttenuation(softMuteMaxAttIdx);
-      // To move frequency forward, need to move the BFO backwards
-      if (currentMode == USB)
-        rx.setSSBBfo(-(currentBFO + band->usbCal));
-      else if (currentMode == LSB)
-        rx.setSSBBfo(-(currentBFO + band->lsbCal));
-      else
-        rx.setSSBBfo(-currentBFO);  // No calibration if not USB/LSB
+      // BFO is reset, only apply calibration
+      rx.setSSBBfo(band->bfo);
     }
 
     // Set the tuning capacitor for SW or MW/LW
@@ -411,6 +559,45 @@ void useBand(const Band *band)
     // Consider the range all defined current band
     rx.setSeekAmLimits(band->minimumFreq, band->maximumFreq);
   }
+}
+
+//
+// Save current frequency to given band, sub-kHz digits of the SSB
+// tuning go to the band BFO, the same way memories keep them
+//
+void storeBandFreq(Band *band)
+{
+  int32_t freq = currentFrequency * 1000 + currentBFO;
+
+  band->currentFreq = freq / 1000;
+  band->currentBFO  = freq % 1000;
+}
+
+//
+// Switch radio to given band
+//
+void useBand(const Band *band)
+{
+  // Set current frequency and mode, reset BFO
+  currentFrequency = band->currentFreq;
+  currentMode = band->bandMode;
+  currentBFO = 0;
+
+  // Reconfigure the receiver
+  BandSetup *setup = &bandSetups[bandSetupNext];
+  bandSetupNext = (bandSetupNext + 1) % ITEM_COUNT(bandSetups);
+
+  setup->minimumFreq = band->minimumFreq;
+  setup->maximumFreq = band->maximumFreq;
+  setup->step        = getCurrentStep()->step;
+  setup->bandMode    = band->bandMode;
+  setup->deEmphasis  = fmRegions[FmRegionIdx].value;
+  setup->bfo         =
+    band->bandMode == USB? -band->usbCal :
+    band->bandMode == LSB? -band->lsbCal : 0;
+
+  radioSetMode(band->bandMode);
+  radioPost(radioSetBand, setup - bandSetups, band->currentFreq, RADIO_RETUNE);
 
   // Set step and spacing based on mode (FM, AM, SSB)
   doStep(0);
@@ -420,13 +607,27 @@ void useBand(const Band *band)
   doAgc(0);
   // Set currentAVC values based on mode (AM, SSB)
   doAvc(0);
-  // Wait a bit for things to calm down
-  delay(100);
+  // Wait a bit for things to calm down, without holding the UI
+  radioPost([](int32_t ms, int32_t) { delay(ms); }, 100);
   // Clear signal strength readings
   rssi = 0;
   snr  = 0;
 }
 
+//
+// Get SSB BFO offset for the receiver
+//
+static int16_t getBfoOffset(const Band *band)
+{
+  // To move frequency forward, need to move the BFO backwards
+  if (currentMode == USB)
+    return(-(currentBFO + band->usbCal));
+  else if (currentMode == LSB)
+    return(-(currentBFO + band->lsbCal));
+  else
+    return(-currentBFO);  // No calibration if not USB/LSB
+}
+
 //
 // Tune using BFO, using algorithm from Goshante's ATS-20_EX firmware
 //
@@ -463,31 +664,16 @@ bool updateBFO(int newBFO, bool wrap)
     newBFO  = 0;
   }
 
-  // If need to change frequency...
-  if(newFreq != currentFrequency)
-  {
-    // Apply new frequency
-    rx.setFrequency(newFreq);
-
-    // Re-apply to remove noise
-    doAgc(0);
-    // Update current frequency
-    currentFrequency = rx.getFrequency();
-  }
-
-  // Update current BFO
+  // Update current frequency and BFO
+  currentFrequency = newFreq;
   currentBFO = newBFO;
 
-  // To move frequency forward, need to move the BFO backwards
-  if (currentMode == USB)
-    rx.setSSBBfo(-(currentBFO + band->usbCal));
-  else if (currentMode == LSB)
-    rx.setSSBBfo(-(currentBFO + band->lsbCal));
-  else
-    rx.setSSBBfo(-currentBFO);  // No calibration if not USB/LSB
+  // Apply new BFO, the radio task only retunes (and re-applies AGC
+  // to remove noise) if the frequency has changed
+  radioTune(currentFrequency, getBfoOffset(band), false);
 
   // Save current band frequency, w.r.t. new BFO value
-  band->currentFreq = currentFrequency + currentBFO / 1000;
+  storeBandFreq(band);
   return true;
 }
 
@@ -508,44 +694,71 @@ bool updateFrequency(int newFreq, bool wrap)
     if(!wrap) return false; else newFreq = band->minimumFreq;
   }
 
-  // Set new frequency
-  rx.setFrequency(newFreq);
-
-  // Clear BFO, if present
-  if(currentBFO) updateBFO(0, true);
+  // Update current frequency, clear BFO
+  currentFrequency = newFreq;
+  currentBFO = 0;
 
-  // Update current frequency
-  currentFrequency = rx.getFrequency();
+  // Set new frequency and BFO (in SSB modes)
+  radioTune(currentFrequency, isSSB()? getBfoOffset(band) : RADIO_NO_BFO);
 
   // Save current band frequency
-  band->currentFreq = currentFrequency + currentBFO / 1000;
+  storeBandFreq(band);
   return true;
 }
 
-// This function is called by the seek function process.
-bool checkStopSeeking()
+//
+// Follow seek progress on the radio task, runs while seeking
+//
+bool seekTickTime()
 {
-  // Returns true if the user rotates the encoder
-  if(seekStop) return true;
+  RadioStatus status;
+
+  // Wait for the radio task to pick up seek start or stop
+  if(radioBusy()) return(false);
+  radioGetStatus(&status);
 
-  // Checking isPressed without debouncing because this callback
-  // is not invoked often enough to register a click
-  if(pb1.update(digitalRead(ENCODER_PUSH_BUTTON) == LOW, 0).isPressed)
+  // A band or mode change ends the seek, its frequency belongs to the
+  // previous band then
+  bool sameBand = bandIdx == seekBandIdx && currentMode == seekModeIdx;
+
+  if(status.seeking && sameBand)
   {
-    // Wait till the button is released, otherwise the main loop will register a click
-    while(pb1.update(digitalRead(ENCODER_PUSH_BUTTON) == LOW).isPressed)
-      delay(100);
-    return true;
+    // Show the frequency passed, at most once per frame
+    if(currentFrequency != status.seekFreq)
+    {
+      currentFrequency = status.seekFreq;
+      drawRequest();
+    }
+    return(false);
   }
 
-  return false;
+  // Seek is over, stay at the frequency it ended at
+  schedStop(seekJob);
+  seekActive = false;
+
+  if(sameBand)
+  {
+    updateFrequency(status.seekFreq, true);
+    prefsRequestSave(SAVE_CUR_BAND);
+
+    // Check for named frequencies
+    identifyFrequency(currentFrequency + currentBFO / 1000);
+  }
+  // Enable amp
+  muteOn(MUTE_TEMP, false);
+  drawRequest();
+  return(false);
 }
 
-// This function is called by the seek function process.
-void showFrequencySeek(uint16_t freq)
+//
+// Stop seek or scan in progress, returns TRUE if there was one
+//
+static bool seekCancel()
 {
-  currentFrequency = freq;
-  drawScreen();
+  if(scanCancel()) return(true);
+  if(!seekActive) return(false);
+  radioSeekStop();
+  return(true);
 }
 
 //
@@ -567,10 +780,14 @@ bool doSeek(int16_t enc, int16_t enca)
       clearStationInfo();
       rssi = snr = 0;
 
-      // Flag is set by rotary encoder and cleared on seek/scan entry
-      seekStop = false;
-      rx.seekStationProgress(showFrequencySeek, checkStopSeeking, enc>0? 1 : 0);
-      updateFrequency(rx.getFrequency(), true);
+      // Seek on the radio task, seekTickTime() follows it and
+      // enables the amp once it is over
+      radioSeek(enc>0);
+      seekActive = true;
+      seekBandIdx = bandIdx;
+      seekModeIdx = currentMode;
+      schedStart(seekJob, SCHED_SEEK_TIME);
+      return(true);
     }
   }
   else if(seekMode() == SEEK_SCHEDULE && enc)
@@ -630,8 +847,9 @@ bool doTune(int16_t enc)
 
   // Clear current station name and information
   clearStationInfo();
-  // Check for named frequencies
-  identifyFrequency(currentFrequency + currentBFO / 1000);
+  // Check for named frequencies once the knob stops, there is
+  // no point in looking up every frequency passed while spinning
+  schedStart(identifyJob, SCHED_IDENTIFY_TIME);
   // Will need a redraw
   return(true);
 }
@@ -699,9 +917,10 @@ bool processRssiSnr()
   static uint32_t updateCounter = 0;
   bool needRedraw = false;
 
-  rx.getCurrentReceivedSignalQuality();
-  int newRSSI = rx.getCurrentRSSI();
-  int newSNR = rx.getCurrentSNR();
+  RadioStatus status;
+  radioGetStatus(&status);
+  int newRSSI = status.rssi;
+  int newSNR = status.snr;
 
   // Apply squelch if the volume is not muted
   if(currentSquelch && currentSquelch <= 127)
@@ -740,258 +959,297 @@ bool processRssiSnr()
 }
 
 //
-// Main event loop
+// Turn off encoder-controlled commands and the display after a period
+// of inactivity. Returns TRUE if the screen needs a refresh.
 //
-void loop()
+bool checkTimeouts()
 {
   uint32_t currentTime = millis();
   bool needRedraw = false;
 
-  uint32_t encCounts = consumeEncoderCounts();
-  int16_t encCount = (int16_t)(encCounts & 0xFFFF);
-  int16_t encCountAccel = (int16_t)(encCounts >> 16);
+  // Disable commands control
+  if((currentTime - elapsedCommand) > ELAPSED_COMMAND)
+  {
+    if(currentCmd != CMD_NONE && currentCmd != CMD_SEEK && currentCmd != CMD_SCAN && currentCmd != CMD_MEMORY)
+    {
+      currentCmd = CMD_NONE;
+      needRedraw = true;
+    }
 
-  ButtonTracker::State pb1st = pb1.update(digitalRead(ENCODER_PUSH_BUTTON) == LOW);
+    elapsedCommand = currentTime;
+  }
+
+  // Display sleep timeout
+  if(currentSleep && !sleepOn() && ((currentTime - elapsedSleep) > currentSleep * 1000))
+  {
+    sleepOn(true);
+    // CPU sleep can take long time, renew the timestamps
+    elapsedSleep = elapsedCommand = millis();
+  }
 
-  // Periodically print status to remote interfaces
-  serialTickTime(&Serial, &remoteSerialState, usbModeIdx);
-  remoteBLETickTime(&BLESerial, &remoteBLEState, bleModeIdx);
-
-  // if(encCount && getCpuFrequencyMhz()!=240) setCpuFrequencyMhz(240);
-
-  // Receive and execute serial command
-  int ser_event = serialDoCommand(&Serial, &remoteSerialState, usbModeIdx);
-  needRedraw |= !!(ser_event & REMOTE_CHANGED);
-  pb1st.wasClicked |= !!(ser_event & REMOTE_CLICK);
-  int ser_direction = ser_event >> REMOTE_DIRECTION;
-  encCount = ser_direction? ser_direction : encCount;
-  encCountAccel = ser_direction? ser_direction : encCountAccel;
-  if(ser_event & REMOTE_PREFS) prefsRequestSave(SAVE_ALL);
-
-  // Receive and execute BLE command
-  int ble_event = bleDoCommand(&BLESerial, &remoteBLEState, bleModeIdx);
-  needRedraw |= !!(ble_event & REMOTE_CHANGED);
-  pb1st.wasClicked |= !!(ble_event & REMOTE_CLICK);
-  int ble_direction = ble_event >> REMOTE_DIRECTION;
-  encCount = ble_direction? ble_direction : encCount;
-  encCountAccel = ble_direction? ble_direction : encCountAccel;
-  if(ble_event & REMOTE_PREFS) prefsRequestSave(SAVE_ALL);
+  return(needRedraw);
+}
+
+//
+// Main event loop
+//
+//
+// Handle encoder rotation, returns TRUE if the screen needs a redraw
+//
+static bool handleRotate(int16_t encCount, int16_t encCountAccel, bool pressed)
+{
+  uint32_t currentTime = millis();
+  bool needRedraw = false;
 
   // Block encoder rotation when in the locked sleep mode
-  if(encCount && sleepOn() && sleepModeIdx==SLEEP_LOCKED) encCount = encCountAccel = 0;
+  if(sleepOn() && sleepModeIdx==SLEEP_LOCKED) return(false);
+
+  // Rotation stops a seek in progress and does nothing else
+  if(seekCancel()) return(false);
 
   // Activate push and rotate mode (can span multiple loop iterations until the button is released)
-  if (encCount && pb1st.isPressed) pushAndRotate = true;
+  if (pressed) pushAndRotate = true;
 
   // If push and rotate mode is active...
   if(pushAndRotate)
   {
-    // If encoder has been rotated
-    if(encCount)
+    switch(currentCmd)
     {
-      switch(currentCmd)
-      {
-        case CMD_NONE:
-          // Activate frequency input mode
-          currentCmd = CMD_FREQ;
-          needRedraw = true;
-          break;
-        case CMD_FREQ:
-          // Select digit
-          doSelectDigit(encCount);
-          needRedraw = true;
-          break;
-        case CMD_SEEK:
-          // Normal tuning in seek mode
-          needRedraw |= doTune(encCount);
-          // Current frequency may have changed
-          prefsRequestSave(SAVE_CUR_BAND);
-          break;
-      }
+      case CMD_NONE:
+        // Activate frequency input mode
+        currentCmd = CMD_FREQ;
+        needRedraw = true;
+        break;
+      case CMD_FREQ:
+        // Select digit
+        doSelectDigit(encCount);
+        needRedraw = true;
+        break;
+      case CMD_SEEK:
+        // Normal tuning in seek mode
+        needRedraw |= doTune(encCount);
+        // Current frequency may have changed
+        prefsRequestSave(SAVE_CUR_BAND);
+        break;
     }
-    // Reset timeouts while push and rotate is active
-    elapsedSleep = elapsedCommand = currentTime;
   }
   else
   {
-    // If encoder has been rotated
-    if(encCount)
+    switch(currentCmd)
     {
-      switch(currentCmd)
-      {
-        case CMD_NONE:
-        case CMD_SCAN:
-          // Tuning
-          needRedraw |= doTune(encCountAccel);
-          // Current frequency may have changed
-          prefsRequestSave(SAVE_CUR_BAND);
-          break;
-        case CMD_FREQ:
-          // Digit tuning
-          needRedraw |= doDigit(encCount);
-          // Current frequency may have changed
-          prefsRequestSave(SAVE_CUR_BAND);
-          break;
-        case CMD_SEEK:
-          // Seek mode
-          needRedraw |= doSeek(encCount, encCountAccel);
-          // Seek can take long time, renew the timestamp
-          currentTime = millis();
-          // Current frequency may have changed
-          prefsRequestSave(SAVE_CUR_BAND);
-          break;
-        default:
-          // Side bar menus / settings
-          needRedraw |= doSideBar(currentCmd, encCount, encCountAccel);
-          // Current settings, etc. may have changed
-          prefsRequestSave(SAVE_ALL);
-          break;
-      }
-
-      // Reset timeouts
-      elapsedSleep = elapsedCommand = currentTime;
+      case CMD_NONE:
+      case CMD_SCAN:
+        // Tuning
+        needRedraw |= doTune(encCountAccel);
+        // Current frequency may have changed
+        prefsRequestSave(SAVE_CUR_BAND);
+        break;
+      case CMD_FREQ:
+        // Digit tuning
+        needRedraw |= doDigit(encCount);
+        // Current frequency may have changed
+        prefsRequestSave(SAVE_CUR_BAND);
+        break;
+      case CMD_SEEK:
+        // Seek mode
+        needRedraw |= doSeek(encCount, encCountAccel);
+        // Current frequency may have changed
+        prefsRequestSave(SAVE_CUR_BAND);
+        break;
+      default:
+        // Side bar menus / settings
+        needRedraw |= doSideBar(currentCmd, encCount, encCountAccel);
+        // Current settings, etc. may have changed
+        prefsRequestSave(SAVE_ALL);
+        break;
     }
-    else if(pb1st.isLongPressed)
-    {
-      // Encoder is being LONG PRESSED: TOGGLE DISPLAY
-      sleepOn(!sleepOn());
-      // CPU sleep can take long time, renew the timestamps
-      elapsedSleep = elapsedCommand = currentTime = millis();
+  }
+
+  // Reset timeouts
+  elapsedSleep = elapsedCommand = currentTime;
+  return(needRedraw);
+}
+
+//
+// Handle encoder click or short press, returns TRUE if the screen
+// needs a redraw
+//
+static bool handleClick(bool shortPress)
+{
+  // Button is ignored in push and rotate mode
+  if(pushAndRotate) return(false);
 
+  // Click stops a seek in progress and does nothing else
+  if(seekCancel()) return(false);
+
+  // Reset timeouts
+  elapsedSleep = elapsedCommand = millis();
+
+  // If in locked/unlocked sleep mode
+  if(sleepOn())
+  {
+    // If sleep timeout is enabled, exit it via button press of any duration
+    // (users don't need to figure out that a long press is required to wake up the device)
+    if(currentSleep)
+    {
+      sleepOn(false);
+      return(true);
     }
-    else if(pb1st.wasClicked || pb1st.wasShortPressed)
+    else if(sleepModeIdx == SLEEP_UNLOCKED)
     {
-      // Encoder click or short press
-      // Reset timeouts
-      elapsedSleep = elapsedCommand = currentTime;
-
-      // If in locked/unlocked sleep mode
-      if(sleepOn())
-      {
-        // If sleep timeout is enabled, exit it via button press of any duration
-        // (users don't need to figure out that a long press is required to wake up the device)
-        if(currentSleep)
-        {
-          sleepOn(false);
-          needRedraw = true;
-        }
-        else if(sleepModeIdx == SLEEP_UNLOCKED)
-        {
-          // Allow to adjust the volume in sleep mode
-          if(pb1st.wasShortPressed && currentCmd==CMD_NONE)
-            currentCmd = CMD_VOLUME;
-          else if(currentCmd==CMD_VOLUME)
-            clickHandler(currentCmd, pb1st.wasShortPressed);
-
-          needRedraw = true;
-        }
-      }
-      else if(clickHandler(currentCmd, pb1st.wasShortPressed))
-      {
-        // Command handled, redraw screen
-        needRedraw = true;
-
-        // EiBi can take long time, renew the timestamps
-        elapsedSleep = elapsedCommand = currentTime = millis();
-      }
-      else if(currentCmd != CMD_NONE)
-      {
-        // Deactivate modal mode
-        currentCmd = CMD_NONE;
-        needRedraw = true;
-      }
-      else if(pb1st.wasShortPressed)
-      {
-        // Volume shortcut (only active in VFO mode)
+      // Allow to adjust the volume in sleep mode
+      if(shortPress && currentCmd==CMD_NONE)
         currentCmd = CMD_VOLUME;
-        needRedraw = true;
-      }
-      else
-      {
-        // Activate menu
-        currentCmd = CMD_MENU;
-        needRedraw = true;
-      }
+      else if(currentCmd==CMD_VOLUME)
+        clickHandler(currentCmd, shortPress);
+
+      return(true);
     }
+    return(false);
   }
 
-  // Deactivate push and rotate mode
-  if(!pb1st.isPressed && pushAndRotate)
+  if(clickHandler(currentCmd, shortPress))
   {
-    pushAndRotate = false;
-    needRedraw = true;
+    // Command handled, EiBi can take long time, renew the timestamps
+    elapsedSleep = elapsedCommand = millis();
   }
-
-  // Disable commands control
-  if((currentTime - elapsedCommand) > ELAPSED_COMMAND)
+  else if(currentCmd != CMD_NONE)
   {
-    // if(getCpuFrequencyMhz()!=80) setCpuFrequencyMhz(80);
-    if(currentCmd != CMD_NONE && currentCmd != CMD_SEEK && currentCmd != CMD_SCAN && currentCmd != CMD_MEMORY)
-    {
-      currentCmd = CMD_NONE;
-      needRedraw = true;
-    }
-
-    elapsedCommand = currentTime;
+    // Deactivate modal mode
+    currentCmd = CMD_NONE;
   }
-
-  // Display sleep timeout
-  if(currentSleep && !sleepOn() && ((currentTime - elapsedSleep) > currentSleep * 1000))
+  else if(shortPress)
   {
-    sleepOn(true);
-    // CPU sleep can take long time, renew the timestamps
-    elapsedSleep = elapsedCommand = currentTime = millis();
+    // Volume shortcut (only active in VFO mode)
+    currentCmd = CMD_VOLUME;
   }
-
-  if((currentTime - elapsedRSSI) > MIN_ELAPSED_RSSI_TIME)
+  else
   {
-    needRedraw |= processRssiSnr();
-    elapsedRSSI = currentTime;
+    // Activate menu
+    currentCmd = CMD_MENU;
   }
 
-  // Periodically check received RDS information
-  if((currentTime - lastRDSCheck) > RDS_CHECK_TIME)
+  return(true);
+}
+
+//
+// Handle a single input event, returns TRUE if the screen needs a redraw
+//
+static bool handleInput(const InputEvent *event, bool pressed)
+{
+  // Band, mode and memory menus change band once the selection settles,
+  // any other input has to see the receiver in the selected band
+  bool scrolling = event->type == INPUT_ROTATE &&
+    (currentCmd == CMD_BAND || currentCmd == CMD_MODE || currentCmd == CMD_MEMORY);
+  if(!scrolling) applyBand();
+
+  switch(event->type)
   {
-    needRedraw |= (currentMode == FM) && (snr >= 12) && checkRds();
-    lastRDSCheck = currentTime;
+    case INPUT_ROTATE:
+      return(handleRotate(event->value, event->accel, pressed));
+
+    case INPUT_PRESS:
+      // Pressing the button stops a seek in progress, ignore the
+      // button until it is released
+      if(seekCancel()) pushAndRotate = true;
+      return(false);
+
+    case INPUT_CLICK:
+    case INPUT_SHORT:
+      return(handleClick(event->type == INPUT_SHORT));
+
+    case INPUT_LONG:
+      if(pushAndRotate) return(false);
+      // Encoder is being LONG PRESSED: TOGGLE DISPLAY
+      sleepOn(!sleepOn());
+      // CPU sleep can take long time, renew the timestamps
+      elapsedSleep = elapsedCommand = millis();
+      return(false);
+
+    case INPUT_COMMAND:
+    {
+      // Apply queued remote commands, others have already been executed
+      int flags = event->accel | remoteApplyCommand(event->value);
+      if(flags & REMOTE_PREFS) prefsRequestSave(SAVE_ALL);
+      return(!!(flags & REMOTE_CHANGED));
+    }
   }
 
-  // Periodically check schedule
-  if((currentTime - lastScheduleCheck) > SCHEDULE_CHECK_TIME)
+  return(false);
+}
+
+void loop()
+{
+  static bool wasPressed = false;
+  bool needRedraw = false;
+  bool needRefresh = false;
+  InputEvent event;
+  uint32_t loopStart = profStart();
+  uint32_t start = loopStart;
+
+  // Collect input events from all sources
+  postEncoderEvents();
+
+  ButtonTracker::State pb1st = pb1.update(digitalRead(ENCODER_PUSH_BUTTON) == LOW);
+  if(pb1st.isPressed && !wasPressed) inputPost(INPUT_PRESS, INPUT_KNOB);
+  if(pb1st.wasClicked) inputPost(INPUT_CLICK, INPUT_KNOB);
+  if(pb1st.wasShortPressed) inputPost(INPUT_SHORT, INPUT_KNOB);
+  if(pb1st.isLongPressed) inputPost(INPUT_LONG, INPUT_KNOB);
+  wasPressed = pb1st.isPressed;
+  uint32_t inputTime = micros() - start;
+
+  // Receive and execute serial and BLE commands
+  start = profStart();
+  serialDoCommand(&Serial, &remoteSerialState, usbModeIdx);
+  if(bootDone) bleDoCommand(&BLESerial, &remoteBLEState, bleModeIdx);
+  profEnd(PROF_REMOTE, start);
+
+  // Handle all pending events in order
+  start = profStart();
+  while(inputGet(&event))
   {
-    needRedraw |= identifyFrequency(currentFrequency + currentBFO / 1000, true);
-    lastScheduleCheck = currentTime;
+    bool redraw = handleInput(&event, pb1st.isPressed);
+    inputHandled(&event, redraw);
+    cpuInput(event.time);
+    needRedraw |= redraw;
   }
+  profAdd(PROF_INPUT, inputTime + micros() - start);
 
-  // Periodically synchronize time via NTP
-  if((currentTime - lastNTPCheck) > NTP_CHECK_TIME)
+  // Reset timeouts while push and rotate is active
+  if(pushAndRotate) elapsedSleep = elapsedCommand = millis();
+
+  // Deactivate push and rotate mode
+  if(!pb1st.isPressed && pushAndRotate)
   {
-    needRedraw |= ntpSyncTime();
-    lastNTPCheck = currentTime;
+    pushAndRotate = false;
+    needRedraw = true;
   }
 
-  // Tick preferences time, saving changes when there has
-  // been no activity for a while
-  prefsTickTime();
+  // Run periodic jobs that are due
+  needRefresh |= schedRun();
 
-  // Tick NETWORK time, connecting to WiFi if requested
-  netTickTime();
+  // Refresh the main screen if nothing else triggers a refresh
+  if(needRedraw || needRefresh) schedStart(backgroundJob, SCHED_BACKGROUND_TIME);
 
-  // Run clock
-  needRedraw |= clockTickTime();
+  // Request screen update if necessary, user actions take priority
+  // over periodic refreshes
+  if(needRedraw) drawRequest(DRAW_URGENT);
+  else if(needRefresh) drawRequest(DRAW_COSMETIC);
 
-  // Periodically refresh the main screen
-  // This covers the case where there is nothing else triggering a refresh
-  if(needRedraw) background_timer = currentTime;
-  if((currentTime - background_timer) > BACKGROUND_REFRESH_TIME)
+  // Draw screen when the frame budget allows
+  start = profStart();
+  if(drawTickTime())
   {
-    if(currentCmd == CMD_NONE) needRedraw = true;
-    background_timer = currentTime;
+    profEnd(PROF_DRAW, start);
+    inputDrawn();
   }
 
-  // Redraw screen if necessary
-  if(needRedraw) drawScreen();
+  profLoopEnd(loopStart);
 
-  // Add a small default delay in the main loop
-  delay(5);
+  // Sleep until a job is due, a frame can be drawn or an input event
+  // arrives. Button debounce and long press detection need polling.
+  uint32_t maxWait = drawWaitTime();
+  if(pb1st.isPressed || digitalRead(ENCODER_PUSH_BUTTON) == LOW)
+    maxWait = min(maxWait, (uint32_t)SCHED_BUTTON_TIME);
+  schedWait(maxWait);
 }
@@ -0,0 +1,152 @@
+#include "Png.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+static uint32_t crcTable[256];
+
+static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t size)
+{
+  if(!crcTable[1])
+    for(uint32_t n = 0 ; n < 256 ; n++)
+    {
+      uint32_t c = n;
+      for(int k = 0 ; k < 8 ; k++) c = c & 1? 0xEDB88320 ^ (c >> 1) : c >> 1;
+      crcTable[n] = c;
+    }
+
+  crc = ~crc;
+  while(size--) crc = crcTable[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+  return(~crc);
+}
+
+static void put32(std::vector<uint8_t> &v, uint32_t x)
+{
+  v.push_back(x >> 24);
+  v.push_back(x >> 16);
+  v.push_back(x >> 8);
+  v.push_back(x);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+  return(((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3]);
+}
+
+static void writeChunk(FILE *f, const char *type, const std::vector<uint8_t> &data)
+{
+  std::vector<uint8_t> chunk;
+  put32(chunk, data.size());
+  chunk.insert(chunk.end(), type, type + 4);
+  chunk.insert(chunk.end(), data.begin(), data.end());
+  put32(chunk, crc32(0, chunk.data() + 4, chunk.size() - 4));
+  fwrite(chunk.data(), 1, chunk.size(), f);
+}
+
+bool pngWrite(const char *path, const uint16_t *pixels, int width, int height)
+{
+  static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+  // Raw scanlines: filter byte followed by RGB triplets
+  std::vector<uint8_t> raw;
+  for(int y = 0 ; y < height ; y++)
+  {
+    raw.push_back(0);
+    for(int x = 0 ; x < width ; x++)
+    {
+      uint16_t c = pixels[x + y * width];
+      uint8_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+      raw.push_back((r << 3) | (r >> 2));
+      raw.push_back((g << 2) | (g >> 4));
+      raw.push_back((b << 3) | (b >> 2));
+    }
+  }
+
+  // Zlib stream made of stored deflate blocks
+  std::vector<uint8_t> z = { 0x78, 0x01 };
+  uint32_t a = 1, b = 0;
+  for(size_t pos = 0 ; pos < raw.size() ; )
+  {
+    size_t len = raw.size() - pos < 65535? raw.size() - pos : 65535;
+    bool last = pos + len == raw.size();
+    z.push_back(last? 1 : 0);
+    z.push_back(len & 0xFF);
+    z.push_back(len >> 8);
+    z.push_back(~len & 0xFF);
+    z.push_back((~len >> 8) & 0xFF);
+    for(size_t i = 0 ; i < len ; i++)
+    {
+      a = (a + raw[pos + i]) % 65521;
+      b = (b + a) % 65521;
+    }
+    z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + len);
+    pos += len;
+  }
+  put32(z, (b << 16) | a);
+
+  std::vector<uint8_t> ihdr;
+  put32(ihdr, width);
+  put32(ihdr, height);
+  ihdr.insert(ihdr.end(), { 8, 2, 0, 0, 0 });
+
+  FILE *f = fopen(path, "wb");
+  if(!f) return(false);
+  fwrite(signature, 1, sizeof(signature), f);
+  writeChunk(f, "IHDR", ihdr);
+  writeChunk(f, "IDAT", z);
+  writeChunk(f, "IEND", {});
+  return(!fclose(f));
+}
+
+bool pngRead(const char *path, uint16_t *pixels, int width, int height)
+{
+  FILE *f = fopen(path, "rb");
+  if(!f) return(false);
+
+  std::vector<uint8_t> file;
+  uint8_t buf[4096];
+  for(size_t n ; (n = fread(buf, 1, sizeof(buf), f)) > 0 ; )
+    file.insert(file.end(), buf, buf + n);
+  fclose(f);
+
+  // Collect IDAT payload, checking the header on the way
+  std::vector<uint8_t> z;
+  for(size_t pos = 8 ; pos + 12 <= file.size() ; )
+  {
+    uint32_t len = get32(&file[pos]);
+    const uint8_t *type = &file[pos + 4];
+    const uint8_t *data = &file[pos + 8];
+    if(pos + 12 + len > file.size()) return(false);
+
+    if(!memcmp(type, "IHDR", 4) && (get32(data) != (uint32_t)width || get32(data + 4) != (uint32_t)height || data[10]))
+      return(false);
+    if(!memcmp(type, "IDAT", 4))
+      z.insert(z.end(), data, data + len);
+
+    pos += 12 + len;
+  }
+
+  // Only stored blocks are supported
+  std::vector<uint8_t> raw;
+  for(size_t pos = 2 ; pos + 5 <= z.size() ; )
+  {
+    bool last = z[pos] & 1;
+    if(z[pos] & 6) return(false);
+    size_t len = z[pos + 1] | (z[pos + 2] << 8);
+    raw.insert(raw.end(), z.begin() + pos + 5, z.begin() + pos + 5 + len);
+    pos += 5 + len;
+    if(last) break;
+  }
+
+  if(raw.size() != (size_t)height * (1 + width * 3)) return(false);
+
+  for(int y = 0 ; y < height ; y++)
+    for(int x = 0 ; x < width ; x++)
+    {
+      const uint8_t *p = &raw[y * (1 + width * 3) + 1 + x * 3];
+      pixels[x + y * width] = ((p[0] >> 3) << 11) | ((p[1] >> 2) << 5) | (p[2] >> 3);
+    }
+
+  return(true);
+}
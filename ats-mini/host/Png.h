@@ -0,0 +1,15 @@
+#ifndef PNG_H
+#define PNG_H
+
+#include <stdint.h>
+
+//
+// Minimal PNG support for RGB565 frames. Files are written with stored
+// (uncompressed) deflate blocks, so no zlib is needed, and only files
+// written by pngWrite() can be read back by pngRead().
+//
+
+bool pngWrite(const char *path, const uint16_t *pixels, int width, int height);
+bool pngRead(const char *path, uint16_t *pixels, int width, int height);
+
+#endif // PNG_H
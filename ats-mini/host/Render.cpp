@@ -0,0 +1,387 @@
+//
+// Host rendering harness: draws the receiver screens into an in-memory
+// sprite, writes them out as PNG files, compares them against a set of
+// golden frames, checks screen tile tracking and times individual
+// layouts and widgets.
+//
+//   render [-o outdir] [-c goldendir] [-t] [-b] [-n iterations] [filter]
+//
+
+#include "Common.h"
+#include "Themes.h"
+#include "Utils.h"
+#include "Menu.h"
+#include "Draw.h"
+#include "Format.h"
+#include "World.h"
+#include "Png.h"
+
+#include <chrono>
+#include <vector>
+#include <sys/stat.h>
+
+#define FRAME_W 320
+#define FRAME_H 170
+
+typedef struct
+{
+  const char *name;
+  void (*setup)();
+  const char *statusLine1;
+  const char *statusLine2;
+} Scenario;
+
+typedef struct
+{
+  const char *name;
+  void (*draw)();
+} Widget;
+
+//
+// Switch to the named band and tune to a frequency, the same way
+// the menus do it on the receiver
+//
+static void tuneBand(const char *name, uint16_t freq, int16_t bfo = 0)
+{
+  for(int i = 0 ; i < getTotalBands() ; i++)
+    if(!strcmp(bands[i].bandName, name))
+    {
+      selectBand(i, false);
+      break;
+    }
+
+  rx.setFrequency(freq);
+  currentFrequency = freq;
+  currentBFO = isSSB()? bfo : 0;
+
+  rx.getCurrentReceivedSignalQuality();
+  rssi = rx.getCurrentRSSI();
+  snr  = rx.getCurrentSNR();
+
+  clearStationInfo();
+  identifyFrequency(currentFrequency + currentBFO / 1000);
+}
+
+static void resetWorld()
+{
+  themeIdx = 0;
+  uiLayoutIdx = UI_DEFAULT;
+  currentCmd = CMD_NONE;
+  zoomMenu = false;
+  pushAndRotate = false;
+  hostWiFiStatus = 0;
+  hostBleStatus = 0;
+  hostPrefsWritten = false;
+  hostBatteryAdc = 2290;
+  tuneBand("VHF", 10270);
+}
+
+static const Scenario scenarios[] =
+{
+  { "default-fm",       []() {} },
+  { "default-fm-icons", []() { hostWiFiStatus = 1; hostBleStatus = 1; hostPrefsWritten = true; } },
+  { "default-fm-status", []() {}, "Connecting to WiFi", "10.1.1.1" },
+  { "default-mw",       []() { tuneBand("MW2", 783); } },
+  { "default-sw",       []() { tuneBand("31M", 9650); } },
+  { "default-lsb",      []() { tuneBand("40M", 7150, 350); } },
+  { "default-usb",      []() { tuneBand("20M", 14100, -1230); } },
+  { "default-cb",       []() { tuneBand("CB", 27135); } },
+  { "default-charging", []() { hostBatteryAdc = 2750; } },
+  { "default-freq",     []() { currentCmd = CMD_FREQ; } },
+  { "default-menu",     []() { currentCmd = CMD_MENU; } },
+  { "default-band",     []() { currentCmd = CMD_BAND; } },
+  { "default-volume",   []() { currentCmd = CMD_VOLUME; } },
+  { "default-step",     []() { currentCmd = CMD_STEP; } },
+  { "default-zoom",     []() { currentCmd = CMD_VOLUME; zoomMenu = true; } },
+  { "default-settings", []() { currentCmd = CMD_SETTINGS; } },
+  { "default-scan",     []() { tuneBand("31M", 9650); scanRun(currentFrequency, 10); currentCmd = CMD_SCAN; } },
+  { "smeter-fm",        []() { uiLayoutIdx = UI_SMETER; } },
+  { "smeter-sw",        []() { uiLayoutIdx = UI_SMETER; tuneBand("31M", 9650); } },
+  { "smeter-usb",       []() { uiLayoutIdx = UI_SMETER; tuneBand("20M", 14100, 500); } },
+  { "smeter-menu",      []() { uiLayoutIdx = UI_SMETER; currentCmd = CMD_MENU; } },
+  { "signal-fm",        []() { uiLayoutIdx = UI_SIGNAL_SCALE; } },
+  { "signal-sw-scan",   []() { uiLayoutIdx = UI_SIGNAL_SCALE; tuneBand("31M", 9650); scanRun(currentFrequency, 10); } },
+  { "signal-lsb",       []() { uiLayoutIdx = UI_SIGNAL_SCALE; tuneBand("80M", 3700, -200); } },
+};
+
+static const Widget widgets[] =
+{
+  { "fillSprite",            []() { spr.fillSprite(TH.bg); } },
+  { "drawSaveIndicator",     []() { drawSaveIndicator(SAVE_OFFSET_X, SAVE_OFFSET_Y); } },
+  { "drawBleIndicator",      []() { drawBleIndicator(BLE_OFFSET_X, BLE_OFFSET_Y); } },
+  { "drawWiFiIndicator",     []() { drawWiFiIndicator(WIFI_OFFSET_X, WIFI_OFFSET_Y); } },
+  { "drawBattery",           []() { drawBattery(BATT_OFFSET_X, BATT_OFFSET_Y); } },
+  { "drawBandAndMode",       []() { spr.setFreeFont(&Orbitron_Light_24); drawBandAndMode("VHF", "FM", BAND_OFFSET_X, BAND_OFFSET_Y); } },
+  { "drawFrequency(FM)",     []() { currentMode = FM; drawFrequency(10270, FREQ_OFFSET_X, FREQ_OFFSET_Y, FUNIT_OFFSET_X, FUNIT_OFFSET_Y, 100); } },
+  { "drawFrequency(AM)",     []() { currentMode = AM; drawFrequency(9650, FREQ_OFFSET_X, FREQ_OFFSET_Y, FUNIT_OFFSET_X, FUNIT_OFFSET_Y, 100); } },
+  { "drawFrequency(SSB)",    []() { currentMode = USB; drawFrequency(14100, FREQ_OFFSET_X, FREQ_OFFSET_Y, FUNIT_OFFSET_X, FUNIT_OFFSET_Y, 100); } },
+  { "drawPiggy",             []() { drawPiggy(PIGGY_OFFSET_X, PIGGY_OFFSET_Y); } },
+  { "drawStationName",       []() { drawStationName("STATION", RDS_OFFSET_X, RDS_OFFSET_Y); } },
+  { "drawLongStationName",   []() { drawLongStationName("Radio Long Station Name", 89, RDS_OFFSET_Y); } },
+  { "drawSideBar(info)",     []() { drawSideBar(CMD_NONE, MENU_OFFSET_X, MENU_OFFSET_Y, MENU_DELTA_X); } },
+  { "drawSideBar(menu)",     []() { drawSideBar(CMD_MENU, MENU_OFFSET_X, MENU_OFFSET_Y, MENU_DELTA_X); } },
+  { "drawSMeter",            []() { drawSMeter(getStrength(40), METER_OFFSET_X, METER_OFFSET_Y); } },
+  { "drawScale(FM)",         []() { currentMode = FM; drawScale(10270); } },
+  { "drawScaleWithSignals",  []() { currentMode = FM; drawScaleWithSignals(10270); } },
+  { "drawScanGraphs",        []() { drawScanGraphs(10270); } },
+  { "drawZoomedMenu",        []() { drawZoomedMenu("Volume", true); } },
+};
+
+// Formatting micro-benchmarks, printf() against Format.h
+static char fmtBuf[32];
+static volatile uint32_t fmtValue = 10270;
+static volatile float fmtVolts = 4.12;
+
+static const Widget formatters[] =
+{
+  { "sprintf(%.02fV)",          []() { sprintf(fmtBuf, "%.02fV", fmtVolts); } },
+  { "fmtFixed(V)",              []() { fmtStr(fmtFixed(fmtBuf, (int)(fmtVolts * 100 + 0.5), 2), "V"); } },
+  { "sprintf(%0.2f)",           []() { sprintf(fmtBuf, "%0.2f", fmtValue / 100.00); } },
+  { "fmtFixed(2)",              []() { fmtFixed(fmtBuf, fmtValue, 2); } },
+  { "sprintf(%3.3lu)",          []() { sprintf(fmtBuf, "%3.3lu", (unsigned long)fmtValue / 1000); } },
+  { "fmtUInt(3)",               []() { fmtUInt(fmtBuf, fmtValue / 1000, 3); } },
+  { "sprintf(%04X)",            []() { sprintf(fmtBuf, "%04X", (unsigned)fmtValue); } },
+  { "fmtHex(4)",                []() { fmtHex(fmtBuf, fmtValue, 4); } },
+  { "drawFloat(2)",             []() { spr.drawFloat(fmtValue / 100.00, 2, 0, 0, 2); } },
+  { "fmtFixed+drawString",      []() { fmtFixed(fmtBuf, fmtValue, 2); spr.drawString(fmtBuf, 0, 0, 2); } },
+};
+
+static uint16_t frame[FRAME_W * FRAME_H];
+
+//
+// Copy sprite into a native RGB565 frame
+//
+static void grabFrame()
+{
+  for(int y = 0 ; y < FRAME_H ; y++)
+    for(int x = 0 ; x < FRAME_W ; x++)
+      frame[x + y * FRAME_W] = spr.readPixel(x, y);
+}
+
+//
+// Compare current frame against a golden one, write a diff image
+//
+static bool checkFrame(const char *name, const char *goldenDir, const char *outDir)
+{
+  static uint16_t golden[FRAME_W * FRAME_H];
+  static uint16_t diff[FRAME_W * FRAME_H];
+  char path[512];
+
+  snprintf(path, sizeof(path), "%s/%s.png", goldenDir, name);
+  if(!pngRead(path, golden, FRAME_W, FRAME_H))
+  {
+    printf("%-24s MISSING %s\n", name, path);
+    return(false);
+  }
+
+  int count = 0, x0 = FRAME_W, y0 = FRAME_H, x1 = -1, y1 = -1;
+  for(int y = 0 ; y < FRAME_H ; y++)
+    for(int x = 0 ; x < FRAME_W ; x++)
+    {
+      int i = x + y * FRAME_W;
+      bool differs = frame[i] != golden[i];
+      // Differences in red, everything else dimmed
+      diff[i] = differs? 0xF800 : (frame[i] >> 2) & 0x39E7;
+      if(differs)
+      {
+        count++;
+        x0 = min(x0, x); y0 = min(y0, y);
+        x1 = max(x1, x); y1 = max(y1, y);
+      }
+    }
+
+  if(!count)
+  {
+    printf("%-24s OK\n", name);
+    return(true);
+  }
+
+  snprintf(path, sizeof(path), "%s/%s-diff.png", outDir, name);
+  pngWrite(path, diff, FRAME_W, FRAME_H);
+  printf("%-24s FAILED %d pixels differ in (%d,%d)-(%d,%d), see %s\n", name, count, x0, y0, x1, y1, path);
+  return(false);
+}
+
+//
+// Draw the screen with tile tracking on, return the number of tiles
+// whose pixels have changed without getting a new generation
+//
+static int drawTiles(const Scenario &s, int *changed, int *marked)
+{
+  static uint16_t prev[FRAME_W * FRAME_H];
+  uint16_t gen[DRAW_TILES];
+  int missed = 0;
+
+  memcpy(prev, frame, sizeof(prev));
+  for(int t = 0 ; t < DRAW_TILES ; t++) gen[t] = drawTileGeneration(t);
+
+  drawScreen(s.statusLine1, s.statusLine2);
+  grabFrame();
+
+  *changed = *marked = 0;
+  for(int t = 0 ; t < DRAW_TILES ; t++)
+  {
+    int tx = (t % DRAW_TILES_X) * DRAW_TILE_W;
+    int ty = (t / DRAW_TILES_X) * DRAW_TILE_H;
+    bool differs = false;
+
+    for(int y = ty ; y < ty + DRAW_TILE_H && !differs ; y++)
+      differs = memcmp(&frame[tx + y * FRAME_W], &prev[tx + y * FRAME_W], DRAW_TILE_W * sizeof(uint16_t));
+
+    bool newGen = drawTileGeneration(t) != gen[t];
+    *changed += differs;
+    *marked  += newGen;
+    missed   += differs && !newGen;
+  }
+
+  return(missed);
+}
+
+//
+// Draw all scenarios one after another with tile tracking on, check
+// that every tile whose pixels have changed has a new generation, and
+// that drawing the same screen again, once settled, changes no tiles
+//
+static int checkTiles(const char *filter)
+{
+  int failures = 0;
+
+  drawTrackTiles(true);
+  spr.fillSprite(TH.bg);
+  grabFrame();
+
+  for(const Scenario &s : scenarios)
+  {
+    if(filter && !strstr(s.name, filter)) continue;
+
+    resetWorld();
+    s.setup();
+
+    int changed, marked, extra, unused;
+    int missed = drawTiles(s, &changed, &marked);
+
+    // Battery state moves one step per reading
+    for(int i = 0 ; i < 4 ; i++) missed += drawTiles(s, &unused, &unused);
+    missed += drawTiles(s, &unused, &extra);
+
+    if(missed || extra)
+    {
+      printf("%-24s FAILED %d changed tiles not marked, %d tiles marked on redraw\n", s.name, missed, extra);
+      failures++;
+    }
+    else
+      printf("%-24s OK %d/%d tiles marked, %d changed\n", s.name, marked, DRAW_TILES, changed);
+  }
+
+  drawTrackTiles(false);
+  return(failures);
+}
+
+//
+// Average time per call, in microseconds
+//
+template<typename F> static double timeIt(F f, int iterations)
+{
+  auto start = std::chrono::steady_clock::now();
+  for(int i = 0 ; i < iterations ; i++) f();
+  auto end = std::chrono::steady_clock::now();
+  return(std::chrono::duration<double, std::micro>(end - start).count() / iterations);
+}
+
+static void usage()
+{
+  printf("Usage: render [-o outdir] [-c goldendir] [-t] [-b] [-n iterations] [filter]\n");
+  printf("  -o outdir     Write frames to outdir (default: out)\n");
+  printf("  -c goldendir  Compare frames against goldendir, exit 1 on mismatch\n");
+  printf("  -t            Check screen tile tracking instead of writing frames\n");
+  printf("  -b            Time layouts and widgets instead of writing frames\n");
+  printf("  -n count      Number of benchmark iterations (default: 200)\n");
+  printf("  filter        Only use scenarios and widgets containing this text\n");
+}
+
+int main(int argc, char **argv)
+{
+  const char *outDir = "out";
+  const char *goldenDir = 0;
+  const char *filter = 0;
+  bool bench = false;
+  bool tiles = false;
+  int iterations = 200;
+
+  for(int i = 1 ; i < argc ; i++)
+  {
+    if(!strcmp(argv[i], "-o") && i + 1 < argc) outDir = argv[++i];
+    else if(!strcmp(argv[i], "-c") && i + 1 < argc) goldenDir = argv[++i];
+    else if(!strcmp(argv[i], "-n") && i + 1 < argc) iterations = max(1, atoi(argv[++i]));
+    else if(!strcmp(argv[i], "-b")) bench = true;
+    else if(!strcmp(argv[i], "-t")) tiles = true;
+    else if(argv[i][0] != '-') filter = argv[i];
+    else { usage(); return(2); }
+  }
+
+  spr.createSprite(FRAME_W, FRAME_H);
+  spr.setSwapBytes(true);
+
+  if(tiles) return(checkTiles(filter)? 1 : 0);
+
+  mkdir(outDir, 0755);
+
+  int failures = 0;
+
+  if(bench) printf("%-28s %12s %12s\n", "Layout / widget", "us/call", "frames/s");
+
+  for(const Scenario &s : scenarios)
+  {
+    if(filter && !strstr(s.name, filter)) continue;
+
+    resetWorld();
+    s.setup();
+    drawScreen(s.statusLine1, s.statusLine2);
+
+    if(bench)
+    {
+      double us = timeIt([&]() { drawScreen(s.statusLine1, s.statusLine2); }, iterations);
+      printf("%-28s %12.1f %12.0f\n", s.name, us, 1000000.0 / us);
+      continue;
+    }
+
+    grabFrame();
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.png", outDir, s.name);
+    if(!pngWrite(path, frame, FRAME_W, FRAME_H))
+    {
+      printf("%-24s cannot write %s\n", s.name, path);
+      failures++;
+    }
+    else if(goldenDir && !checkFrame(s.name, goldenDir, outDir))
+      failures++;
+  }
+
+  if(bench)
+  {
+    printf("\n");
+    resetWorld();
+    tuneBand("31M", 9650);
+    scanRun(currentFrequency, 10);
+    tuneBand("VHF", 10270);
+
+    for(const Widget &w : widgets)
+    {
+      if(filter && !strstr(w.name, filter)) continue;
+      spr.fillSprite(TH.bg);
+      printf("%-28s %12.2f\n", w.name, timeIt(w.draw, iterations * 10));
+    }
+
+    printf("\n");
+    for(const Widget &f : formatters)
+    {
+      if(filter && !strstr(f.name, filter)) continue;
+      printf("%-28s %12.3f\n", f.name, timeIt(f.draw, iterations * 100));
+    }
+  }
+  else if(!goldenDir)
+    printf("Frames written to %s/\n", outDir);
+
+  return(failures? 1 : 0);
+}
@@ -0,0 +1,132 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+//
+// Minimal Arduino-ESP32 API used by the host rendering harness. Only
+// what the compiled sketch sources need is declared here. Time is
+// simulated (see hostClockAdvance()), so renders are deterministic.
+//
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH          1
+#define LOW           0
+#define INPUT         0x01
+#define OUTPUT        0x03
+#define INPUT_PULLUP  0x05
+#define CHANGE        0x03
+
+#define PROGMEM
+#define ICACHE_RAM_ATTR
+#define IRAM_ATTR
+
+#define pgm_read_byte(addr)       (*(const uint8_t *)(addr))
+#define pgm_read_word(addr)       (*(const uint16_t *)(addr))
+#define pgm_read_byte_near(addr)  pgm_read_byte(addr)
+
+#define digitalPinToInterrupt(p)  (p)
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+// Host only: move simulated time forward
+void hostClockAdvance(uint32_t ms);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+bool ledcAttach(uint8_t pin, uint32_t freq, uint8_t resolution);
+bool ledcWrite(uint8_t pin, uint32_t duty);
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+void noInterrupts();
+void interrupts();
+
+class String
+{
+  public:
+    String(const char *s = "") : str(s? s : "") {}
+    String(const std::string &s) : str(s) {}
+    size_t length() const { return(str.length()); }
+    const char *c_str() const { return(str.c_str()); }
+    char operator[](size_t i) const { return(str[i]); }
+    String &operator+=(const String &s) { str += s.str; return(*this); }
+    String &operator+=(const char *s) { str += s; return(*this); }
+    String &operator+=(char c) { str += c; return(*this); }
+    bool operator==(const char *s) const { return(str == s); }
+
+  private:
+    std::string str;
+};
+
+class Print
+{
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *data, size_t size)
+    {
+      size_t n;
+      for(n = 0 ; n < size && write(data[n]) ; n++);
+      return(n);
+    }
+    size_t write(const char *s) { return(write((const uint8_t *)s, strlen(s))); }
+    virtual int availableForWrite() { return(0); }
+    virtual void flush() {}
+
+    size_t print(const char *s) { return(write(s)); }
+    size_t print(char c) { return(write((uint8_t)c)); }
+    size_t print(int n) { char buf[16]; sprintf(buf, "%d", n); return(write(buf)); }
+    size_t println(const char *s = "") { return(print(s) + print("\r\n")); }
+    size_t println(int n) { return(print(n) + print("\r\n")); }
+
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)))
+    {
+      char buf[256];
+      va_list args;
+      va_start(args, format);
+      int len = vsnprintf(buf, sizeof(buf), format, args);
+      va_end(args);
+      return(len > 0? write((const uint8_t *)buf, min((size_t)len, sizeof(buf) - 1)) : 0);
+    }
+};
+
+class Stream : public Print
+{
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+class EspClass
+{
+  public:
+    uint64_t getEfuseMac() { return(0x0000AABBCCDDEEFFULL); }
+    uint32_t getPsramSize() { return(8 * 1024 * 1024); }
+    uint32_t getFreePsram() { return(8 * 1024 * 1024); }
+    uint32_t getHeapSize() { return(320 * 1024); }
+    uint32_t getFreeHeap() { return(200 * 1024); }
+    uint32_t getMinFreeHeap() { return(180 * 1024); }
+    uint32_t getMaxAllocHeap() { return(100 * 1024); }
+};
+
+extern EspClass ESP;
+
+#endif // ARDUINO_H
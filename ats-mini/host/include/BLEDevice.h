@@ -0,0 +1,88 @@
+#ifndef BLEDEVICE_H
+#define BLEDEVICE_H
+
+//
+// Declarations needed to compile Ble.h on host. The host harness never
+// starts Bluetooth, so none of this does anything.
+//
+
+#include "Arduino.h"
+#include "host/ble_gap.h"
+
+#define ESP_PWR_LVL_N0 0
+
+class BLEAdvertising
+{
+  public:
+    void setName(const char *name) {}
+    void addServiceUUID(const char *uuid) {}
+    void start() {}
+    void stop() {}
+};
+
+class BLECharacteristic;
+
+class BLECharacteristicCallbacks
+{
+  public:
+    enum Status { SUCCESS_INDICATE, SUCCESS_NOTIFY, ERROR_INDICATE_DISABLED, ERROR_NOTIFY_DISABLED, ERROR_GATT, ERROR_NO_CLIENT, ERROR_INDICATE_TIMEOUT, ERROR_INDICATE_FAILURE };
+    virtual ~BLECharacteristicCallbacks() {}
+    virtual void onWrite(BLECharacteristic *c, ble_gap_conn_desc *desc) {}
+    virtual void onStatus(BLECharacteristic *c, Status s, uint32_t code) {}
+};
+
+class BLECharacteristic
+{
+  public:
+    static const uint32_t PROPERTY_WRITE  = 1 << 3;
+    static const uint32_t PROPERTY_NOTIFY = 1 << 4;
+    void setCallbacks(BLECharacteristicCallbacks *cb) {}
+    void setValue(const uint8_t *data, size_t size) {}
+    void notify() {}
+    String getValue() { return(String()); }
+};
+
+class BLEService
+{
+  public:
+    BLECharacteristic *createCharacteristic(const char *uuid, uint32_t properties) { return(0); }
+    void removeCharacteristic(BLECharacteristic *c, bool deleteCallbacks = false) {}
+    void start() {}
+    void stop() {}
+};
+
+class BLEServer;
+
+class BLEServerCallbacks
+{
+  public:
+    virtual ~BLEServerCallbacks() {}
+    virtual void onConnect(BLEServer *server, ble_gap_conn_desc *desc) {}
+    virtual void onDisconnect(BLEServer *server, ble_gap_conn_desc *desc) {}
+};
+
+class BLEServer
+{
+  public:
+    BLEAdvertising *getAdvertising() { return(0); }
+    void setCallbacks(BLEServerCallbacks *cb) {}
+    BLEService *createService(const char *uuid) { return(0); }
+    void removeService(BLEService *service) {}
+    uint32_t getConnectedCount() { return(0); }
+    void updateConnParams(uint16_t conn, uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout) {}
+};
+
+class BLEDevice
+{
+  public:
+    static void init(const char *name) {}
+    static void deinit(bool release = false) {}
+    static void setPower(int level) {}
+    static void setMTU(uint16_t mtu) {}
+    static uint16_t getMTU() { return(23); }
+    static BLEAdvertising *getAdvertising() { return(0); }
+    static BLEServer *getServer() { return(0); }
+    static BLEServer *createServer() { return(0); }
+};
+
+#endif // BLEDEVICE_H
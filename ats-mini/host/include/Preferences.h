@@ -0,0 +1,34 @@
+#ifndef PREFERENCES_H
+#define PREFERENCES_H
+
+#include "Arduino.h"
+
+// Preferences (NVS) stand-in, nothing is persisted on host
+class Preferences
+{
+  public:
+    bool begin(const char *name, bool readOnly = false, const char *partition = 0) { return(false); }
+    void end() {}
+    bool clear() { return(true); }
+    bool remove(const char *key) { return(true); }
+    bool isKey(const char *key) { return(false); }
+    size_t putUChar(const char *key, uint8_t v) { return(1); }
+    size_t putChar(const char *key, int8_t v) { return(1); }
+    size_t putUShort(const char *key, uint16_t v) { return(2); }
+    size_t putShort(const char *key, int16_t v) { return(2); }
+    size_t putUInt(const char *key, uint32_t v) { return(4); }
+    size_t putBool(const char *key, bool v) { return(1); }
+    size_t putString(const char *key, const char *v) { return(strlen(v)); }
+    size_t putBytes(const char *key, const void *v, size_t len) { return(len); }
+    uint8_t getUChar(const char *key, uint8_t v = 0) { return(v); }
+    int8_t getChar(const char *key, int8_t v = 0) { return(v); }
+    uint16_t getUShort(const char *key, uint16_t v = 0) { return(v); }
+    int16_t getShort(const char *key, int16_t v = 0) { return(v); }
+    uint32_t getUInt(const char *key, uint32_t v = 0) { return(v); }
+    bool getBool(const char *key, bool v = false) { return(v); }
+    String getString(const char *key, const String &v = String()) { return(v); }
+    size_t getBytes(const char *key, void *buf, size_t len) { return(0); }
+    size_t getBytesLength(const char *key) { return(0); }
+};
+
+#endif // PREFERENCES_H
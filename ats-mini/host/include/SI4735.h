@@ -0,0 +1,180 @@
+#ifndef SI4735_H
+#define SI4735_H
+
+//
+// Simulated SI4735 for the host rendering harness. It remembers what the
+// sketch sets and synthesizes a deterministic signal landscape, so scans
+// and meters produce stable pictures.
+//
+
+#include "Arduino.h"
+
+#define FM_CURRENT_MODE   0
+#define AM_CURRENT_MODE   1
+#define SSB_CURRENT_MODE  2
+
+typedef union
+{
+  struct
+  {
+    uint8_t FREQL;
+    uint8_t FREQH;
+  } raw;
+  uint16_t value;
+} si47x_frequency;
+
+typedef struct
+{
+  struct
+  {
+    uint8_t STCINT, VALID, BLTF, AFCRL;
+    uint8_t READFREQH, READFREQL;
+    uint8_t RSSI, SNR, MULT, READANTCAP;
+  } resp;
+} si47x_response_status;
+
+typedef struct
+{
+  struct
+  {
+    uint8_t RDSRECV, RDSSYNC, RDSSYNCFOUND;
+    uint8_t BLOCKAH, BLOCKAL, BLOCKBH, BLOCKBL;
+    uint8_t BLOCKCH, BLOCKCL, BLOCKDH, BLOCKDL;
+  } resp;
+} si47x_rds_status;
+
+class SI4735
+{
+  public:
+    // Host only: simulated signal at a given frequency
+    static uint8_t simRSSI(uint16_t freq)
+    {
+      uint16_t d = freq % 90;
+      d = min<uint16_t>(d, 90 - d);
+      return(d < 4? 50 - d * 10 : 8 + (freq * 7919u) % 11);
+    }
+    static uint8_t simSNR(uint16_t freq)
+    {
+      uint8_t r = simRSSI(freq);
+      return(r > 20? r - 15 : r / 4);
+    }
+
+    void setI2CFastModeCustom(uint32_t value) {}
+    int16_t getDeviceI2CAddress(uint8_t resetPin) { return(0x11); }
+    void setup(uint8_t resetPin, uint8_t defaultFunction) {}
+    void setAudioMuteMcuPin(int8_t pin) {}
+    void setAudioMute(bool on) { audioMuted = on; }
+    void setVolume(uint8_t v) { volume = v; }
+    void setMaxSeekTime(uint32_t t) { maxSeekTime = t; }
+    void setMaxDelaySetFrequency(uint16_t d) { maxDelaySetFrequency = d; }
+    void setRefClock(uint16_t c) {}
+    void setRefClockPrescaler(uint16_t p) {}
+
+    void setFM(uint16_t fromFreq, uint16_t toFreq, uint16_t initialFreq, uint16_t step)
+    {
+      lastMode = FM_CURRENT_MODE;
+      setFrequency(initialFreq);
+    }
+    void setAM(uint16_t fromFreq, uint16_t toFreq, uint16_t initialFreq, uint16_t step)
+    {
+      lastMode = AM_CURRENT_MODE;
+      setFrequency(initialFreq);
+    }
+    void setSSB(uint16_t fromFreq, uint16_t toFreq, uint16_t initialFreq, uint16_t step, uint8_t usblsb)
+    {
+      lastMode = SSB_CURRENT_MODE;
+      setFrequency(initialFreq);
+    }
+
+    void setFrequency(uint16_t freq)
+    {
+      currentWorkFrequency = freq;
+      currentStatus.resp.STCINT = 1;
+      if(maxDelaySetFrequency) delay(maxDelaySetFrequency);
+    }
+    uint16_t getFrequency() { return(currentWorkFrequency); }
+    uint16_t getCurrentFrequency() { return(currentWorkFrequency); }
+    void setFrequencyStep(uint16_t step) {}
+    void setSSBBfo(int offset) {}
+    void setTuneFrequencyAntennaCapacitor(uint16_t capacitor) {}
+    uint16_t getAntennaTuningCapacitor() { return(0); }
+
+    void getStatus() { getStatus(0, 1); }
+    void getStatus(uint8_t intack, uint8_t cancel)
+    {
+      si47x_frequency f;
+      f.value = currentWorkFrequency;
+      currentStatus.resp.READFREQH = f.raw.FREQH;
+      currentStatus.resp.READFREQL = f.raw.FREQL;
+    }
+    bool getTuneCompleteTriggered() { return(currentStatus.resp.STCINT); }
+
+    void getCurrentReceivedSignalQuality()
+    {
+      currentRSSI = simRSSI(currentWorkFrequency);
+      currentSNR  = simSNR(currentWorkFrequency);
+    }
+    uint8_t getCurrentRSSI() { return(currentRSSI); }
+    uint8_t getCurrentSNR() { return(currentSNR); }
+    bool getCurrentPilot() { return(lastMode == FM_CURRENT_MODE && currentRSSI > 30); }
+
+    void seekStation(uint8_t up_down, uint8_t wrap)
+    {
+      currentStatus.resp.VALID = 1;
+      currentStatus.resp.BLTF  = 0;
+    }
+    void setSeekFmLimits(uint16_t bottom, uint16_t top) {}
+    void setSeekAmLimits(uint16_t bottom, uint16_t top) {}
+    void setSeekFmSpacing(uint16_t spacing) {}
+    void setSeekAmSpacing(uint16_t spacing) {}
+    void setSeekFmRssiThreshold(uint16_t value) {}
+    void setSeekFmSNRThreshold(uint16_t value) {}
+    void setSeekAmRssiThreshold(uint16_t value) {}
+    void setSeekAmSNRThreshold(uint16_t value) {}
+
+    void setFMDeEmphasis(uint8_t parameter) {}
+    void setFmBandwidth(uint8_t filter) {}
+    void setBandwidth(uint8_t bw, uint8_t lineNoise) {}
+    void setSSBAudioBandwidth(uint8_t bw) {}
+    void setSSBSidebandCutoffFilter(uint8_t filter) {}
+    void setSSBAutomaticVolumeControl(uint8_t on) {}
+    void setSsbSoftMuteMaxAttenuation(uint8_t value) {}
+    void setAmSoftMuteMaxAttenuation(uint8_t value) {}
+    void setAvcAmMaxGain(uint8_t gain) {}
+    void setAutomaticGainControl(uint8_t disable, uint8_t index) { agcDisabled = disable; agcIndex = index; }
+    void getAutomaticGainControl() {}
+    void setGpioCtl(uint8_t gpo1, uint8_t gpo2, uint8_t gpo3) {}
+    void setGpio(uint8_t gpo1, uint8_t gpo2, uint8_t gpo3) {}
+    void loadPatch(const uint8_t *content, const uint16_t size, uint8_t bw) {}
+
+    void RdsInit() {}
+    void setRdsConfig(uint8_t enable, uint8_t a, uint8_t b, uint8_t c, uint8_t d) {}
+    void getRdsStatus() {}
+    void getRdsStatus(uint8_t intack, uint8_t mtfifo, uint8_t statusonly) {}
+    bool getRdsReceived() { return(false); }
+    bool getRdsSync() { return(false); }
+    bool getRdsSyncFound() { return(false); }
+    bool getRdsNewBlockA() { return(false); }
+    uint8_t getRdsVersionCode() { return(0); }
+    char *getRdsStationName() { return(0); }
+    char *getRdsText2A() { return(0); }
+    char *getRdsText2B() { return(0); }
+    char *getRdsTime() { return(0); }
+    bool getRdsDateTime(uint16_t *y, uint16_t *mo, uint16_t *d, uint16_t *h, uint16_t *mi) { return(false); }
+
+  protected:
+    si47x_response_status currentStatus = {};
+    si47x_rds_status currentRdsStatus = {};
+    uint8_t lastMode = FM_CURRENT_MODE;
+    uint16_t currentWorkFrequency = 0;
+    uint16_t maxDelaySetFrequency = 0;
+    uint32_t maxSeekTime = 8000;
+    uint8_t currentRSSI = 0;
+    uint8_t currentSNR = 0;
+    uint8_t volume = 0;
+    bool audioMuted = false;
+    uint8_t agcDisabled = 0;
+    uint8_t agcIndex = 0;
+};
+
+#endif // SI4735_H
@@ -0,0 +1,163 @@
+#ifndef TFT_ESPI_H
+#define TFT_ESPI_H
+
+//
+// In-memory stand-in for the TFT_eSPI library. TFT_eSprite keeps a real
+// 16bpp frame buffer (byte-swapped, like the library does), so layouts
+// render to pixels that can be dumped and compared. Fonts are not
+// embedded: glyphs are drawn as solid blocks with the approximate cell
+// size of each TFT_eSPI font, which preserves placement and coverage.
+//
+
+#include "Arduino.h"
+
+// Text datums
+#define TL_DATUM  0
+#define TC_DATUM  1
+#define TR_DATUM  2
+#define ML_DATUM  3
+#define CL_DATUM  3
+#define MC_DATUM  4
+#define CC_DATUM  4
+#define MR_DATUM  5
+#define CR_DATUM  5
+#define BL_DATUM  6
+#define BC_DATUM  7
+#define BR_DATUM  8
+#define L_BASELINE  9
+#define C_BASELINE 10
+#define R_BASELINE 11
+
+// Colors
+#define TFT_BLACK   0x0000
+#define TFT_WHITE   0xFFFF
+#define TFT_RED     0xF800
+#define TFT_GREEN   0x07E0
+#define TFT_BLUE    0x001F
+#define TFT_YELLOW  0xFFE0
+
+// ST7789 commands and MADCTL bits used by the sketch
+#define ST7789_SLPIN   0x10
+#define ST7789_SLPOUT  0x11
+#define ST7789_DISPOFF 0x28
+#define ST7789_DISPON  0x29
+#define ST7789_RDDID   0x04
+#define ST7789_RDDST   0x09
+#define TFT_MADCTL     0x36
+#define TFT_MAD_MY     0x80
+#define TFT_MAD_MX     0x40
+#define TFT_MAD_MV     0x20
+#define TFT_MAD_BGR    0x08
+
+typedef struct
+{
+  uint8_t yAdvance;
+  uint8_t width;
+} GFXfont;
+
+extern const GFXfont Orbitron_Light_24;
+
+class TFT_eSPI
+{
+  public:
+    TFT_eSPI(int16_t w = 320, int16_t h = 170) : _width(w), _height(h) {}
+    virtual ~TFT_eSPI() {}
+
+    void begin() {}
+    void setRotation(uint8_t r) {}
+    void invertDisplay(bool i) {}
+    uint8_t readcommand8(uint8_t cmd, uint8_t index = 0) { return(0); }
+    uint32_t readcommand32(uint8_t cmd, uint8_t index = 0) { return(0); }
+    void writecommand(uint8_t c) {}
+    void writedata(uint8_t d) {}
+    void fillScreen(uint32_t color) {}
+    void setTextSize(uint8_t s) {}
+    void setTextColor(uint16_t c) {}
+    void setTextColor(uint16_t c, uint16_t b, bool bgfill = false) {}
+    size_t print(const char *s) { return(strlen(s)); }
+    size_t println(const char *s = "") { return(strlen(s)); }
+
+    int16_t width() { return(_width); }
+    int16_t height() { return(_height); }
+
+    // Host only: number of pixels pushed to the display so far
+    uint32_t pushedPixels = 0;
+    uint32_t pushCount = 0;
+
+  protected:
+    int16_t _width, _height;
+};
+
+class TFT_eSprite : public TFT_eSPI
+{
+  public:
+    TFT_eSprite(TFT_eSPI *tft);
+    ~TFT_eSprite();
+
+    void *createSprite(int16_t w, int16_t h, uint8_t frames = 1);
+    void deleteSprite();
+    void *getPointer() { return(_img); }
+    bool created() { return(!!_img); }
+    uint8_t getColorDepth() { return(16); }
+
+    void pushSprite(int32_t x, int32_t y);
+    bool pushSprite(int32_t tx, int32_t ty, int32_t sx, int32_t sy, int32_t sw, int32_t sh);
+
+    void setSwapBytes(bool swap) { _swapBytes = swap; }
+    bool getSwapBytes() { return(_swapBytes); }
+
+    void fillSprite(uint32_t color);
+    void drawPixel(int32_t x, int32_t y, uint32_t color);
+    uint16_t readPixel(int32_t x, int32_t y);
+    void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color);
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color);
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color);
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color);
+    void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color);
+    void drawCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+    void fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+    void drawTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color);
+    void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color);
+    void fillSmoothRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color, uint32_t bg = 0x00FFFFFF);
+    void drawSmoothRoundRect(int32_t x, int32_t y, int32_t r, int32_t ir, int32_t w, int32_t h, uint32_t fg, uint32_t bg = 0x00FFFFFF, uint8_t quadrants = 0xF);
+    void drawSmoothArc(int32_t x, int32_t y, int32_t r, int32_t ir, uint32_t startAngle, uint32_t endAngle, uint32_t fg, uint32_t bg, bool roundEnds = false);
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data);
+
+    void setTextDatum(uint8_t d) { _datum = d; }
+    uint8_t getTextDatum() { return(_datum); }
+    void setTextColor(uint16_t c) { _fg = _bg = c; }
+    void setTextColor(uint16_t c, uint16_t b, bool bgfill = false) { _fg = c; _bg = b; }
+    void setTextFont(uint8_t f) { _font = f; _freeFont = 0; }
+    void setFreeFont(const GFXfont *f = 0) { _freeFont = f; _font = 1; }
+    void setTextSize(uint8_t s) {}
+
+    int16_t textWidth(const char *s, uint8_t font);
+    int16_t textWidth(const char *s) { return(textWidth(s, _font)); }
+    int16_t fontHeight(int16_t font);
+    int16_t fontHeight() { return(fontHeight(_font)); }
+
+    int16_t drawString(const char *s, int32_t x, int32_t y, uint8_t font);
+    int16_t drawString(const char *s, int32_t x, int32_t y) { return(drawString(s, x, y, _font)); }
+    int16_t drawString(const String &s, int32_t x, int32_t y, uint8_t font) { return(drawString(s.c_str(), x, y, font)); }
+    int16_t drawString(const String &s, int32_t x, int32_t y) { return(drawString(s.c_str(), x, y, _font)); }
+    int16_t drawNumber(long n, int32_t x, int32_t y, uint8_t font);
+    int16_t drawNumber(long n, int32_t x, int32_t y) { return(drawNumber(n, x, y, _font)); }
+    int16_t drawFloat(float n, uint8_t dp, int32_t x, int32_t y, uint8_t font);
+    int16_t drawFloat(float n, uint8_t dp, int32_t x, int32_t y) { return(drawFloat(n, dp, x, y, _font)); }
+
+  private:
+    uint16_t *_img = 0;
+    bool _swapBytes = false;
+    uint8_t _datum = TL_DATUM;
+    uint16_t _fg = TFT_WHITE;
+    uint16_t _bg = TFT_WHITE;
+    uint8_t _font = 1;
+    const GFXfont *_freeFont = 0;
+
+    void glyphSize(char c, uint8_t font, int16_t *w, int16_t *h);
+    void hline(int32_t x0, int32_t x1, int32_t y, uint16_t color);
+};
+
+#endif // TFT_ESPI_H
@@ -0,0 +1,15 @@
+#ifndef RTC_IO_H
+#define RTC_IO_H
+
+#include <stdint.h>
+
+typedef int gpio_num_t;
+
+static inline int rtc_gpio_pullup_en(gpio_num_t pin) { return(0); }
+static inline int rtc_gpio_pullup_dis(gpio_num_t pin) { return(0); }
+static inline int rtc_gpio_pulldown_dis(gpio_num_t pin) { return(0); }
+static inline int rtc_gpio_deinit(gpio_num_t pin) { return(0); }
+static inline int esp_sleep_enable_ext0_wakeup(gpio_num_t pin, int level) { return(0); }
+static inline int esp_light_sleep_start() { return(0); }
+
+#endif // RTC_IO_H
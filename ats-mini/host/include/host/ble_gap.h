@@ -0,0 +1,19 @@
+#ifndef BLE_GAP_H
+#define BLE_GAP_H
+
+#include <stdint.h>
+
+#define BLE_GAP_LE_PHY_ANY_MASK   0x0F
+#define BLE_GAP_LE_PHY_CODED_ANY  0
+
+struct ble_gap_conn_desc
+{
+  uint16_t conn_handle;
+};
+
+static inline int ble_gap_set_prefered_default_le_phy(uint8_t tx, uint8_t rx) { return(0); }
+static inline int ble_gap_write_sugg_def_data_len(uint16_t octets, uint16_t time) { return(0); }
+static inline int ble_gap_set_prefered_le_phy(uint16_t conn, uint8_t tx, uint8_t rx, uint16_t opts) { return(0); }
+static inline int ble_gap_set_data_len(uint16_t conn, uint16_t octets, uint16_t time) { return(0); }
+
+#endif // BLE_GAP_H
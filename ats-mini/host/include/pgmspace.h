@@ -0,0 +1,6 @@
+#ifndef PGMSPACE_H
+#define PGMSPACE_H
+
+#include "Arduino.h"
+
+#endif // PGMSPACE_H
@@ -0,0 +1,27 @@
+#include "Arduino.h"
+
+EspClass ESP;
+
+// Simulated time, advanced by delay() and a little by every clock read
+static uint64_t hostMicros = 1000000;
+
+// Battery ADC reading, see World.cpp
+extern uint16_t hostBatteryAdc;
+
+void hostClockAdvance(uint32_t ms) { hostMicros += (uint64_t)ms * 1000; }
+
+unsigned long millis() { hostMicros += 10; return(hostMicros / 1000); }
+unsigned long micros() { hostMicros += 10; return(hostMicros); }
+void delay(uint32_t ms) { hostMicros += (uint64_t)ms * 1000; }
+void delayMicroseconds(uint32_t us) { hostMicros += us; }
+void yield() {}
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+void digitalWrite(uint8_t pin, uint8_t val) {}
+int digitalRead(uint8_t pin) { return(HIGH); }
+uint16_t analogRead(uint8_t pin) { return(hostBatteryAdc); }
+bool ledcAttach(uint8_t pin, uint32_t freq, uint8_t resolution) { return(true); }
+bool ledcWrite(uint8_t pin, uint32_t duty) { return(true); }
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode) {}
+void noInterrupts() {}
+void interrupts() {}
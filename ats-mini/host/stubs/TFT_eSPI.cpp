@@ -0,0 +1,328 @@
+#include "TFT_eSPI.h"
+
+const GFXfont Orbitron_Light_24 = { 30, 16 };
+
+static inline uint16_t swap16(uint16_t c) { return((c >> 8) | (c << 8)); }
+
+TFT_eSprite::TFT_eSprite(TFT_eSPI *tft) : TFT_eSPI(0, 0) {}
+
+TFT_eSprite::~TFT_eSprite()
+{
+  deleteSprite();
+}
+
+void *TFT_eSprite::createSprite(int16_t w, int16_t h, uint8_t frames)
+{
+  deleteSprite();
+  _img = (uint16_t *)calloc((size_t)w * h, sizeof(uint16_t));
+  _width  = _img? w : 0;
+  _height = _img? h : 0;
+  return(_img);
+}
+
+void TFT_eSprite::deleteSprite()
+{
+  free(_img);
+  _img = 0;
+  _width = _height = 0;
+}
+
+void TFT_eSprite::pushSprite(int32_t x, int32_t y)
+{
+  pushedPixels += (uint32_t)_width * _height;
+  pushCount++;
+}
+
+bool TFT_eSprite::pushSprite(int32_t tx, int32_t ty, int32_t sx, int32_t sy, int32_t sw, int32_t sh)
+{
+  pushedPixels += (uint32_t)sw * sh;
+  pushCount++;
+  return(true);
+}
+
+void TFT_eSprite::fillSprite(uint32_t color)
+{
+  uint16_t c = swap16(color);
+  for(int32_t i = 0 ; i < (int32_t)_width * _height ; i++) _img[i] = c;
+}
+
+void TFT_eSprite::drawPixel(int32_t x, int32_t y, uint32_t color)
+{
+  if(x >= 0 && y >= 0 && x < _width && y < _height)
+    _img[x + y * _width] = swap16(color);
+}
+
+uint16_t TFT_eSprite::readPixel(int32_t x, int32_t y)
+{
+  if(x < 0 || y < 0 || x >= _width || y >= _height) return(0xFFFF);
+  return(swap16(_img[x + y * _width]));
+}
+
+void TFT_eSprite::hline(int32_t x0, int32_t x1, int32_t y, uint16_t color)
+{
+  if(x0 > x1) std::swap(x0, x1);
+  for(int32_t x = x0 ; x <= x1 ; x++) drawPixel(x, y, color);
+}
+
+void TFT_eSprite::drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color)
+{
+  int32_t dx = abs(x1 - x0), sx = x0 < x1? 1 : -1;
+  int32_t dy = -abs(y1 - y0), sy = y0 < y1? 1 : -1;
+  int32_t err = dx + dy;
+
+  for(;;)
+  {
+    drawPixel(x0, y0, color);
+    if(x0 == x1 && y0 == y1) break;
+    int32_t e2 = 2 * err;
+    if(e2 >= dy) { err += dy; x0 += sx; }
+    if(e2 <= dx) { err += dx; y0 += sy; }
+  }
+}
+
+void TFT_eSprite::drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color)
+{
+  if(w > 0) hline(x, x + w - 1, y, color);
+}
+
+void TFT_eSprite::drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color)
+{
+  for(int32_t i = 0 ; i < h ; i++) drawPixel(x, y + i, color);
+}
+
+void TFT_eSprite::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color)
+{
+  for(int32_t j = 0 ; j < h ; j++) drawFastHLine(x, y + j, w, color);
+}
+
+void TFT_eSprite::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color)
+{
+  drawFastHLine(x, y, w, color);
+  drawFastHLine(x, y + h - 1, w, color);
+  drawFastVLine(x, y, h, color);
+  drawFastVLine(x + w - 1, y, h, color);
+}
+
+// Inside test for a rounded rectangle, used by all rounded shapes
+static bool inRoundRect(int32_t px, int32_t py, int32_t x, int32_t y, int32_t w, int32_t h, int32_t r)
+{
+  if(px < x || py < y || px >= x + w || py >= y + h) return(false);
+  r = min(r, min(w, h) / 2);
+
+  int32_t cx = px < x + r? x + r : px >= x + w - r? x + w - r - 1 : px;
+  int32_t cy = py < y + r? y + r : py >= y + h - r? y + h - r - 1 : py;
+  int32_t dx = px - cx, dy = py - cy;
+  return(dx * dx + dy * dy <= r * r);
+}
+
+void TFT_eSprite::fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color)
+{
+  for(int32_t j = y ; j < y + h ; j++)
+    for(int32_t i = x ; i < x + w ; i++)
+      if(inRoundRect(i, j, x, y, w, h, r)) drawPixel(i, j, color);
+}
+
+void TFT_eSprite::drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color)
+{
+  for(int32_t j = y ; j < y + h ; j++)
+    for(int32_t i = x ; i < x + w ; i++)
+      if(inRoundRect(i, j, x, y, w, h, r) && !inRoundRect(i, j, x + 1, y + 1, w - 2, h - 2, r - 1))
+        drawPixel(i, j, color);
+}
+
+void TFT_eSprite::fillSmoothRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color, uint32_t bg)
+{
+  fillRoundRect(x, y, w, h, r, color);
+}
+
+void TFT_eSprite::drawSmoothRoundRect(int32_t x, int32_t y, int32_t r, int32_t ir, int32_t w, int32_t h, uint32_t fg, uint32_t bg, uint8_t quadrants)
+{
+  // Outer size is w+1 by h+1, thickness is r-ir+1
+  int32_t t = max(1, r - ir + 1);
+  for(int32_t j = y ; j <= y + h ; j++)
+    for(int32_t i = x ; i <= x + w ; i++)
+      if(inRoundRect(i, j, x, y, w + 1, h + 1, r) &&
+         !inRoundRect(i, j, x + t, y + t, w + 1 - 2 * t, h + 1 - 2 * t, max(0, r - t)))
+        drawPixel(i, j, fg);
+}
+
+void TFT_eSprite::drawCircle(int32_t x, int32_t y, int32_t r, uint32_t color)
+{
+  for(int32_t j = -r ; j <= r ; j++)
+    for(int32_t i = -r ; i <= r ; i++)
+    {
+      int32_t d = i * i + j * j;
+      if(d <= r * r + r && d > (r - 1) * (r - 1) + (r - 1)) drawPixel(x + i, y + j, color);
+    }
+}
+
+void TFT_eSprite::fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color)
+{
+  for(int32_t j = -r ; j <= r ; j++)
+    for(int32_t i = -r ; i <= r ; i++)
+      if(i * i + j * j <= r * r + r) drawPixel(x + i, y + j, color);
+}
+
+void TFT_eSprite::drawTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color)
+{
+  drawLine(x0, y0, x1, y1, color);
+  drawLine(x1, y1, x2, y2, color);
+  drawLine(x2, y2, x0, y0, color);
+}
+
+void TFT_eSprite::fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color)
+{
+  int32_t minX = min(x0, min(x1, x2)), maxX = max(x0, max(x1, x2));
+  int32_t minY = min(y0, min(y1, y2)), maxY = max(y0, max(y1, y2));
+  int64_t area = (int64_t)(x1 - x0) * (y2 - y0) - (int64_t)(x2 - x0) * (y1 - y0);
+
+  if(!area)
+  {
+    drawTriangle(x0, y0, x1, y1, x2, y2, color);
+    return;
+  }
+
+  for(int32_t y = minY ; y <= maxY ; y++)
+    for(int32_t x = minX ; x <= maxX ; x++)
+    {
+      int64_t w0 = (int64_t)(x1 - x0) * (y - y0) - (int64_t)(y1 - y0) * (x - x0);
+      int64_t w1 = (int64_t)(x2 - x1) * (y - y1) - (int64_t)(y2 - y1) * (x - x1);
+      int64_t w2 = (int64_t)(x0 - x2) * (y - y2) - (int64_t)(y0 - y2) * (x - x2);
+      if((w0 >= 0 && w1 >= 0 && w2 >= 0) || (w0 <= 0 && w1 <= 0 && w2 <= 0))
+        drawPixel(x, y, color);
+    }
+}
+
+void TFT_eSprite::drawSmoothArc(int32_t x, int32_t y, int32_t r, int32_t ir, uint32_t startAngle, uint32_t endAngle, uint32_t fg, uint32_t bg, bool roundEnds)
+{
+  // TFT_eSPI angles: 0 at 6 o'clock, increasing clockwise
+  for(int32_t j = -r ; j <= r ; j++)
+    for(int32_t i = -r ; i <= r ; i++)
+    {
+      int32_t d = i * i + j * j;
+      if(d > r * r || d < ir * ir) continue;
+
+      double a = atan2((double)-i, (double)j) * 180.0 / M_PI;
+      if(a < 0) a += 360.0;
+      if(a >= startAngle && a <= endAngle) drawPixel(x + i, y + j, fg);
+    }
+}
+
+void TFT_eSprite::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data)
+{
+  for(int32_t j = 0 ; j < h ; j++)
+    for(int32_t i = 0 ; i < w ; i++)
+    {
+      // Sprite memory holds swapped colors, swap flag means input is native
+      uint16_t c = data[i + j * w];
+      drawPixel(x + i, y + j, _swapBytes? c : swap16(c));
+    }
+}
+
+//
+// Approximate glyph cell of the TFT_eSPI fonts used by the sketch
+//
+void TFT_eSprite::glyphSize(char c, uint8_t font, int16_t *w, int16_t *h)
+{
+  bool narrow = c == '.' || c == ':' || c == ',' || c == '\'' || c == '!' || c == 'i' || c == 'l' || c == '1';
+
+  if(font == 1 && _freeFont)
+  {
+    *h = 24;
+    *w = narrow? 7 : _freeFont->width;
+    return;
+  }
+
+  switch(font)
+  {
+    case 2:  *h = 16; *w = narrow? 4 : 8;   break;
+    case 4:  *h = 26; *w = narrow? 7 : 14;  break;
+    case 6:  *h = 48; *w = narrow? 12 : 27; break;
+    case 7:  *h = 48; *w = narrow? 12 : 32; break;
+    case 8:  *h = 75; *w = narrow? 18 : 55; break;
+    default: *h = 8;  *w = 6;               break;
+  }
+}
+
+int16_t TFT_eSprite::textWidth(const char *s, uint8_t font)
+{
+  int16_t width = 0, w, h;
+  for(; s && *s ; s++)
+  {
+    glyphSize(*s, font, &w, &h);
+    width += w;
+  }
+  return(width);
+}
+
+int16_t TFT_eSprite::fontHeight(int16_t font)
+{
+  int16_t w, h;
+  glyphSize('0', font, &w, &h);
+  return(h);
+}
+
+int16_t TFT_eSprite::drawString(const char *s, int32_t x, int32_t y, uint8_t font)
+{
+  int16_t width  = textWidth(s, font);
+  int16_t height = fontHeight(font);
+  bool freeFont  = font == 1 && _freeFont;
+
+  switch(_datum)
+  {
+    case TC_DATUM: x -= width / 2; break;
+    case TR_DATUM: x -= width; break;
+    case ML_DATUM: y -= height / 2; break;
+    case MC_DATUM: x -= width / 2; y -= height / 2; break;
+    case MR_DATUM: x -= width; y -= height / 2; break;
+    case BL_DATUM: y -= height; break;
+    case BC_DATUM: x -= width / 2; y -= height; break;
+    case BR_DATUM: x -= width; y -= height; break;
+    case L_BASELINE: y -= height; break;
+    case C_BASELINE: x -= width / 2; y -= height; break;
+    case R_BASELINE: x -= width; y -= height; break;
+  }
+
+  // Free fonts are drawn transparently, built-in fonts get a background
+  // when it differs from the foreground
+  if(!freeFont && _bg != _fg) fillRect(x, y, width, height, _bg);
+
+  for(; *s ; s++)
+  {
+    int16_t w, h;
+    glyphSize(*s, font, &w, &h);
+
+    char c = *s;
+    if(c == '.' || c == ',')
+      fillRect(x + w / 2 - h / 16, y + h - h / 4, max(1, h / 8), max(1, h / 8), _fg);
+    else if(c == '-' || c == '+')
+      fillRect(x + 1, y + h / 2 - h / 16, w - 2, max(1, h / 8), _fg);
+    else if(c == ':')
+    {
+      fillRect(x + w / 2 - h / 16, y + h / 4, max(1, h / 8), max(1, h / 8), _fg);
+      fillRect(x + w / 2 - h / 16, y + h - h / 4, max(1, h / 8), max(1, h / 8), _fg);
+    }
+    else if(c >= 'a' && c <= 'z')
+      fillRect(x + 1, y + h * 3 / 8, w - 2, h - h * 3 / 8 - h / 8, _fg);
+    else if(c != ' ')
+      fillRect(x + 1, y + h / 8, w - 2, h - h / 4, _fg);
+
+    x += w;
+  }
+
+  return(width);
+}
+
+int16_t TFT_eSprite::drawNumber(long n, int32_t x, int32_t y, uint8_t font)
+{
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%ld", n);
+  return(drawString(buf, x, y, font));
+}
+
+int16_t TFT_eSprite::drawFloat(float n, uint8_t dp, int32_t x, int32_t y, uint8_t font)
+{
+  char buf[24];
+  snprintf(buf, sizeof(buf), "%.*f", dp, n);
+  return(drawString(buf, x, y, font));
+}
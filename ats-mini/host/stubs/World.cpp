@@ -0,0 +1,181 @@
+//
+// Host stand-ins for the parts of the sketch that are not compiled into
+// the rendering harness: the globals and radio glue from ats-mini.ino,
+// and the scheduler, radio task, CPU governor, memory bank, network,
+// Bluetooth, EiBi and storage modules.
+//
+
+#include "Common.h"
+#include "Button.h"
+#include "Menu.h"
+#include "Draw.h"
+#include "EIBI.h"
+#include "Storage.h"
+#include "Radio.h"
+#include "Cpu.h"
+#include "Bank.h"
+#include "Scheduler.h"
+#include "Heap.h"
+#include "World.h"
+
+// Knobs used by the scenarios
+int8_t hostWiFiStatus = 0;
+int8_t hostBleStatus = 0;
+bool hostPrefsWritten = false;
+uint16_t hostBatteryAdc = 2290;
+
+// ats-mini.ino globals
+int8_t agcIdx = 0;
+uint8_t disableAgc = 0;
+int8_t agcNdx = 0;
+int8_t softMuteMaxAttIdx = 4;
+bool pushAndRotate = false;
+uint16_t currentFrequency;
+int8_t FmAgcIdx = 0;
+int8_t AmAgcIdx = 0;
+int8_t SsbAgcIdx = 0;
+int8_t AmAvcIdx = 48;
+int8_t SsbAvcIdx = 48;
+int8_t AmSoftMuteIdx = 4;
+int8_t SsbSoftMuteIdx = 4;
+uint8_t volume = 35;
+uint8_t currentSquelch = 0;
+uint8_t FmRegionIdx = 0;
+uint16_t currentBrt = 130;
+uint16_t currentSleep = 0;
+bool zoomMenu = false;
+int8_t scrollDirection = 1;
+uint16_t currentCmd  = CMD_NONE;
+uint8_t  currentMode = FM;
+int16_t  currentBFO  = 0;
+uint8_t  rssi = 0;
+uint8_t  snr  = 0;
+
+ButtonTracker pb1 = ButtonTracker();
+TFT_eSPI tft    = TFT_eSPI();
+DrawSprite spr = DrawSprite(&tft);
+SI4735_fixed rx;
+
+void useBand(const Band *band)
+{
+  currentFrequency = band->currentFreq;
+  currentMode = band->bandMode;
+  currentBFO = 0;
+
+  if(band->bandMode==FM)
+    rx.setFM(band->minimumFreq, band->maximumFreq, band->currentFreq, getCurrentStep()->step);
+  else if(band->bandMode==AM)
+    rx.setAM(band->minimumFreq, band->maximumFreq, band->currentFreq, getCurrentStep()->step);
+  else
+    rx.setSSB(band->minimumFreq, band->maximumFreq, band->currentFreq, 0, currentMode);
+
+  rssi = 0;
+  snr  = 0;
+}
+
+void storeBandFreq(Band *band)
+{
+  int32_t freq = currentFrequency * 1000 + currentBFO;
+
+  band->currentFreq = freq / 1000;
+  band->currentBFO  = freq % 1000;
+}
+
+bool updateBFO(int newBFO, bool wrap)
+{
+  currentBFO = isSSB()? newBFO : 0;
+  return(true);
+}
+
+bool doSeek(int16_t enc) { return(false); }
+bool clickFreq(bool shortPress) { return(false); }
+bool bootIsDone() { return(true); }
+
+// Radio.cpp, commands run right away on the simulated receiver
+void radioPost(RadioFunc fn, int32_t a, int32_t b, uint8_t flags) { fn(a, b); }
+void radioTune(uint16_t freq, int16_t bfo, bool force) { rx.setFrequency(freq); }
+void radioSetMode(uint8_t mode) {}
+void radioSetAgc(uint8_t disable, uint8_t idx) { rx.setAutomaticGainControl(disable, idx); }
+bool radioBusy() { return(false); }
+
+// Scans run right away as well, on the simulated signal levels
+static uint16_t hostScanCount = 0;
+
+void radioScan(RadioScanPoint *points, uint16_t freq, uint16_t step, uint16_t count, bool fm)
+{
+  uint16_t curFreq = rx.getFrequency();
+
+  for(hostScanCount = 0 ; hostScanCount < count ; hostScanCount++, freq += step)
+  {
+    rx.setFrequency(freq);
+    rx.getCurrentReceivedSignalQuality();
+    points[hostScanCount].rssi = rx.getCurrentRSSI();
+    points[hostScanCount].snr  = rx.getCurrentSNR();
+  }
+
+  rx.setFrequency(curFreq);
+}
+
+void radioScanStop() {}
+bool radioPilot() { return(rx.getCurrentPilot()); }
+
+void radioGetStatus(RadioStatus *status)
+{
+  memset(status, 0, sizeof(*status));
+  rx.getCurrentReceivedSignalQuality();
+  status->rssi  = rx.getCurrentRSSI();
+  status->snr   = rx.getCurrentSNR();
+  status->pilot = rx.getCurrentPilot();
+  status->scanCount = hostScanCount;
+}
+
+// Scheduler.cpp, scenarios set up the state they draw directly
+uint8_t schedAdd(SchedJob job, uint32_t period, bool start, uint8_t phase) { return(SCHED_MAX_JOBS); }
+void schedStart(uint8_t id, uint32_t delay) {}
+void schedStop(uint8_t id) {}
+
+// Cpu.cpp, the host runs at whatever speed it has
+void cpuBoost(uint16_t mhz, uint32_t hold) {}
+
+// Bank.cpp, memory slots are drawn from memories[]
+void bankSyncMemories() {}
+
+// Heap.cpp, the host never runs low
+bool heapIsLow() { return(false); }
+const HeapSample *heapGetSample(uint8_t idx) { return(NULL); }
+
+// Arena.cpp, the host has plenty of heap
+void *arenaAlloc(uint8_t region, size_t size) { return(calloc(1, size)); }
+
+// Network.cpp
+int8_t getWiFiStatus() { return(hostWiFiStatus); }
+char *getWiFiIPAddress() { static char ip[] = "10.1.1.1"; return(ip); }
+void netInit(uint8_t netMode, bool showStatus) {}
+void netStop() {}
+bool ntpIsAvailable() { return(false); }
+bool ntpSyncTime() { return(false); }
+void netRequestConnect() {}
+bool netTickTime() { return(false); }
+
+// Ble.cpp
+int8_t getBleStatus() { return(hostBleStatus); }
+void bleInit(uint8_t bleMode) {}
+void bleStop() {}
+void bleRequestInit() {}
+void bleTickTime() {}
+
+// EIBI.cpp
+bool eibiAvailable() { return(false); }
+bool eibiLoadSchedule() { return(false); }
+const StationSchedule *eibiLookup(uint16_t freq, uint8_t hour, uint8_t minute, size_t *offset) { return(0); }
+const StationSchedule *eibiPrev(uint16_t freq, uint8_t hour, uint8_t minute, size_t *offset) { return(0); }
+const StationSchedule *eibiNext(uint16_t freq, uint8_t hour, uint8_t minute, size_t *offset) { return(0); }
+const StationSchedule *eibiAtSameFreq(uint8_t hour, uint8_t minute, size_t *offset, bool same) { return(0); }
+
+// Storage.cpp
+void prefsRequestSave(uint32_t what, bool now) {}
+bool prefsAreWritten() { return(hostPrefsWritten); }
+
+// About.cpp
+void drawAbout() {}
+void drawAboutHelp(uint8_t arrow) {}
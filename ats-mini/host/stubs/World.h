@@ -0,0 +1,12 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <stdint.h>
+
+// Simulated device state, set by the scenarios before rendering
+extern int8_t hostWiFiStatus;
+extern int8_t hostBleStatus;
+extern bool hostPrefsWritten;
+extern uint16_t hostBatteryAdc;
+
+#endif // WORLD_H
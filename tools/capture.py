@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+"""
+Capture a screenshot from the ATS Mini receiver and save it as a PNG file.
+
+The receiver answers the `c` serial command with a binary, run-length
+compressed image (see remoteCaptureScreenBinary() in ats-mini/Remote.cpp):
+
+    16 bytes  header: "ATSC", version, format, width, height, payload length
+     N bytes  payload: RLE packets of big-endian RGB565 pixels
+     4 bytes  CRC32 of the payload
+
+All multi-byte header and trailer fields are little-endian. Screen mirror
+updates (see mirror.py) use the same framing with an "ATSM" magic.
+
+Usage:
+    capture.py /dev/ttyACM0 screenshot.png    # needs pyserial
+    capture.py capture.bin screenshot.png     # decode a saved capture
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+import zlib
+
+MAGIC = b"ATSC"
+VERSION = 1
+FORMAT_RLE565 = 1
+MIRROR_MAGIC = b"ATSM"
+HEADER = struct.Struct("<4sBBHHIH")
+
+
+class CaptureError(Exception):
+    pass
+
+
+def read_exact(read, size, what):
+    data = b""
+    while len(data) < size:
+        chunk = read(size - len(data))
+        if not chunk:
+            raise CaptureError(f"Timed out reading {what}")
+        data += chunk
+    return data
+
+
+def read_capture(read, magic=MAGIC):
+    """Find the capture header in the input stream and read the capture"""
+    window = b""
+    while window != magic:
+        byte = read(1)
+        if not byte:
+            raise CaptureError("No capture header found")
+        window = (window + byte)[-len(magic):]
+
+    rest = read_exact(read, HEADER.size - len(magic), "header")
+    _, version, fmt, width, height, length, extra = HEADER.unpack(magic + rest)
+    if version != VERSION or fmt != FORMAT_RLE565:
+        raise CaptureError(f"Unsupported capture version {version} format {fmt}")
+
+    payload = read_exact(read, length, "pixels")
+    (crc,) = struct.unpack("<I", read_exact(read, 4, "CRC"))
+    if zlib.crc32(payload) != crc:
+        raise CaptureError("CRC mismatch, capture is corrupted")
+
+    if magic == MAGIC:
+        return width, height, payload
+    return width, height, payload, extra & 0xFF, extra >> 8
+
+
+def decode_packets(payload, pos, count):
+    """Expand RLE packets at pos into count big-endian RGB565 pixels"""
+    out = bytearray()
+    while len(out) < count * 2:
+        if pos >= len(payload):
+            raise CaptureError(f"Decoded {len(out) // 2} pixels, expected {count}")
+        ctl = payload[pos]
+        pos += 1
+        if ctl & 0x80:
+            out += payload[pos:pos + 2] * ((ctl & 0x7F) + 1)
+            pos += 2
+        else:
+            size = (ctl + 1) * 2
+            out += payload[pos:pos + size]
+            pos += size
+
+    if len(out) != count * 2:
+        raise CaptureError("RLE packet crosses the image boundary")
+    return bytes(out), pos
+
+
+def decode_rle565(payload, width, height):
+    """Expand RLE packets into big-endian RGB565 pixels"""
+    pixels, pos = decode_packets(payload, 0, width * height)
+    if pos != len(payload):
+        raise CaptureError("Extra data after the image")
+    return pixels
+
+
+def rgb565_to_rgb888(pixels):
+    """Convert big-endian RGB565 pixels to RGB888"""
+    out = bytearray()
+    for i in range(0, len(pixels), 2):
+        p = (pixels[i] << 8) | pixels[i + 1]
+        r, g, b = (p >> 11) & 0x1F, (p >> 5) & 0x3F, p & 0x1F
+        out += bytes(((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)))
+    return out
+
+
+def rgb565_to_png(pixels, width, height):
+    """Convert big-endian RGB565 pixels to a PNG image"""
+    rgb = rgb565_to_rgb888(pixels)
+    rows = bytearray()
+    for y in range(height):
+        rows.append(0)  # No filter
+        rows += rgb[y * width * 3:(y + 1) * width * 3]
+
+    def chunk(kind, data):
+        body = kind + data
+        return struct.pack(">I", len(data)) + body + struct.pack(">I", zlib.crc32(body))
+
+    return (
+        b"\x89PNG\r\n\x1a\n"
+        + chunk(b"IHDR", struct.pack(">IIBBBBB", width, height, 8, 2, 0, 0, 0))
+        + chunk(b"IDAT", zlib.compress(bytes(rows), 9))
+        + chunk(b"IEND", b"")
+    )
+
+
+def capture_serial(port, baud, timeout):
+    try:
+        import serial
+    except ImportError:
+        raise CaptureError("pyserial is required to talk to the receiver: pip install pyserial")
+
+    with serial.Serial(port, baud, timeout=timeout) as ser:
+        ser.reset_input_buffer()
+        ser.write(b"c")
+        start = time.monotonic()
+        result = read_capture(ser.read)
+        print(f"Captured in {time.monotonic() - start:.2f}s", file=sys.stderr)
+        return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Capture ATS Mini screen to a PNG file")
+    parser.add_argument("source", help="serial port, or a file with a saved capture")
+    parser.add_argument("output", help="output PNG file")
+    parser.add_argument("-b", "--baud", type=int, default=115200, help="serial speed (default: 115200)")
+    parser.add_argument("-t", "--timeout", type=float, default=5, help="read timeout in seconds (default: 5)")
+    args = parser.parse_args()
+
+    try:
+        if os.path.isfile(args.source):
+            with open(args.source, "rb") as f:
+                width, height, payload = read_capture(f.read)
+        else:
+            width, height, payload = capture_serial(args.source, args.baud, args.timeout)
+
+        pixels = decode_rle565(payload, width, height)
+    except CaptureError as e:
+        sys.exit(f"Error: {e}")
+
+    with open(args.output, "wb") as f:
+        f.write(rgb565_to_png(pixels, width, height))
+    print(f"{width}x{height} image, {len(payload)} bytes compressed, saved to {args.output}", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
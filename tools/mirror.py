@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+"""
+Show a live mirror of the ATS Mini receiver screen.
+
+Sends the `D<fps>,<bytes>` serial command and applies the screen updates
+the receiver sends back. Each update has the same framing as a capture
+(see capture.py) with an "ATSM" magic and the tile size in the last two
+header bytes. Its payload is a sequence of tiles, each one a tile number
+followed by the RLE packets of its pixels. Only tiles that changed since
+the previous update are sent, and at most <bytes> bytes per update, so
+the picture catches up over a few updates on slow links.
+
+Usage:
+    mirror.py /dev/ttyACM0                 # show a window, needs pyserial
+    mirror.py /dev/ttyACM0 -o mirror.png   # keep updating a PNG file
+    mirror.py recording.bin -o mirror.png  # replay a saved stream
+"""
+
+import argparse
+import os
+import queue
+import sys
+import threading
+
+from capture import MIRROR_MAGIC, CaptureError, decode_packets, read_capture, rgb565_to_png, rgb565_to_rgb888
+
+
+class Mirror:
+    def __init__(self):
+        self.width = self.height = 0
+        self.pixels = bytearray()
+
+    def apply(self, update):
+        """Apply a screen update, returns the number of changed tiles"""
+        width, height, payload, tile_w, tile_h = update
+        if (width, height) != (self.width, self.height):
+            self.width, self.height = width, height
+            self.pixels = bytearray(width * height * 2)
+
+        tiles_x = width // tile_w
+        pos = tiles = 0
+        while pos < len(payload):
+            tile = payload[pos]
+            tile_pixels, pos = decode_packets(payload, pos + 1, tile_w * tile_h)
+            x0, y0 = (tile % tiles_x) * tile_w, (tile // tiles_x) * tile_h
+            for y in range(tile_h):
+                dst = ((y0 + y) * width + x0) * 2
+                self.pixels[dst:dst + tile_w * 2] = tile_pixels[y * tile_w * 2:(y + 1) * tile_w * 2]
+            tiles += 1
+        return tiles
+
+    def ppm(self):
+        header = f"P6 {self.width} {self.height} 255\n".encode()
+        return header + rgb565_to_rgb888(self.pixels)
+
+    def png(self):
+        return rgb565_to_png(self.pixels, self.width, self.height)
+
+
+def read_updates(read, updates, stop):
+    """Read screen updates until the input ends or stop is set"""
+    while not stop.is_set():
+        try:
+            updates.put(read_capture(read, MIRROR_MAGIC))
+        except CaptureError as e:
+            updates.put(e)
+            return
+
+
+def show_window(mirror, updates, scale):
+    import tkinter as tk
+
+    root = tk.Tk()
+    root.title("ATS Mini")
+    label = tk.Label(root)
+    label.pack()
+
+    def poll():
+        changed = False
+        while not updates.empty():
+            update = updates.get()
+            if isinstance(update, CaptureError):
+                print(f"Error: {update}", file=sys.stderr)
+                root.destroy()
+                return
+            changed |= mirror.apply(update) > 0
+        if changed:
+            image = tk.PhotoImage(data=mirror.ppm(), format="PPM")
+            label.image = image.zoom(scale) if scale > 1 else image
+            label.configure(image=label.image)
+        root.after(10, poll)
+
+    poll()
+    root.mainloop()
+
+
+def write_png(mirror, updates, output):
+    while True:
+        update = updates.get()
+        if isinstance(update, CaptureError):
+            return
+        tiles = mirror.apply(update)
+        with open(output + ".tmp", "wb") as f:
+            f.write(mirror.png())
+        os.replace(output + ".tmp", output)
+        print(f"Updated {tiles} tiles", file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Mirror ATS Mini screen")
+    parser.add_argument("source", help="serial port, or a file with a saved mirror stream")
+    parser.add_argument("-o", "--output", help="write PNG file instead of showing a window")
+    parser.add_argument("-f", "--fps", type=int, default=10, help="updates per second, up to 30 (default: 10)")
+    parser.add_argument("-B", "--budget", type=int, default=4096, help="maximal bytes per update (default: 4096)")
+    parser.add_argument("-b", "--baud", type=int, default=115200, help="serial speed (default: 115200)")
+    parser.add_argument("-s", "--scale", type=int, default=2, help="window zoom factor (default: 2)")
+    args = parser.parse_args()
+
+    mirror = Mirror()
+    updates = queue.Queue()
+    stop = threading.Event()
+
+    if os.path.isfile(args.source):
+        source = open(args.source, "rb")
+        read = source.read
+    else:
+        try:
+            import serial
+        except ImportError:
+            sys.exit("Error: pyserial is required to talk to the receiver: pip install pyserial")
+        source = serial.Serial(args.source, args.baud, timeout=1)
+        source.reset_input_buffer()
+        source.write(f"D{args.fps},{args.budget}\r".encode())
+
+        # Screen may not change for a while, keep waiting
+        def read(size):
+            data = b""
+            while not data and not stop.is_set():
+                data = source.read(size)
+            return data
+
+    reader = threading.Thread(target=read_updates, args=(read, updates, stop), daemon=True)
+    reader.start()
+
+    try:
+        if args.output:
+            write_png(mirror, updates, args.output)
+        else:
+            show_window(mirror, updates, args.scale)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        stop.set()
+        if not os.path.isfile(args.source):
+            source.write(b"d")
+        source.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""
+Dump the function trace from the ATS Mini receiver and convert it to the
+Chrome trace JSON format, viewable at https://ui.perfetto.dev or in
+chrome://tracing.
+
+The firmware must be built with the TRACE option. It answers the `X`
+serial command with a text dump (see traceDump() in ats-mini/Trace.cpp):
+
+    TRACE <count>
+    <time us>,<core>,<type>,<name>,<arg>    (count lines, oldest first)
+    END
+
+where type is B (function entered), E (function left) or i (instant).
+The firmware clears the trace after dumping it.
+
+Usage:
+    trace.py /dev/ttyACM0 trace.json    # needs pyserial
+    trace.py trace.txt trace.json       # convert a saved dump
+"""
+
+import argparse
+import json
+import os
+import sys
+
+
+class TraceError(Exception):
+    pass
+
+
+def parse_dump(lines):
+    """Parse dump lines into (time, core, type, name, arg) tuples"""
+    lines = iter(lines)
+    for line in lines:
+        if line.startswith("TRACE "):
+            break
+    else:
+        raise TraceError("No trace header found")
+
+    events = []
+    for line in lines:
+        if line == "END":
+            return events
+        if line.startswith("Tracing disabled"):
+            raise TraceError(line)
+        try:
+            time, core, kind, name, arg = line.split(",")
+            events.append((int(time), int(core), kind, name, int(arg)))
+        except ValueError:
+            raise TraceError(f"Malformed trace line: {line!r}")
+
+    raise TraceError("Trace dump is truncated")
+
+
+def to_chrome(events):
+    """Convert events to Chrome trace JSON, unwrapping the 32-bit us timer"""
+    result = []
+    base = events[0][0] if events else 0
+    last = 0
+    wraps = 0
+
+    for time, core, kind, name, arg in events:
+        ts = (time - base) & 0xFFFFFFFF
+        # Events from two cores may be slightly out of order
+        if last - ts > 0x80000000:
+            wraps += 1
+        last = ts
+        event = {
+            "name": name,
+            "ph": kind,
+            "ts": ts + (wraps << 32),
+            "pid": 0,
+            "tid": core,
+            "args": {"arg": arg},
+        }
+        if kind == "i":
+            event["s"] = "t"
+        result.append(event)
+
+    return {"traceEvents": result, "displayTimeUnit": "ms"}
+
+
+def dump_serial(port, baud, timeout):
+    try:
+        import serial
+    except ImportError:
+        raise TraceError("pyserial is required to talk to the receiver: pip install pyserial")
+
+    with serial.Serial(port, baud, timeout=timeout) as ser:
+        ser.reset_input_buffer()
+        ser.write(b"X")
+        lines = []
+        while not lines or lines[-1] not in ("END", ""):
+            lines.append(ser.readline().decode("ascii", "replace").strip())
+            if lines[-1].startswith("Tracing disabled"):
+                break
+        return lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert ATS Mini function trace to Chrome trace JSON")
+    parser.add_argument("source", help="serial port, or a file with a saved dump")
+    parser.add_argument("output", help="output JSON file")
+    parser.add_argument("-b", "--baud", type=int, default=115200, help="serial speed (default: 115200)")
+    parser.add_argument("-t", "--timeout", type=float, default=5, help="read timeout in seconds (default: 5)")
+    args = parser.parse_args()
+
+    try:
+        if os.path.isfile(args.source):
+            with open(args.source) as f:
+                lines = [line.strip() for line in f]
+        else:
+            lines = dump_serial(args.source, args.baud, args.timeout)
+
+        events = parse_dump(lines)
+    except TraceError as e:
+        sys.exit(f"Error: {e}")
+
+    with open(args.output, "w") as f:
+        json.dump(to_chrome(events), f)
+    print(f"{len(events)} events saved to {args.output}", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()